@@ -36,6 +36,7 @@
  */
 
 char uio_sysfs_dir[PDA_STRING_LIMIT];
+bool pda_fork_protection = false;
 
 #include <sys/utsname.h>
 #include <inttypes.h>
@@ -203,6 +204,16 @@ PDAInit()
     RETURN(PDA_SUCCESS);
 }
 
+PdaDebugReturnCode
+PDASetForkProtection(bool enable)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    __atomic_store_n(&pda_fork_protection, enable, __ATOMIC_RELAXED);
+
+    RETURN(PDA_SUCCESS);
+}
+
 PdaDebugReturnCode
 PDAFinalize()
 {
@@ -39,23 +39,69 @@
 
 #include <sys/sysinfo.h>
 #include <sys/file.h>
+#include <pthread.h>
+
+#ifdef NUMA_AVAIL
+    #include <numa.h>
+#endif /* NUMA_AVAIL */
+
+#ifndef MAP_HUGE_SHIFT
+    #define MAP_HUGE_SHIFT 26
+#endif
+
+/** Windows mapped by DMABuffer_mapWindows, unmapped at the latest when the buffer is freed */
+typedef struct DMABufferWindow_struct DMABufferWindow;
+
+struct DMABufferWindow_struct
+{
+    void            *map;
+    size_t           size;
+    DMABufferWindow *next;
+};
 
 struct DMABufferInternal_struct
 {
+    DMABufferWindow *windows;
     int  alloc_fd;
     int  map_fd;
     int  sg_fd;
-    char name[PDA_STRING_LIMIT];
-    char uio_filepath_request[PDA_STRING_LIMIT];
-    char uio_filepath_delete[PDA_STRING_LIMIT];
-    char uio_filepath_map[PDA_STRING_LIMIT];
-    char uio_filepath_sg[PDA_STRING_LIMIT];
-    char uio_filepath_folder[PDA_STRING_LIMIT];
+    bool owns_map;
+    bool imported;
+    bool dont_fork;
+    /** dma directory of the device, shared by all its buffers (see DMABuffer_path) */
+    const char *dma_path;
 };
 
 
 #define PAGE_SIZE sysconf(_SC_PAGESIZE)
 
+/** Kernel side name of a buffer, its index as decimal number */
+#define DMA_BUFFER_NAME_SIZE 21
+
+static inline void
+DMABuffer_name
+(
+    const DMABuffer *buffer,
+    char            *name
+)
+{ snprintf(name, DMA_BUFFER_NAME_SIZE, "%" PRIu64, buffer->index); }
+
+
+
+/** Path of a file in the sysfs directory of the buffer, built on demand */
+static inline void
+DMABuffer_path
+(
+    const DMABuffer *buffer,
+    const char      *file,
+    char            *path
+)
+{
+    snprintf(path, PDA_STRING_LIMIT, "%s/%" PRIu64 "/%s",
+             buffer->internal->dma_path, buffer->index, file);
+}
+
+
 PdaDebugReturnCode
 DMABuffer_get_ids
 (
@@ -95,14 +141,116 @@ DMABuffer_exists
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
+    char folder_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "", folder_path);
+
     struct stat fstat;
-    if(stat(buffer->internal->uio_filepath_folder, &fstat) != 0)
+    if(stat(folder_path, &fstat) != 0)
     { return(false); }
 
     RETURN(true);
 }
 
 
+static inline int
+DMABuffer_mmapFlags(const DMABuffer *buffer)
+{
+    return( MAP_SHARED | ( (buffer->flags & PDA_BUFFER_POPULATE) ? MAP_POPULATE : 0 ) );
+}
+
+
+
+/** Set by PDASetForkProtection */
+static inline bool
+DMABuffer_isForkProtected(void)
+{
+    return( __atomic_load_n(&pda_fork_protection, __ATOMIC_RELAXED) );
+}
+
+
+
+/** Keep a mapping out of child processes, if fork protection is enabled */
+static inline PdaDebugReturnCode
+DMABuffer_protectFromFork
+(
+    void         *map,
+    const size_t  length
+)
+{
+    if(!DMABuffer_isForkProtected() )
+    { return(PDA_SUCCESS); }
+
+    uintptr_t page  = (uintptr_t)PAGE_SIZE;
+    uintptr_t start = (uintptr_t)map & ~(page - 1);
+    uintptr_t end   = ((uintptr_t)map + length + page - 1) & ~(page - 1);
+
+    return( (madvise( (void*)start, end - start, MADV_DONTFORK) == 0) ? PDA_SUCCESS : errno );
+}
+
+
+
+/** Hand a mapping protected by DMABuffer_protectFromFork back to child processes */
+static inline void
+DMABuffer_unprotectFromFork
+(
+    void         *map,
+    const size_t  length
+)
+{
+    uintptr_t page  = (uintptr_t)PAGE_SIZE;
+    uintptr_t start = (uintptr_t)map & ~(page - 1);
+    uintptr_t end   = ((uintptr_t)map + length + page - 1) & ~(page - 1);
+
+    if(madvise( (void*)start, end - start, MADV_DOFORK) != 0)
+    { DEBUG_PRINTF(PDADEBUG_ERROR, "madvise() failed!\n"); }
+}
+
+
+
+static inline uint32_t
+DMABuffer_requestFlags(const DMABuffer *buffer)
+{
+    switch(buffer->flags & PDA_BUFFER_MAP_MASK)
+    {
+        case PDA_BUFFER_MAP_CACHED          : { return(UIO_PCI_DMA_MAP_CACHED); }
+        case PDA_BUFFER_MAP_WRITE_COMBINING : { return(UIO_PCI_DMA_MAP_WC); }
+        default                             : { return(UIO_PCI_DMA_MAP_UNCACHED); }
+    }
+}
+
+
+
+/** The mapping mode is chosen on allocation, buffers which are looked up take it from the adapter */
+static void
+DMABuffer_readMapMode(DMABuffer *buffer)
+{
+    char flags_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "flags", flags_path);
+
+    int fd = open(flags_path, O_RDONLY);
+    if(fd == -1)
+    {
+        DEBUG_PRINTF(PDADEBUG_ERROR, "Can't read mapping mode (%s)!\n", flags_path);
+        return;
+    }
+
+    uint32_t flags = 0;
+    if(pread(fd, &flags, sizeof(uint32_t), 0) == sizeof(uint32_t))
+    {
+        uint64_t mode = PDA_BUFFER_MAP_UNCACHED;
+        switch(flags & UIO_PCI_DMA_MAP_MASK)
+        {
+            case UIO_PCI_DMA_MAP_CACHED : { mode = PDA_BUFFER_MAP_CACHED; } break;
+            case UIO_PCI_DMA_MAP_WC     : { mode = PDA_BUFFER_MAP_WRITE_COMBINING; } break;
+        }
+        buffer->flags = (buffer->flags & ~(uint64_t)PDA_BUFFER_MAP_MASK) | mode;
+    }
+
+    close(fd);
+}
+
+
+
 PdaDebugReturnCode
 DMABuffer_map
 (
@@ -114,13 +262,16 @@ DMABuffer_map
 
     buffer->internal->map_fd = -1;
 
+    char map_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "map", map_path);
+
     /* Open the mapping file */
     buffer->internal->map_fd =
-        pda_spinOpen(buffer->internal->uio_filepath_map, O_RDWR, (mode_t)0600,  PDA_OPEN_DEFAULT_SPIN);
+        pda_spinOpen(map_path, O_RDWR, (mode_t)0600,  PDA_OPEN_DEFAULT_SPIN);
     if(buffer->internal->map_fd == -1)
     {
         ERROR_EXIT( errno, exit, "File open() failed! (%s)\n",
-                    buffer->internal->uio_filepath_map );
+                    map_path );
     }
 
     if(flock(buffer->internal->map_fd, LOCK_SH|LOCK_NB) == -1)
@@ -128,22 +279,35 @@ DMABuffer_map
 
     /* Check the file size of the mapping */
     struct stat fstat;
-    if(stat(buffer->internal->uio_filepath_map, &fstat) != 0)
+    if(stat(map_path, &fstat) != 0)
     {
         ERROR_EXIT( errno, exit_fd, "File stat() failed! (%s)\n",
-                    buffer->internal->uio_filepath_map );
+                    map_path );
     }
 
     /* Map the allocated DMA memory */
+    uint64_t start = DMABuffer_timeNs();
     buffer->map =
-        mmap(0, fstat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        mmap(0, fstat.st_size, PROT_READ | PROT_WRITE, DMABuffer_mmapFlags(buffer),
              buffer->internal->map_fd, 0);
 
     if(buffer->map == MAP_FAILED)
     { ERROR_EXIT( errno, exit_fd, "mmap() failed!\n" );}
 
+    if(DMABuffer_protectFromFork(buffer->map, fstat.st_size) != PDA_SUCCESS)
+    {
+        munmap(buffer->map, fstat.st_size);
+        buffer->map = MAP_FAILED;
+        ERROR_EXIT( errno, exit_fd, "madvise() failed!\n" );
+    }
+
+    if(buffer->flags & PDA_BUFFER_POPULATE)
+    { buffer->populate_time = DMABuffer_timeNs() - start; }
+
     buffer->length = fstat.st_size;
 
+    DMABuffer_readMapMode(buffer);
+
     RETURN(PDA_SUCCESS);
 
 exit_fd:
@@ -180,18 +344,237 @@ DMABuffer_mapUser
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
+    char map_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "map", map_path);
+
     buffer->map = start;
     buffer->internal->map_fd
-        = pda_spinOpen(buffer->internal->uio_filepath_map,
+        = pda_spinOpen(map_path,
             O_RDWR, (mode_t) 0600, PDA_OPEN_DEFAULT_SPIN);
     if (buffer->internal->map_fd == -1)
-    {RETURN(ERROR(errno, "File open() failed! (%s)\n", buffer->internal->uio_filepath_map));}
+    {RETURN(ERROR(errno, "File open() failed! (%s)\n", map_path));}
 
     RETURN(PDA_SUCCESS);
 }
 
 
 
+/** The coalesced sg-list of a buffer is cached in a shared memory segment, so
+ *  that processes which attach later don't have to reload and coalesce it.
+ *  The segment is validated against the generation number of the kernel
+ *  buffer, which changes whenever a buffer is allocated again. */
+#define DMA_BUFFER_SG_CACHE_MAGIC 0x5044414347434143ULL
+
+typedef struct DMABufferSGCache_struct
+{
+    uint64_t magic;
+    uint64_t generation;
+    uint64_t length;
+    uint64_t entries;
+} DMABufferSGCache;
+
+typedef struct DMABufferSGCacheEntry_struct
+{
+    uint64_t offset;
+    uint64_t length;
+    uint64_t bus;
+    uint64_t kernel;
+} DMABufferSGCacheEntry;
+
+
+
+static void
+DMABuffer_sgCacheName
+(
+    const uint16_t  domain_id,
+    const uint8_t   bus_id,
+    const uint8_t   device_id,
+    const uint8_t   function_id,
+    const uint64_t  index,
+    char           *name
+)
+{
+    snprintf(name, PDA_STRING_LIMIT, "/pda_sg_%04x_%02x_%02x_%x_%" PRIu64,
+             domain_id, bus_id, device_id, function_id, index);
+}
+
+
+
+static uint64_t
+DMABuffer_readGeneration(DMABuffer *buffer)
+{
+    char generation_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "generation", generation_path);
+
+    /** Older kernel adapters don't expose a generation, caching is disabled then */
+    int fd = open(generation_path, O_RDONLY);
+    if(fd == -1)
+    { return(0); }
+
+    uint64_t generation = 0;
+    if(pread(fd, &generation, sizeof(uint64_t), 0) != sizeof(uint64_t))
+    { generation = 0; }
+
+    close(fd);
+    return(generation);
+}
+
+
+
+static PdaDebugReturnCode
+DMABuffer_loadCachedSGList
+(
+    DMABuffer      *buffer,
+    const char     *name,
+    const uint64_t  generation
+)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd == -1)
+    { return(ENOENT); }
+
+    /** Bus addresses are only taken from segments which no one else could have written */
+    struct stat cache_stat;
+    void *cache_map = MAP_FAILED;
+    if( (fstat(fd, &cache_stat) == 0) &&
+        (cache_stat.st_uid == geteuid()) &&
+        ((cache_stat.st_mode & (S_IWGRP | S_IWOTH)) == 0) &&
+        (cache_stat.st_size >= (off_t)sizeof(DMABufferSGCache)) )
+    { cache_map = mmap(0, cache_stat.st_size, PROT_READ, MAP_SHARED, fd, 0); }
+    close(fd);
+
+    if(cache_map == MAP_FAILED)
+    { return(ENOENT); }
+
+    PdaDebugReturnCode ret = ENOENT;
+
+    /** The generation is written last, a segment which is still being filled never matches */
+    DMABufferSGCache      *header  = cache_map;
+    DMABufferSGCacheEntry *entries = (DMABufferSGCacheEntry*)(header + 1);
+    if
+    (
+        (header->magic != DMA_BUFFER_SG_CACHE_MAGIC) ||
+        (__atomic_load_n(&header->generation, __ATOMIC_ACQUIRE) != generation)
+    )
+    { goto exit; }
+
+    uint64_t number = header->entries;
+    if
+    (
+        (header->length != buffer->length) ||
+        (number == 0) ||
+        (number > ( (cache_stat.st_size - sizeof(DMABufferSGCache)) / sizeof(DMABufferSGCacheEntry) ) )
+    )
+    { goto exit; }
+
+    /** Every entry has to lie inside the buffer and together they have to cover it */
+    uint64_t covered = 0;
+    for(uint64_t i = 0; i < number; i++)
+    {
+        if( (entries[i].length > buffer->length) ||
+            (entries[i].offset > (buffer->length - entries[i].length)) )
+        { goto exit; }
+
+        covered += entries[i].length;
+        if(covered > buffer->length)
+        { goto exit; }
+    }
+
+    if(covered != buffer->length)
+    { goto exit; }
+
+    buffer->sglist = calloc(number, sizeof(DMABuffer_SGNode) );
+    if(buffer->sglist != NULL)
+    {
+        for(uint64_t i = 0; i < number; i++)
+        {
+            buffer->sglist[i].u_pointer = buffer->map + entries[i].offset;
+            buffer->sglist[i].d_pointer = (void*)entries[i].bus;
+            buffer->sglist[i].k_pointer = (void*)entries[i].kernel;
+            buffer->sglist[i].length    = entries[i].length;
+            buffer->sglist[i].prev      = (i == 0)            ? NULL : &buffer->sglist[i - 1];
+            buffer->sglist[i].next      = (i == (number - 1)) ? NULL : &buffer->sglist[i + 1];
+        }
+        ret = PDA_SUCCESS;
+    }
+
+exit:
+    munmap(cache_map, cache_stat.st_size);
+    return(ret);
+}
+
+
+
+static void
+DMABuffer_storeCachedSGList
+(
+    DMABuffer      *buffer,
+    const char     *name,
+    const uint64_t  generation
+)
+{
+    uint64_t number = 0;
+    for(DMABuffer_SGNode *sgtmp = buffer->sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    { number++; }
+
+    /** A stale segment is replaced, processes which still map it keep the old copy */
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, (mode_t)0600);
+    if(fd == -1)
+    { return; }
+
+    size_t size = sizeof(DMABufferSGCache) + (number * sizeof(DMABufferSGCacheEntry) );
+    void *cache_map = MAP_FAILED;
+    if(ftruncate(fd, size) == 0)
+    { cache_map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0); }
+    close(fd);
+
+    if(cache_map == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return;
+    }
+
+    DMABufferSGCache      *header  = cache_map;
+    DMABufferSGCacheEntry *entries = (DMABufferSGCacheEntry*)(header + 1);
+
+    uint64_t i = 0;
+    for(DMABuffer_SGNode *sgtmp = buffer->sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    {
+        entries[i].offset = (uint64_t)(sgtmp->u_pointer - buffer->map);
+        entries[i].length = sgtmp->length;
+        entries[i].bus    = (uint64_t)sgtmp->d_pointer;
+        entries[i].kernel = (uint64_t)sgtmp->k_pointer;
+        i++;
+    }
+
+    header->magic   = DMA_BUFFER_SG_CACHE_MAGIC;
+    header->length  = buffer->length;
+    header->entries = number;
+    __atomic_store_n(&header->generation, generation, __ATOMIC_RELEASE);
+
+    munmap(cache_map, size);
+}
+
+
+
+static void
+DMABuffer_dropCachedSGList(DMABuffer *buffer)
+{
+    uint16_t domain_id;
+    uint8_t  bus_id, device_id, function_id;
+    if( (buffer->device == NULL) ||
+        (DMABuffer_get_ids(buffer->device, &domain_id, &bus_id,
+            &device_id, &function_id) != PDA_SUCCESS) )
+    { return; }
+
+    char name[PDA_STRING_LIMIT];
+    DMABuffer_sgCacheName(domain_id, bus_id, device_id, function_id, buffer->index, name);
+    shm_unlink(name);
+}
+
+
+
 PdaDebugReturnCode
 DMABuffer_loadSGList
 (
@@ -217,22 +600,28 @@ DMABuffer_loadSGList
     )
     { ERROR_EXIT( errno, exit, "Lookup failed!\n" ); }
 
-    snprintf(buffer->internal->uio_filepath_sg, PDA_STRING_LIMIT,
-             "%s/"UIO_PATH_FORMAT"/dma/%s/sg",
-             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id,
-             buffer->internal->name);
+    /** A reconnect only needs the cached list, if it belongs to the current allocation */
+    char     cache_name[PDA_STRING_LIMIT];
+    uint64_t generation = DMABuffer_readGeneration(buffer);
+    DMABuffer_sgCacheName(domain_id, bus_id, device_id, function_id, buffer->index, cache_name);
+    if( (generation != 0) &&
+        (DMABuffer_loadCachedSGList(buffer, cache_name, generation) == PDA_SUCCESS) )
+    { RETURN(PDA_SUCCESS); }
+
+    char sg_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "sg", sg_path);
 
     /* Open sg-list file and map the kernel space list */
     buffer->internal->sg_fd =
-        pda_spinOpen(buffer->internal->uio_filepath_sg, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+        pda_spinOpen(sg_path, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
     if(buffer->internal->sg_fd == -1)
     {
         ERROR_EXIT( errno, exit, "File open() failed! (%s)\n",
-                    buffer->internal->uio_filepath_sg);
+                    sg_path);
     }
 
     struct stat fstat;
-    if( stat(buffer->internal->uio_filepath_sg, &fstat) != 0 )
+    if( stat(sg_path, &fstat) != 0 )
     { ERROR_EXIT( errno, exit, "Stat failed!\n" ); }
 
     struct scatter *sg_map =
@@ -280,7 +669,13 @@ DMABuffer_loadSGList
     /**
      *  Coalesce the sg-list to reduce the amount of memory needed on the device.
      */
-    RETURN( DMABuffer_coalesqueSGlist(&(buffer->sglist) ) );
+    if(DMABuffer_coalesqueSGlist(&(buffer->sglist) ) != PDA_SUCCESS)
+    { ERROR_EXIT( errno, exit, "Coalescing failed!\n" ); }
+
+    if(generation != 0)
+    { DMABuffer_storeCachedSGList(buffer, cache_name, generation); }
+
+    RETURN(PDA_SUCCESS);
 
 exit_map:
 
@@ -352,41 +747,53 @@ exit:
 
 
 PdaDebugReturnCode
-DMABuffer_generatePaths
+DMABuffer_getDMAPath
 (
-    DMABuffer *buffer,
-    PciDevice *device
+    PciDevice   *device,
+    const char **dma_path
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-    snprintf(buffer->internal->name, PDA_STRING_LIMIT, "%" PRIu64, buffer->index);
+    *dma_path = PciDevice_getDMAPath(device);
+    if(*dma_path == NULL)
+    { RETURN(EINVAL); }
 
-    uint16_t domain_id;
-    uint8_t  bus_id, device_id, function_id;
-    if( DMABuffer_get_ids(
-            device, &domain_id, &bus_id,
-                &device_id, &function_id) != PDA_SUCCESS )
-    { ERROR_EXIT( errno, exit, "Lookup failed!\n" ); }
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+void
+DMABuffer_setPaths
+(
+    DMABuffer  *buffer,
+    const char *dma_path
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    buffer->internal->dma_path = dma_path;
+
+    DEBUG_PRINTF(PDADEBUG_EXIT, "");
+}
 
 
-    snprintf(buffer->internal->uio_filepath_request, PDA_STRING_LIMIT,
-             "%s/"UIO_PATH_FORMAT"/dma/request",
-             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id);
 
-    snprintf(buffer->internal->uio_filepath_delete, PDA_STRING_LIMIT,
-             "%s/"UIO_PATH_FORMAT"/dma/free",
-             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id);
+PdaDebugReturnCode
+DMABuffer_generatePaths
+(
+    DMABuffer *buffer,
+    PciDevice *device
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-    snprintf(buffer->internal->uio_filepath_map, PDA_STRING_LIMIT,
-             "%s/"UIO_PATH_FORMAT"/dma/%s/map",
-             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id,
-             buffer->internal->name);
+    const char *dma_path = NULL;
+    if(DMABuffer_getDMAPath(device, &dma_path) != PDA_SUCCESS)
+    { ERROR_EXIT( errno, exit, "Lookup failed!\n" ); }
 
-    snprintf(buffer->internal->uio_filepath_folder, PDA_STRING_LIMIT,
-             "%s/"UIO_PATH_FORMAT"/dma/%s/",
-             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id,
-             buffer->internal->name);
+    DMABuffer_setPaths(buffer, dma_path);
 
     RETURN(PDA_SUCCESS);
 
@@ -408,8 +815,6 @@ DMABuffer_findNewIndex
 
     if(*dma_buffer_list != NULL)
     {
-        uint64_t current_index = 0;
-
         for
         (
              DMABuffer
@@ -418,10 +823,8 @@ DMABuffer_findNewIndex
              for_buffer  = for_buffer->next
         )
         {
-            sscanf(for_buffer->internal->name, "%" PRIu64, &current_index);
-
-            if( current_index > index )
-            { index = current_index; }
+            if( for_buffer->index > index )
+            { index = for_buffer->index; }
         }
 
         index++;
@@ -447,6 +850,17 @@ DMABuffer_lockUserBuffer
     if(mlock(start, buffer->length) != 0)
     { RETURN(ERROR( errno, "Buffer locking failed!\n")); }
 
+    /** Otherwise a write after fork() would copy the pinned pages away from the device */
+    if(DMABuffer_isForkProtected() )
+    {
+        if(DMABuffer_protectFromFork(start, buffer->length) != PDA_SUCCESS)
+        {
+            munlock(start, buffer->length);
+            RETURN(ERROR( errno, "Buffer fork protection failed!\n"));
+        }
+        buffer->internal->dont_fork = true;
+    }
+
     RETURN(PDA_SUCCESS);
 }
 
@@ -462,11 +876,12 @@ DMABuffer_isEnoughMemoryAvailable(const size_t length)
 
 
 PdaDebugReturnCode
-DMABuffer_requestMemory
+DMABuffer_writeRequest
 (
     PciDevice *device,
     DMABuffer *buffer,
-    void      *start
+    void      *start,
+    int        request_fd
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
@@ -476,6 +891,7 @@ DMABuffer_requestMemory
     {
         .size      = buffer->length,
         .start     = (uint64_t)start,
+        .flags     = DMABuffer_requestFlags(buffer),
         .name      = "",
         #ifdef NUMA_AVAIL
         .numa_node = PciDevice_getNumaNode(device)
@@ -484,12 +900,37 @@ DMABuffer_requestMemory
         #endif /* NUMA_AVAIL */
     };
 
-    snprintf(request.name, UIO_PCI_DMA_BUFFER_NAME_SIZE, "%s", buffer->internal->name);
+    DMABuffer_name(buffer, request.name);
+
+    /** The request file is a binary attribute, so every request has to start at offset 0 */
+    if(pwrite(request_fd, &request, sizeof(struct uio_pci_dma_private), 0) <= 0)
+    {
+        DEBUG_PRINTF( PDADEBUG_ERROR, "File writing failed!\n");
+        RETURN(errno);
+    }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_requestMemory
+(
+    PciDevice *device,
+    DMABuffer *buffer,
+    void      *start
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    char request_path[PDA_STRING_LIMIT];
+    snprintf(request_path, PDA_STRING_LIMIT, "%s/request", buffer->internal->dma_path);
 
     buffer->internal->alloc_fd =
         pda_spinOpen
         (
-            buffer->internal->uio_filepath_request,
+            request_path,
             O_WRONLY,
             (mode_t)0600,
             PDA_OPEN_DEFAULT_SPIN
@@ -497,19 +938,16 @@ DMABuffer_requestMemory
 
     if(buffer->internal->alloc_fd != -1)
     {
-        if (write(buffer->internal->alloc_fd, &request, sizeof(struct uio_pci_dma_private)) <= 0)
-        {
-            DEBUG_PRINTF( PDADEBUG_ERROR, "File writing failed!\n");
-            RETURN(errno);
-        }
+        PdaDebugReturnCode ret =
+            DMABuffer_writeRequest(device, buffer, start, buffer->internal->alloc_fd);
 
         close(buffer->internal->alloc_fd);
         buffer->internal->alloc_fd = -1;
 
-        RETURN(PDA_SUCCESS);
+        RETURN(ret);
     }
 
-    DEBUG_PRINTF( PDADEBUG_ERROR, "Opening file failed (%s)!\n", buffer->internal->uio_filepath_request);
+    DEBUG_PRINTF( PDADEBUG_ERROR, "Opening file failed (%s)!\n", request_path);
     RETURN(errno);
 }
 
@@ -523,7 +961,8 @@ DMABuffer_new
     const uint64_t       index,
     void                *start,
     const size_t         length,
-    pda_buffer_type      buffer_type
+    pda_buffer_type      buffer_type,
+    const uint64_t       flags
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
@@ -534,6 +973,7 @@ DMABuffer_new
     { ERROR_EXIT( ENOMEM, exit, "Struct allocation failed!\n" ); }
 
     buffer->type    = buffer_type;
+    buffer->flags   = flags;
     buffer->index   = DMABuffer_findNewIndex(index, dma_buffer_list);
     buffer->sglist  = NULL;
     buffer->device  = device;
@@ -576,14 +1016,17 @@ DMABuffer_new
             if( ((long unsigned int)start)%PAGE_SIZE != 0 )
             { ERROR_EXIT( EINVAL, exit, "Input buffer is not page aligned!\n" ); }
 
+            /** User memory is cached, a second mapping through the adapter must match */
+            buffer->flags = (flags & ~(uint64_t)PDA_BUFFER_MAP_MASK) | PDA_BUFFER_MAP_CACHED;
+
             if(DMABuffer_generatePaths(buffer, device) != PDA_SUCCESS)
             { ERROR_EXIT( errno, exit, "Buffer registration generate paths failed!\n" ); }
             if(DMABuffer_lockUserBuffer(start, buffer) != PDA_SUCCESS)
             { ERROR_EXIT( errno, exit, "Buffer registration lock buffer failed!\n" ); }
             if(DMABuffer_requestMemory(device, buffer, start) != PDA_SUCCESS)
-            { ERROR_EXIT( errno, exit, "Buffer registration request memory failed!\n" ); }
+            { ERROR_EXIT( errno, exit_unlock, "Buffer registration request memory failed!\n" ); }
             if(DMABuffer_mapUser(buffer, start) != PDA_SUCCESS)
-            { ERROR_EXIT( errno, exit, "Buffer registration map failed!\n" ); }
+            { ERROR_EXIT( errno, exit_unlock, "Buffer registration map failed!\n" ); }
         }
         break;
 
@@ -595,10 +1038,37 @@ DMABuffer_new
     if(ret != PDA_SUCCESS)
     { ERROR_EXIT( errno, exit, "Buffer allocation/registration failed!\n" ); }
 
+    /** Only new allocations are cleared, looked up buffers keep their data */
+    if( (buffer_type == PDA_BUFFER_KERNEL) && (flags & PDA_BUFFER_ZERO) )
+    {
+        if(DMABuffer_clear(buffer, 0) != PDA_SUCCESS)
+        {
+            if(DMABuffer_free(buffer, PDA_DELETE) != PDA_SUCCESS)
+            { DEBUG_PRINTF(PDADEBUG_ERROR, "Freeing the uncleared buffer failed!\n"); }
+            RETURN( ERROR(EFAULT, "Clearing the buffer failed!\n") );
+        }
+    }
+    /** User buffers are locked and therefore resident already */
+    else if( (buffer->type == PDA_BUFFER_KERNEL) && (flags & PDA_BUFFER_POPULATE_PARALLEL) )
+    {
+        if(DMABuffer_populate(buffer, 0) != PDA_SUCCESS)
+        { DEBUG_PRINTF(PDADEBUG_ERROR, "Populating the mapping failed, continuing unpopulated!\n"); }
+    }
+
     DMABuffer_addNode(dma_buffer_list, buffer);
 
     RETURN(PDA_SUCCESS);
 
+exit_unlock:
+    {
+        /** The user memory is handed back the way it was passed in */
+        int error = errno;
+        if(buffer->internal->dont_fork)
+        { DMABuffer_unprotectFromFork(start, buffer->length); }
+        munlock(start, buffer->length);
+        errno = error;
+    }
+
 exit:
     if(buffer != NULL)
     {
@@ -614,6 +1084,55 @@ exit:
 
 
 
+PdaDebugReturnCode
+DMABuffer_newHugeUser
+(
+    PciDevice         *device,
+    DMABuffer        **dma_buffer_list,
+    const uint64_t     index,
+    const size_t       length,
+    const size_t       page_size
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    /** 0 selects 2MB pages */
+    size_t huge_page_size = (page_size == 0) ? (2 * 1024 * 1024) : page_size;
+    if( ((huge_page_size & (huge_page_size - 1)) != 0) || (huge_page_size < PAGE_SIZE) )
+    { RETURN( ERROR(EINVAL, "Invalid hugepage size!\n") ); }
+
+    int huge_flags = MAP_HUGETLB | (__builtin_ctzll(huge_page_size) << MAP_HUGE_SHIFT);
+
+    size_t map_length = ( (length + huge_page_size - 1) / huge_page_size) * huge_page_size;
+
+    void *start =
+        mmap(NULL, map_length, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | huge_flags, -1, 0);
+    if(start == MAP_FAILED)
+    { RETURN( ERROR(errno, "Hugepage mmap() failed (are hugepages reserved?)!\n") ); }
+
+    #ifdef NUMA_AVAIL
+    int32_t numa_node = PciDevice_getNumaNode(device);
+    if( (numa_available() != -1) && (numa_node >= 0) )
+    { numa_tonode_memory(start, map_length, numa_node); }
+    #endif /* NUMA_AVAIL */
+
+    if(DMABuffer_new(device, dma_buffer_list, index, start, map_length, PDA_BUFFER_USER,
+                     PDA_BUFFER_FLAGS_NONE)
+        != PDA_SUCCESS)
+    {
+        munmap(start, map_length);
+        RETURN( ERROR(EINVAL, "Hugepage buffer registration failed!\n") );
+    }
+
+    /** The mapping is owned by the library and released in DMABuffer_free */
+    DMABuffer_getTail(*dma_buffer_list)->internal->owns_map = true;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
 PdaDebugReturnCode
 DMABuffer_delete_not_attached_buffers(PciDevice *device)
 {
@@ -691,120 +1210,165 @@ exit:
 
 
 
-DMABuffer*
-DMABuffer_check_persistant(PciDevice *device)
+/** Work description for the parallel rediscovery of persistent buffers */
+typedef struct DMABufferRediscover_struct
 {
-    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+    PciDevice   *device;
+    const char  *dma_path;
+    uint64_t    *ids;
+    DMABuffer  **buffers;
+    uint64_t     count;
+    uint64_t     next;
+} DMABufferRediscover;
 
-    /** Get the related UIO-Directory */
-    uint16_t domain_id;
-    uint8_t  bus_id, device_id, function_id;
-    if
-    (
-        DMABuffer_get_ids(
-            device, &domain_id, &bus_id,
-                &device_id, &function_id) != PDA_SUCCESS
-    )
-    { ERROR_EXIT( errno, exit, "Lookup failed!\n" ); }
 
-    char uio_file_path[PDA_STRING_LIMIT];
-    memset(uio_file_path, 0, PDA_STRING_LIMIT);
-    snprintf(uio_file_path, PDA_STRING_LIMIT, "%s/"UIO_PATH_FORMAT"/dma/",
-            UIO_BAR_PATH, domain_id, bus_id, device_id, function_id);
 
-    /** Return pointer */
-    DMABuffer *head   = NULL;
-    DMABuffer *buffer = NULL;
+static void
+DMABuffer_rediscoverWorker
+(
+    void           *context,
+    const uint64_t  thread,
+    const uint64_t  threads
+)
+{
+    DMABufferRediscover *work = (DMABufferRediscover*)context;
 
-    /** Iterate over all directories inside the dma directory */
-    DIR *directory = NULL;
-    directory      = opendir(uio_file_path);
-    if(directory == NULL)
+    /** Entries are handed out one by one, because the buffer sizes can differ a lot */
+    for
+    (
+        uint64_t i  = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED);
+        i           < work->count;
+        i           = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED)
+    )
     {
-        ERROR_EXIT( errno, exit, "Unable to open UIO sysfs DMA directory (%s)!\n",
-                    uio_file_path );
-    }
-    struct dirent *directory_entry = NULL;
+        DMABuffer *buffer = NULL;
+        if(DMABuffer_alloc(&buffer, 0, work->device) != PDA_SUCCESS)
+        { continue; }
 
-    while(NULL != (directory_entry = readdir(directory) ) )
-    {
-        if
-        (
-            (directory_entry->d_type == DT_DIR)          &&
-            (strcmp(directory_entry->d_name, "." ) != 0) &&
-            (strcmp(directory_entry->d_name, "..") != 0)
-        )
+        buffer->type               = PDA_BUFFER_KERNEL;
+        buffer->index              = work->ids[i];
+        buffer->internal->alloc_fd = -1;
+        buffer->internal->map_fd   = -1;
+        buffer->internal->sg_fd    = -1;
+        DMABuffer_setPaths(buffer, work->dma_path);
+
+        /** The sg-list is loaded lazily by DMABuffer_getSGList */
+        if(DMABuffer_map(buffer, work->device) != PDA_SUCCESS)
         {
-            DEBUG_PRINTF(PDADEBUG_VALUE, "Rediscover entry : %s\n",
-                         directory_entry->d_name);
+            DEBUG_PRINTF(PDADEBUG_ERROR, "Rediscovering buffer %" PRIu64 " failed!\n",
+                         work->ids[i]);
+            free(buffer->internal);
+            free(buffer);
+            continue;
+        }
+
+        work->buffers[i] = buffer;
+    }
+}
+
+
+
+static int
+DMABuffer_compareIndex(const void *a, const void *b)
+{
+    uint64_t index_a = *(const uint64_t*)a;
+    uint64_t index_b = *(const uint64_t*)b;
+    return( (index_a > index_b) - (index_a < index_b) );
+}
+
 
-            /** Allocate object datastructure */
-            char mapping_file_path[PDA_STRING_LIMIT];
-            snprintf(mapping_file_path, PDA_STRING_LIMIT, "%s/%s/map",
-                     uio_file_path, directory_entry->d_name);
 
-            struct stat fstat;
-            if( stat(mapping_file_path, &fstat) == -1 )
-            { ERROR_EXIT( errno, exit, "stat mapping file failed\n" ); }
+PdaDebugReturnCode
+DMABuffer_check_persistant
+(
+    PciDevice  *device,
+    DMABuffer **dma_buffer_list
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-            if
-            ( DMABuffer_alloc(&buffer, fstat.st_size, device) != PDA_SUCCESS )
-            { ERROR_EXIT( ENOMEM, exit, "Base memory allocation failed!\n" ); }
+    DMABufferRediscover work =
+    {
+        .device   = device,
+        .dma_path = NULL,
+        .ids      = NULL,
+        .buffers  = NULL,
+        .count    = 0,
+        .next     = 0
+    };
 
-            snprintf(buffer->internal->name, PDA_STRING_LIMIT, "%s",
-                     directory_entry->d_name);
+    if(DMABuffer_getDMAPath(device, &work.dma_path) != PDA_SUCCESS)
+    { ERROR_EXIT( errno, exit, "Lookup failed!\n" ); }
 
-            buffer->index = 0;
-            sscanf(directory_entry->d_name, "%" PRIu64, &(buffer->index) );
+    /** Get all persistent buffers and skip the ones which are already attached */
+    uint64_t *all_ids = NULL;
+    uint64_t  number  = PciDevice_getListOfBuffers(device, &all_ids);
+    if(number == 0)
+    { RETURN(PDA_SUCCESS); }
 
-            /** Generate filepath' for allocation and deallocation */
-            if( DMABuffer_generatePaths(buffer, device) != PDA_SUCCESS )
-            { ERROR_EXIT( errno, exit, "Path generation failed!\n" ); }
+    work.ids     = calloc(number, sizeof(uint64_t) );
+    work.buffers = calloc(number, sizeof(DMABuffer*) );
+    if( (work.ids == NULL) || (work.buffers == NULL) )
+    { ERROR_EXIT( ENOMEM, exit, "Memory allocation failed!\n" ); }
 
-            /** Map buffer and read out the scatter gather list */
-            PdaDebugReturnCode ret  = DMABuffer_map(buffer, device);
-                               ret += DMABuffer_loadSGList(buffer, device);
-            if(ret != PDA_SUCCESS)
-            { ERROR_EXIT( errno, exit, "Map and sort failed!\n" ); }
+    memcpy(work.ids, all_ids, number * sizeof(uint64_t) );
+    qsort(work.ids, number, sizeof(uint64_t), DMABuffer_compareIndex);
 
-            DMABuffer_addNode(&head, buffer);
+    for(DMABuffer *tmp = *dma_buffer_list; tmp != NULL; tmp = tmp->next)
+    {
+        uint64_t *found =
+            bsearch(&tmp->index, work.ids, number, sizeof(uint64_t), DMABuffer_compareIndex);
+        if(found != NULL)
+        { *found = PDA_BUFFER_INDEX_UNDEFINED; }
+    }
 
-            buffer = NULL;
+    for(uint64_t i = 0; i < number; i++)
+    {
+        if(work.ids[i] != PDA_BUFFER_INDEX_UNDEFINED)
+        {
+            work.ids[work.count] = work.ids[i];
+            work.count++;
         }
     }
 
-    closedir(directory);
+    DEBUG_PRINTF(PDADEBUG_VALUE, "Rediscover %" PRIu64 " of %" PRIu64 " buffers\n",
+                 work.count, number);
 
-    #ifdef DEBUG
-    for
-    (
-        DMABuffer *tmp  = head;
-        tmp            != NULL;
-        tmp             = tmp->next
-    )
+    if(work.count > 0)
     {
-        uint64_t current_index = 0;
-        if( DMABuffer_getIndex(tmp, &current_index) != PDA_SUCCESS )
-        { DEBUG_PRINTF( PDADEBUG_ERROR, "Getting index failed!\n"); }
-        DEBUG_PRINTF(PDADEBUG_VALUE, "Buffer : %" PRIu64 "\n", current_index);
+        if(pda_parallelRun(pda_parallelThreads(0, work.count, -1), -1,
+                           DMABuffer_rediscoverWorker, &work) != PDA_SUCCESS)
+        { ERROR_EXIT( EFAULT, exit, "Parallel rediscovery failed!\n" ); }
     }
-    #endif
 
-    RETURN(head);
-
-exit:
-    if(buffer != NULL)
+    /** Attach in index order, so the list looks the same as after a serial walk */
+    uint64_t failed = 0;
+    for(uint64_t i = 0; i < work.count; i++)
     {
-        if(buffer->internal != NULL)
+        if(work.buffers[i] == NULL)
         {
-            free(buffer->internal);
-            buffer->internal = NULL;
+            failed++;
+            continue;
         }
-        free(buffer);
-        buffer = NULL;
+        DMABuffer_addNode(dma_buffer_list, work.buffers[i]);
     }
 
-    RETURN(NULL);
+    free(work.ids);
+    free(work.buffers);
+
+    if(failed != 0)
+    { RETURN( ERROR(EFAULT, "%" PRIu64 " buffers could not be rediscovered!\n", failed) ); }
+
+    RETURN(PDA_SUCCESS);
+
+exit:
+    if(work.ids != NULL)
+    { free(work.ids); }
+
+    if(work.buffers != NULL)
+    { free(work.buffers); }
+
+    RETURN(ERROR( errno, "Rediscovering persistent buffers failed!\n") );
 }
 
 
@@ -837,8 +1401,26 @@ DMABuffer_free
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer != NULL) && (buffer->type == PDA_BUFFER_SLICE) )
+    { RETURN( ERROR( EINVAL, "Slices are released by their owner!\n") ); }
+
+    if( (buffer != NULL) && (__atomic_load_n(&buffer->references, __ATOMIC_ACQUIRE) > 0) )
+    { RETURN( ERROR( EBUSY, "Buffer is still referenced by slices!\n") ); }
+
     if(buffer != NULL)
     {
+        if(buffer->internal != NULL)
+        {
+            while(buffer->internal->windows != NULL)
+            {
+                DMABufferWindow *window = buffer->internal->windows;
+                buffer->internal->windows = window->next;
+                munmap(window->map, window->size);
+                free(window);
+            }
+        }
+
         if(buffer->type == PDA_BUFFER_KERNEL)
         {
             if(buffer->map_two != MAP_FAILED)
@@ -862,6 +1444,13 @@ DMABuffer_free
                 buffer->map_two = MAP_FAILED;
             }
 
+            /** The memory belongs to the caller again */
+            if( (buffer->internal != NULL) && buffer->internal->dont_fork )
+            {
+                DMABuffer_unprotectFromFork(buffer->map, buffer->length);
+                buffer->internal->dont_fork = false;
+            }
+
             if(munlock(buffer->map, buffer->length) != 0)
             {
                 #ifdef PDA_SKIP_UNLOCK_FAILURE
@@ -874,26 +1463,44 @@ DMABuffer_free
                 #endif
             }
 
+            if( (buffer->internal != NULL) && buffer->internal->owns_map )
+            {
+                munmap(buffer->map, buffer->length);
+                buffer->internal->owns_map = false;
+            }
+
             buffer->map = MAP_FAILED;
             persistant  = PDA_DELETE;
         }
 
+        /** Imported buffers are owned by the exporting process */
+        if( (buffer->internal != NULL) && buffer->internal->imported )
+        { persistant = PDA_DELETE_PERSISTANT; }
+
         /** Free the persistant buffer */
         if( (buffer->internal != NULL) && (persistant == PDA_DELETE) )
         {
             if(flock(buffer->internal->map_fd, LOCK_EX|LOCK_NB) == -1)
             { ERROR_EXIT( errno, exit_free,"Can't free buffer because it is mapped elsewhere!\n" ); }
 
+            DMABuffer_dropCachedSGList(buffer);
+
+            char free_path[PDA_STRING_LIMIT];
+            snprintf(free_path, PDA_STRING_LIMIT, "%s/free", buffer->internal->dma_path);
+
+            char name[DMA_BUFFER_NAME_SIZE];
+            DMABuffer_name(buffer, name);
+
             int free_fd =
-                pda_spinOpen(buffer->internal->uio_filepath_delete, O_WRONLY,
+                pda_spinOpen(free_path, O_WRONLY,
                     (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
             if(free_fd > -1)
             {
                 DMABuffer_closeFiles(buffer);
 
                 size_t ret =
-                    write(free_fd, buffer->internal->name,
-                          strlen(buffer->internal->name) + 1 );
+                    write(free_fd, name,
+                          strlen(name) + 1 );
 
                 close(free_fd);
                 free_fd = -1;
@@ -913,11 +1520,7 @@ DMABuffer_free
             buffer->internal = NULL;
         }
 
-        if(buffer->sglist != NULL)
-        {
-            free(buffer->sglist);
-            buffer->sglist = NULL;
-        }
+        DMABuffer_freeSGList(buffer);
 
         DMABuffer_removeNode(buffer);
         free(buffer);
@@ -936,11 +1539,7 @@ exit_free:
         buffer->internal = NULL;
     }
 
-    if(buffer->sglist != NULL)
-    {
-        free(buffer->sglist);
-        buffer->sglist = NULL;
-    }
+    DMABuffer_freeSGList(buffer);
 
     DMABuffer_removeNode(buffer);
     free(buffer);
@@ -952,156 +1551,624 @@ exit:
 
 
 
+/** State shared between the request loop and the mapping thread of a batch allocation */
+typedef struct DMABufferBatch_struct
+{
+    PciDevice          *device;
+    DMABuffer         **buffers;
+    uint64_t            count;
+    uint64_t            requested;
+    uint64_t            mapped;
+    bool                aborted;
+    PdaDebugReturnCode  ret;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+} DMABufferBatch;
+
+
+
+static void*
+DMABuffer_batchMapThread(void *arg)
+{
+    DMABufferBatch *batch = (DMABufferBatch*)arg;
+
+    /** Map and load the sg-lists of all buffers which were already allocated by the kernel */
+    for(uint64_t i = 0; i < batch->count; i++)
+    {
+        pthread_mutex_lock(&batch->lock);
+        while( (batch->requested <= i) && !batch->aborted )
+        { pthread_cond_wait(&batch->cond, &batch->lock); }
+        bool stop = (batch->requested <= i);
+        pthread_mutex_unlock(&batch->lock);
+
+        if(stop)
+        { break; }
+
+        DMABuffer *buffer = batch->buffers[i];
+        if( (DMABuffer_map(buffer, batch->device) != PDA_SUCCESS) ||
+            (DMABuffer_loadSGList(buffer, batch->device) != PDA_SUCCESS) )
+        {
+            batch->ret = EFAULT;
+            break;
+        }
+
+        batch->mapped = i + 1;
+    }
+
+    return(NULL);
+}
+
+
+
+static inline void
+DMABuffer_batchRelease
+(
+    DMABufferBatch *batch,
+    int             free_fd
+)
+{
+    for(uint64_t i = 0; i < batch->count; i++)
+    {
+        DMABuffer *buffer = batch->buffers[i];
+        if(buffer == NULL)
+        { continue; }
+
+        if(i < batch->mapped)
+        {
+            if(DMABuffer_free(buffer, PDA_DELETE) != PDA_SUCCESS)
+            { DEBUG_PRINTF(PDADEBUG_ERROR, "Freeing buffer %" PRIu64 " failed!\n", i); }
+        }
+        else
+        {
+            /** Allocated by the kernel, but never mapped */
+            if( (i < batch->requested) && (free_fd != -1) )
+            {
+                char name[DMA_BUFFER_NAME_SIZE];
+                DMABuffer_name(buffer, name);
+                if(write(free_fd, name, strlen(name) + 1) == -1)
+                { DEBUG_PRINTF(PDADEBUG_ERROR, "Freeing buffer %" PRIu64 " failed!\n", i); }
+            }
+
+            if(buffer->map != MAP_FAILED)
+            { munmap(buffer->map, buffer->length); }
+
+            DMABuffer_freeSGList(buffer);
+            DMABuffer_closeFiles(buffer);
+            free(buffer->internal);
+            free(buffer);
+        }
+
+        batch->buffers[i] = NULL;
+    }
+}
+
+
+
 PdaDebugReturnCode
-DMABuffer_handleFailedKernelWrapMap(DMABuffer* buffer)
+DMABuffer_newBatch
+(
+    PciDevice         *device,
+    DMABuffer        **dma_buffer_list,
+    const uint64_t     first_index,
+    const uint64_t     count,
+    const size_t      *lengths,
+    DMABuffer        **buffers
+)
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-    if(buffer->map != MAP_FAILED)
-    { munmap(buffer->map, buffer->length); }
+    int       request_fd   = -1;
+    int       free_fd      = -1;
+    bool      thread_valid = false;
+    pthread_t thread;
 
-    if (buffer->map_two != MAP_FAILED)
-    { munmap(buffer->map_two, buffer->length); }
+    DMABufferBatch batch =
+    {
+        .device    = device,
+        .buffers   = buffers,
+        .count     = count,
+        .requested = 0,
+        .mapped    = 0,
+        .aborted   = false,
+        .ret       = PDA_SUCCESS
+    };
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.cond, NULL);
 
-    buffer->map = mmap(buffer->map, (buffer->length) * 2,
-            PROT_READ | PROT_WRITE, MAP_SHARED, buffer->internal->map_fd, 0);
+    for(uint64_t i = 0; i < count; i++)
+    { buffers[i] = NULL; }
 
-    buffer->map_two = buffer->map + buffer->length;
+    /** The path prefix and the control files are only looked up once */
+    const char *dma_path = NULL;
+    if(DMABuffer_getDMAPath(device, &dma_path) != PDA_SUCCESS)
+    { ERROR_EXIT( EINVAL, exit, "Lookup failed!\n" ); }
 
-    if(buffer->map == MAP_FAILED)
+    size_t total_length = 0;
+    for(uint64_t i = 0; i < count; i++)
     {
-        buffer->map = mmap(0, buffer->length, PROT_READ | PROT_WRITE,
-                MAP_SHARED, buffer->internal->map_fd, 0);
-        if(buffer->map == MAP_FAILED)
+        if(lengths[i] == 0)
+        { ERROR_EXIT( EINVAL, exit, "Invalid length!\n" ); }
+        total_length += lengths[i];
+    }
+
+    if( !DMABuffer_isEnoughMemoryAvailable(total_length) )
+    { ERROR_EXIT( ENOMEM, exit, "Not enough memory available for DMA memory allocation!\n" ); }
+
+    for(uint64_t i = 0; i < count; i++)
+    {
+        if(DMABuffer_alloc(&buffers[i], lengths[i], device) != PDA_SUCCESS)
+        { ERROR_EXIT( ENOMEM, exit, "Struct allocation failed!\n" ); }
+
+        buffers[i]->type              = PDA_BUFFER_KERNEL;
+        buffers[i]->index             = first_index + i;
+        buffers[i]->internal->alloc_fd = -1;
+        buffers[i]->internal->map_fd   = -1;
+        buffers[i]->internal->sg_fd    = -1;
+        DMABuffer_setPaths(buffers[i], dma_path);
+    }
+
+    char path[PDA_STRING_LIMIT];
+    snprintf(path, PDA_STRING_LIMIT, "%s/request", dma_path);
+    request_fd = pda_spinOpen(path, O_WRONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+    if(request_fd == -1)
+    { ERROR_EXIT( errno, exit, "Opening file failed (%s)!\n", path ); }
+
+    snprintf(path, PDA_STRING_LIMIT, "%s/free", dma_path);
+    free_fd = pda_spinOpen(path, O_WRONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+    if(free_fd == -1)
+    { ERROR_EXIT( errno, exit, "Opening file failed (%s)!\n", path ); }
+
+    /** Mapping and sg-list loading of finished buffers overlaps with the next requests */
+    if(pthread_create(&thread, NULL, DMABuffer_batchMapThread, &batch) != 0)
+    { ERROR_EXIT( errno, exit, "Thread creation failed!\n" ); }
+    thread_valid = true;
+
+    for(uint64_t i = 0; i < count; i++)
+    {
+        if(DMABuffer_writeRequest(device, buffers[i], NULL, request_fd) != PDA_SUCCESS)
+        { ERROR_EXIT( errno, exit, "Buffer request failed!\n" ); }
+
+        pthread_mutex_lock(&batch.lock);
+        batch.requested++;
+        pthread_cond_signal(&batch.cond);
+        pthread_mutex_unlock(&batch.lock);
+    }
+
+    pthread_join(thread, NULL);
+    thread_valid = false;
+
+    if( (batch.ret != PDA_SUCCESS) || (batch.mapped != count) )
+    { ERROR_EXIT( EFAULT, exit, "Buffer mapping failed!\n" ); }
+
+    close(request_fd);
+    close(free_fd);
+    pthread_cond_destroy(&batch.cond);
+    pthread_mutex_destroy(&batch.lock);
+
+    for(uint64_t i = 0; i < count; i++)
+    { DMABuffer_addNode(dma_buffer_list, buffers[i]); }
+
+    RETURN(PDA_SUCCESS);
+
+exit:
+    if(thread_valid)
+    {
+        pthread_mutex_lock(&batch.lock);
+        batch.aborted = true;
+        pthread_cond_broadcast(&batch.cond);
+        pthread_mutex_unlock(&batch.lock);
+        pthread_join(thread, NULL);
+    }
+
+    DMABuffer_batchRelease(&batch, free_fd);
+
+    if(request_fd != -1)
+    { close(request_fd); }
+
+    if(free_fd != -1)
+    { close(free_fd); }
+
+    pthread_cond_destroy(&batch.cond);
+    pthread_mutex_destroy(&batch.lock);
+
+    RETURN( ERROR( errno, "DMA buffer batch allocation failed!\n") );
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_exportFd
+(
+    const DMABuffer *buffer,
+    int             *fd
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (fd == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (buffer->type == PDA_BUFFER_SLICE) || (buffer->internal == NULL) )
+    { RETURN( ERROR(EINVAL, "Only allocated or registered buffers can be exported!\n") ); }
+
+    char dmabuf_path[PDA_STRING_LIMIT];
+    DMABuffer_path(buffer, "dmabuf", dmabuf_path);
+
+    int attribute_fd = open(dmabuf_path, O_RDONLY);
+    if(attribute_fd == -1)
+    { RETURN( ERROR(errno, "File open() failed! (%s)\n", dmabuf_path) ); }
+
+    /** Reading the attribute installs a new dma-buf descriptor in this process */
+    int32_t exported = -1;
+    ssize_t ret      = pread(attribute_fd, &exported, sizeof(int32_t), 0);
+    int     error    = errno;
+    close(attribute_fd);
+
+    if(ret != sizeof(int32_t))
+    { RETURN( ERROR( (ret < 0) ? error : EIO, "dma-buf export failed!\n") ); }
+
+    *fd = exported;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+/** The adapter names exported buffers "<PCI device>/<index>" (exp_name in the fdinfo),
+ *  descriptors which were exported by another device are rejected */
+static PdaDebugReturnCode
+DMABuffer_importedIndex
+(
+    PciDevice *device,
+    const int  fd,
+    uint64_t  *index
+)
+{
+    uint16_t domain_id;
+    uint8_t  bus_id, device_id, function_id;
+    if(DMABuffer_get_ids(device, &domain_id, &bus_id, &device_id, &function_id) != PDA_SUCCESS)
+    { return(EINVAL); }
+
+    char device_name[UIO_PCI_DMA_EXP_NAME_SIZE];
+    snprintf(device_name, UIO_PCI_DMA_EXP_NAME_SIZE, "%04x:%02x:%02x.%x",
+             domain_id, bus_id, device_id, function_id);
+
+    char fdinfo_path[PDA_STRING_LIMIT];
+    snprintf(fdinfo_path, PDA_STRING_LIMIT, "/proc/self/fdinfo/%d", fd);
+
+    FILE *fdinfo = fopen(fdinfo_path, "r");
+    if(fdinfo == NULL)
+    { return(errno); }
+
+    PdaDebugReturnCode ret = EINVAL;
+    char line[256];
+    char exporter[UIO_PCI_DMA_EXP_NAME_SIZE];
+    while(fgets(line, sizeof(line), fdinfo) != NULL)
+    {
+        if(sscanf(line, "exp_name: %159[^/]/%" SCNu64, exporter, index) == 2)
         {
-            buffer->map_two = NULL;
+            if(strcmp(exporter, device_name) == 0)
+            { ret = PDA_SUCCESS; }
+            break;
         }
-        RETURN(!PDA_SUCCESS);
     }
 
-    RETURN(PDA_SUCCESS);
+    fclose(fdinfo);
+    return(ret);
 }
 
+
+
 PdaDebugReturnCode
-kernelWrapMap
+DMABuffer_importFd
 (
-    DMABuffer *buffer,
-    uint8_t   *buffer_area
+    PciDevice  *device,
+    DMABuffer **dma_buffer_list,
+    const int   fd
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-    /** Unmap the old mapping */
-    if(buffer->map != MAP_FAILED)
+    uint64_t index = 0;
+    if(DMABuffer_importedIndex(device, fd, &index) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Descriptor is no dma-buf exported by PDA for this device!\n") ); }
+
+    for(DMABuffer *current = *dma_buffer_list; current != NULL; current = current->next)
     {
-        munmap(buffer->map, buffer->length);
-        buffer->map = MAP_FAILED;
+        if(current->index == index)
+        { RETURN( ERROR(EEXIST, "Buffer is already attached!\n") ); }
     }
 
-    /** Try to map the same buffer consecutively */
-    buffer->map     = buffer_area;
-    buffer->map_two = buffer_area + buffer->length;
+    off_t length = lseek(fd, 0, SEEK_END);
+    if(length <= 0)
+    { RETURN( ERROR(EINVAL, "Can't determine the dma-buf size!\n") ); }
+
+    DMABuffer *buffer = NULL;
+    if(DMABuffer_alloc(&buffer, (size_t)length, device) != PDA_SUCCESS)
+    { RETURN( ERROR(ENOMEM, "Struct allocation failed!\n") ); }
+
+    buffer->type                = PDA_BUFFER_KERNEL;
+    buffer->index               = index;
+    buffer->internal->imported  = true;
+    buffer->internal->alloc_fd  = -1;
+    buffer->internal->sg_fd     = -1;
+
+    /** Paths are only needed later on, if the sg-list is requested */
+    if(DMABuffer_generatePaths(buffer, device) != PDA_SUCCESS)
+    { ERROR_EXIT( EINVAL, exit, "Generating paths failed!\n" ); }
+
+    buffer->internal->map_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if(buffer->internal->map_fd == -1)
+    { ERROR_EXIT( errno, exit, "Duplicating the descriptor failed!\n" ); }
 
     buffer->map =
-        mmap(buffer->map, buffer->length, PROT_READ | PROT_WRITE,
-             MAP_SHARED, buffer->internal->map_fd, 0);
+        mmap(0, buffer->length, PROT_READ | PROT_WRITE, DMABuffer_mmapFlags(buffer),
+             buffer->internal->map_fd, 0);
+    if(buffer->map == MAP_FAILED)
+    { ERROR_EXIT( errno, exit_fd, "mmap() failed!\n" ); }
 
-    buffer->map_two =
-        mmap(buffer->map_two, buffer->length, PROT_READ | PROT_WRITE,
-             MAP_SHARED, buffer->internal->map_fd, 0);
+    if(DMABuffer_protectFromFork(buffer->map, buffer->length) != PDA_SUCCESS)
+    {
+        munmap(buffer->map, buffer->length);
+        ERROR_EXIT( errno, exit_fd, "madvise() failed!\n" );
+    }
 
+    DMABuffer_readMapMode(buffer);
 
-    if( (buffer->map == MAP_FAILED) || (buffer->map_two == MAP_FAILED) )
-    { ERROR_EXIT( errno, exit, "mmap() failed!\n" ); }
+    DMABuffer_addNode(dma_buffer_list, buffer);
 
-    if(buffer->map_two != (buffer->map + buffer->length))
-    { ERROR_EXIT( EINVAL, exit, "mmap() failed!\n" ); }
+    RETURN(PDA_SUCCESS);
 
-    RETURN( PDA_SUCCESS );
+exit_fd:
+    close(buffer->internal->map_fd);
 
 exit:
-    RETURN( DMABuffer_handleFailedKernelWrapMap(buffer) );
+    free(buffer->internal);
+    free(buffer);
+
+    RETURN( ERROR( errno, "DMA buffer import failed!\n") );
 }
 
 
-PdaDebugReturnCode
-userWrapMap
+
+/**
+ * Map n_copies copies of [offset, offset + length) of the buffer back to back.
+ * The whole range is reserved first and the copies replace it with MAP_FIXED,
+ * so that no other thread can get a part of the range in between.
+ */
+static PdaDebugReturnCode
+DMABuffer_mapCopies
 (
-    DMABuffer *buffer,
-    uint8_t   *buffer_area
+    DMABuffer      *buffer,
+    const uint64_t  n_copies,
+    const size_t    offset,
+    const size_t    length,
+    uint8_t       **area
 )
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
-    if(buffer->map == NULL)
-    { ERROR_EXIT( errno, exit, "Mapping is actually no mapping!\n" ); }
+    size_t   size     = n_copies * length;
+    uint8_t *reserved =
+        mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(reserved == MAP_FAILED)
+    { RETURN( ERROR(errno, "Address range reservation failed!\n") ); }
 
-    buffer->map =
-        mremap(buffer->map, buffer->length,
-               buffer->length, (MREMAP_FIXED | MREMAP_MAYMOVE), buffer_area);
+    for(uint64_t i = 0; i < n_copies; i++)
+    {
+        void *copy =
+            mmap(reserved + (i * length), length, PROT_READ | PROT_WRITE,
+                 DMABuffer_mmapFlags(buffer) | MAP_FIXED, buffer->internal->map_fd, offset);
+        if(copy == MAP_FAILED)
+        {
+            int error = errno;
+            munmap(reserved, size);
+            RETURN( ERROR(error, "mmap() failed!\n") );
+        }
+    }
 
-    buffer->map_two =
-        mmap
-        (
-            (buffer->map+buffer->length),
-            buffer->length,
-            PROT_READ | PROT_WRITE,
-            MAP_SHARED,
-            buffer->internal->map_fd,
-            0
-        );
+    if(DMABuffer_protectFromFork(reserved, size) != PDA_SUCCESS)
+    {
+        int error = errno;
+        munmap(reserved, size);
+        RETURN( ERROR(error, "madvise() failed!\n") );
+    }
+
+    *area = reserved;
+    RETURN(PDA_SUCCESS);
+}
 
-    if( (buffer->map == MAP_FAILED) || (buffer->map_two == MAP_FAILED) )
-    { ERROR_EXIT( errno, exit, "mmap() failed!\n" ); }
 
-    if(buffer->map_two != (buffer->map + buffer->length))
-    { ERROR_EXIT( errno, exit, "Aligning second mapping failed!\n" ); }
 
-    RETURN( PDA_SUCCESS );
+/** The sg-list points into the first mapping, move it along if the mapping moves */
+static void
+DMABuffer_rebaseSGList
+(
+    DMABuffer *buffer,
+    uint8_t   *old_map
+)
+{
+    for(DMABuffer_SGNode *sgtmp = buffer->sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    { sgtmp->u_pointer = (uint8_t*)buffer->map + ((uint8_t*)sgtmp->u_pointer - old_map); }
+}
 
-exit:
-    if(buffer->map_two != MAP_FAILED)
+
+
+static PdaDebugReturnCode
+DMABuffer_wrapMapUser
+(
+    DMABuffer *buffer,
+    uint8_t  **area
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    size_t   length   = buffer->length;
+    uint8_t *reserved =
+        mmap(0, 2 * length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(reserved == MAP_FAILED)
+    { RETURN( ERROR(errno, "Address range reservation failed!\n") ); }
+
+    /** The user memory itself is moved into the first half ... */
+    if(mremap(buffer->map, length, length, (MREMAP_FIXED | MREMAP_MAYMOVE), reserved) == MAP_FAILED)
     {
-        munmap(buffer->map_two, buffer->length);
-        buffer->map_two = MAP_FAILED;
+        int error = errno;
+        munmap(reserved, 2 * length);
+        RETURN( ERROR(error, "mremap() failed!\n") );
     }
 
-    RETURN( ERROR( EINVAL, "DMA buffer wrap mapping failed!\n") );
+    int error = PDA_SUCCESS;
+
+    /** ... and mapped a second time through the adapter behind it */
+    if
+    (
+        mmap(reserved + length, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             buffer->internal->map_fd, 0) == MAP_FAILED
+    )
+    {
+        error = errno;
+        ERROR_EXIT( error, exit, "mmap() failed!\n" );
+    }
+
+    /** The moved user memory keeps its advice, only the second half is new */
+    if(DMABuffer_protectFromFork(reserved + length, length) != PDA_SUCCESS)
+    {
+        error = errno;
+        ERROR_EXIT( error, exit, "madvise() failed!\n" );
+    }
+
+    *area = reserved;
+    RETURN(PDA_SUCCESS);
+
+exit:
+    if(mremap(reserved, length, length, (MREMAP_FIXED | MREMAP_MAYMOVE), buffer->map) == MAP_FAILED)
+    { ERROR(errno, "Moving the user memory back failed!\n"); }
+    munmap(reserved + length, length);
+    RETURN( ERROR(error, "Wrap mapping the user memory failed!\n") );
 }
 
+
+
 PdaDebugReturnCode
 DMABuffer_wrapMap(DMABuffer *buffer)
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
     if(buffer == NULL)
-    { ERROR_EXIT( errno, exit, "No buffer object given!\n" ); }
+    { ERROR_EXIT( EINVAL, exit, "No buffer object given!\n" ); }
 
-    if(buffer->type == PDA_BUFFER_KERNEL)
-    { RETURN(DMABuffer_handleFailedKernelWrapMap(buffer)); }
+    if(buffer->type == PDA_BUFFER_SLICE)
+    { ERROR_EXIT( EINVAL, exit, "Slices can't be wrap mapped!\n" ); }
 
-    /** Allocate a 2 times larger buffer to get mappable areas */
-    uint8_t *buffer_area = (uint8_t*)memalign(PAGE_SIZE, 2*buffer->length);
+    if(buffer->map_two != MAP_FAILED)
+    { RETURN(PDA_SUCCESS); }
 
-    if(buffer_area == NULL)
-    { ERROR_EXIT( errno, exit, "Base allocation failed\n" ); }
-    else
+    /** Slices point into the current mapping, which moves */
+    if(__atomic_load_n(&buffer->references, __ATOMIC_ACQUIRE) > 0)
+    { RETURN( ERROR( EBUSY, "Buffer is still referenced by slices!\n") ); }
+
+    uint8_t *old_map = buffer->map;
+    uint8_t *area    = NULL;
+
+    if(buffer->type == PDA_BUFFER_KERNEL)
     {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wuse-after-free"
-        uint8_t *buffer_area_tmp = buffer_area;
-        free(buffer_area);
-        buffer_area = buffer_area_tmp;
-#pragma GCC diagnostic pop
+        if(DMABuffer_mapCopies(buffer, 2, 0, buffer->length, &area) != PDA_SUCCESS)
+        { ERROR_EXIT( errno, exit, "Mapping the copies failed!\n" ); }
+        munmap(old_map, buffer->length);
     }
+    else if(buffer->type == PDA_BUFFER_USER)
+    {
+        if(DMABuffer_wrapMapUser(buffer, &area) != PDA_SUCCESS)
+        { ERROR_EXIT( errno, exit, "Mapping the copies failed!\n" ); }
+    }
+    else
+    { ERROR_EXIT( EINVAL, exit, "Unknown buffer type!\n" ); }
 
-    if(buffer->type == PDA_BUFFER_KERNEL)
-    { RETURN(kernelWrapMap(buffer, buffer_area)); }
+    buffer->map     = area;
+    buffer->map_two = area + buffer->length;
+    DMABuffer_rebaseSGList(buffer, old_map);
 
-    if(buffer->type == PDA_BUFFER_USER)
-    { RETURN(userWrapMap(buffer, buffer_area)); }
+    RETURN(PDA_SUCCESS);
 
 exit:
-    RETURN( ERROR( EINVAL, "DMA buffer overmapping failed!\n") );
+    RETURN( ERROR( errno, "DMA buffer overmapping failed!\n") );
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_mapWindows
+(
+    DMABuffer      *buffer,
+    const uint64_t  n_copies,
+    const size_t    offset,
+    const size_t    length,
+    void          **map
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (map == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    /** Windows of a slice are windows of the buffer it belongs to */
+    DMABuffer *owner = (buffer->type == PDA_BUFFER_SLICE) ? buffer->parent : buffer;
+    size_t     start = (buffer->type == PDA_BUFFER_SLICE) ? (buffer->offset + offset) : offset;
+
+    if( (n_copies == 0) || (length == 0) || (offset > buffer->length) ||
+        (length > (buffer->length - offset)) || (n_copies > (SIZE_MAX / length)) )
+    { RETURN( ERROR(EINVAL, "Invalid window!\n") ); }
+
+    if( ((start % PAGE_SIZE) != 0) || ((length % PAGE_SIZE) != 0) )
+    { RETURN( ERROR(EINVAL, "Windows have to be page aligned!\n") ); }
+
+    DMABufferWindow *window = calloc(1, sizeof(DMABufferWindow) );
+    if(window == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    uint8_t *area = NULL;
+    if(DMABuffer_mapCopies(owner, n_copies, start, length, &area) != PDA_SUCCESS)
+    {
+        free(window);
+        RETURN( ERROR(errno, "Window mapping failed!\n") );
+    }
+
+    window->map              = area;
+    window->size             = n_copies * length;
+    window->next             = owner->internal->windows;
+    owner->internal->windows = window;
+
+    *map = area;
+    RETURN(PDA_SUCCESS);
 }
 
+
+
+PdaDebugReturnCode
+DMABuffer_unmapWindows
+(
+    DMABuffer *buffer,
+    void      *map
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABuffer *owner = (buffer->type == PDA_BUFFER_SLICE) ? buffer->parent : buffer;
+
+    for(DMABufferWindow **window = &owner->internal->windows; *window != NULL; window = &(*window)->next)
+    {
+        if((*window)->map == map)
+        {
+            DMABufferWindow *found = *window;
+            *window = found->next;
+            munmap(found->map, found->size);
+            free(found);
+            RETURN(PDA_SUCCESS);
+        }
+    }
+
+    RETURN( ERROR(EINVAL, "No window at this address!\n") );
+}
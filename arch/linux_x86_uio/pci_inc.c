@@ -43,6 +43,8 @@
     #include <numa.h>
 #endif
 
+#include "uio_pci_dma.h"
+
 
 
 #define PCI_GET_FUNCTION( attr, name, type )                       \
@@ -65,17 +67,15 @@ PciDevice_get ## name                                              \
 
 
 
+/** Paths are allocated once, file names below them are built when needed */
 struct PciDeviceInternal_struct
 {
-    char uio_sysfs_entry[PDA_STRING_LIMIT];
-    char uio_sysfs_path[PDA_STRING_LIMIT];
-    char uio_device_filename[PDA_STRING_LIMIT];
-    char uio_config_filename[PDA_STRING_LIMIT];
-    char uio_mps_filename[PDA_STRING_LIMIT];
-    char uio_mrrs_filename[PDA_STRING_LIMIT];
-    int  uio_device_fd;
-    int  uio_config_fd;
-    int32_t numa_node;
+    char       *uio_sysfs_path;
+    const char *uio_sysfs_entry;
+    char       *dma_path;
+    int         uio_device_fd;
+    int         uio_config_fd;
+    int32_t     numa_node;
 };
 
 #ifdef NUMA_AVAIL
@@ -147,19 +147,20 @@ PciDevice_init_bars(PciDevice *device)
     { RETURN(PDA_SUCCESS); }
 
     /** Read configuration space header */
-    snprintf(workp.uio_config_filename, PDA_STRING_LIMIT, "%s/%s",
+    char uio_config_filename[PDA_STRING_LIMIT];
+    snprintf(uio_config_filename, PDA_STRING_LIMIT, "%s/%s",
              workp.uio_sysfs_path, "config");
 
     DEBUG_PRINTF(PDADEBUG_VALUE, "Device config space filename (RAW): %s\n",
-                 workp.uio_config_filename);
+                 uio_config_filename);
 
     workp.uio_config_fd =
-        pda_spinOpen(workp.uio_config_filename, O_RDWR, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+        pda_spinOpen(uio_config_filename, O_RDWR, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
     if( workp.uio_config_fd == -1)
-    { ERROR_EXIT( errno, exit, "Error opening a file %s!\n", workp.uio_config_filename); }
+    { ERROR_EXIT( errno, exit, "Error opening a file %s!\n", uio_config_filename); }
 
     if( 64 != read(workp.uio_config_fd, &device->config_space_buffer, 64) )
-    { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", workp.uio_config_filename); }
+    { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", uio_config_filename); }
 
     device->pci_config_header = (PciConfigSpaceHeader*)&device->config_space_buffer[0];
 
@@ -248,8 +249,23 @@ PciDevice_new_op
     if(device == NULL)
     { ERROR_EXIT( ENODEV, exit, "Memory allocation failed!\n" ); }
 
-    snprintf(workp.uio_sysfs_entry, PDA_STRING_LIMIT, "%s", uio_sysfs_entry);
-    snprintf(workp.uio_sysfs_path,  PDA_STRING_LIMIT, "%s/%s", uio_sysfs_dir, uio_sysfs_entry);
+    workp.uio_device_fd = -1;
+    workp.uio_config_fd = -1;
+
+    /** The entry is the last part of the sysfs path */
+    workp.uio_sysfs_path = strdup(file_path);
+    if(workp.uio_sysfs_path == NULL)
+    { ERROR_EXIT( ENOMEM, exit, "Memory allocation failed!\n" ); }
+    workp.uio_sysfs_entry = workp.uio_sysfs_path + strlen(uio_sysfs_dir) + 1;
+
+    /** Prefix of all buffer paths, see PciDevice_getDMAPath */
+    char dma_path[PDA_STRING_LIMIT];
+    snprintf(dma_path, PDA_STRING_LIMIT, "%s/"UIO_PATH_FORMAT"/dma",
+             UIO_BAR_PATH, domain_id, bus_id, device_id, function_id);
+    workp.dma_path = strdup(dma_path);
+    if(workp.dma_path == NULL)
+    { ERROR_EXIT( ENOMEM, exit, "Memory allocation failed!\n" ); }
+
     snprintf(device->vendor_str, PDA_STRING_LIMIT, "%s", vendor_str);
     snprintf(device->device_str, PDA_STRING_LIMIT, "%s", device_str);
 
@@ -258,9 +274,6 @@ PciDevice_new_op
     device->bar_init              = false;
     device->isr_init              = false;
 
-    workp.uio_device_fd           = -1;
-    workp.uio_config_fd           = -1;
-
     device->domain_id   = domain_id;
     device->bus_id      = bus_id;
     device->device_id   = device_id;
@@ -310,11 +323,29 @@ PciDevice_delete_dep
         workp.uio_config_fd = -1;
     }
 
+    free(workp.uio_sysfs_path);
+    workp.uio_sysfs_path  = NULL;
+    workp.uio_sysfs_entry = NULL;
+
+    free(workp.dma_path);
+    workp.dma_path = NULL;
+
     RETURN(PDA_SUCCESS);
 }
 
 
 
+const char*
+PciDevice_getDMAPath(const PciDevice *device)
+{
+    if( (device == NULL) || (device->internal == NULL) )
+    { return(NULL); }
+
+    return(workp.dma_path);
+}
+
+
+
 void*
 PciDevice_isr_thread
 (
@@ -366,6 +397,7 @@ PciDevice_isr_init
     { RETURN( ERROR(errno, "BAR initialization failed!\n")); }
 
     /** Find UIO device file */
+    char uio_device_filename[PDA_STRING_LIMIT] = "";
     char uio_device_file_dir[PDA_STRING_LIMIT];
     snprintf(uio_device_file_dir, PDA_STRING_LIMIT, "%s/%s/uio/",
              uio_sysfs_dir, workp.uio_sysfs_entry);
@@ -382,7 +414,7 @@ PciDevice_isr_init
         strncpy(prefix, directory_entry->d_name, 3);
         if(strcmp(prefix, "uio") == 0)
         {
-            snprintf(workp.uio_device_filename, PDA_STRING_LIMIT, "%s/%s",
+            snprintf(uio_device_filename, PDA_STRING_LIMIT, "%s/%s",
                      UIO_DEVFS_DIR, directory_entry->d_name);
             break;
         }
@@ -391,9 +423,9 @@ PciDevice_isr_init
 
     /** Open UIO device fd */
     workp.uio_device_fd =
-        pda_spinOpen(workp.uio_device_filename, O_RDWR, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+        pda_spinOpen(uio_device_filename, O_RDWR, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
     if(workp.uio_device_fd == -1)
-    { ERROR_EXIT( errno, exit, "Error opening a file %s!\n", workp.uio_device_filename); }
+    { ERROR_EXIT( errno, exit, "Error opening a file %s!\n", uio_device_filename); }
 
     device->isr_init = true;
     RETURN(PDA_SUCCESS);
@@ -496,14 +528,15 @@ PciDevice_getmaxPayloadSize
     {
         PciDevice *device_int = (PciDevice*)device;
         int sysfs_attr_fd;
-        snprintf(workp.uio_mps_filename, PDA_STRING_LIMIT, "%s/dma/max_payload_size", workp.uio_sysfs_path);
-        sysfs_attr_fd = pda_spinOpen(workp.uio_mps_filename, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+        char uio_mps_filename[PDA_STRING_LIMIT];
+        snprintf(uio_mps_filename, PDA_STRING_LIMIT, "%s/dma/max_payload_size", workp.uio_sysfs_path);
+        sysfs_attr_fd = pda_spinOpen(uio_mps_filename, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
         if(sysfs_attr_fd < 0)
-        { ERROR_EXIT( errno, exit, "File opening failed! (%s)\n", workp.uio_mps_filename); }
+        { ERROR_EXIT( errno, exit, "File opening failed! (%s)\n", uio_mps_filename); }
 
         int mps = 0;
         if( sizeof(int) != read(sysfs_attr_fd, &mps, sizeof(int)) )
-        { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", workp.uio_mps_filename); }
+        { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", uio_mps_filename); }
         device_int->max_payload_size = mps;
         DEBUG_PRINTF(PDADEBUG_VALUE, "Max Payload Size %d\n", device->max_payload_size);
         close(sysfs_attr_fd);
@@ -540,14 +573,15 @@ PciDevice_getmaxReadRequestSize
     {
         PciDevice *device_int = (PciDevice*)device;
         int sysfs_attr_fd;
-        snprintf(workp.uio_mrrs_filename, PDA_STRING_LIMIT, "%s/dma/max_read_request_size", workp.uio_sysfs_path);
-        sysfs_attr_fd = pda_spinOpen(workp.uio_mrrs_filename, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
+        char uio_mrrs_filename[PDA_STRING_LIMIT];
+        snprintf(uio_mrrs_filename, PDA_STRING_LIMIT, "%s/dma/max_read_request_size", workp.uio_sysfs_path);
+        sysfs_attr_fd = pda_spinOpen(uio_mrrs_filename, O_RDONLY, (mode_t)0600, PDA_OPEN_DEFAULT_SPIN);
         if(sysfs_attr_fd < 0)
-        { ERROR_EXIT( errno, exit, "File opening failed! (%s)\n", workp.uio_mrrs_filename); }
+        { ERROR_EXIT( errno, exit, "File opening failed! (%s)\n", uio_mrrs_filename); }
 
         int mrrs = 0;
         if( sizeof(int) != read(sysfs_attr_fd, &mrrs, sizeof(int)) )
-        { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", workp.uio_mrrs_filename); }
+        { ERROR_EXIT( errno, exit, "Error reading a file %s!\n", uio_mrrs_filename); }
         device_int->max_read_request_size = mrrs;
         DEBUG_PRINTF(PDADEBUG_VALUE, "Max Read Request Size %d\n", device->max_read_request_size);
         close(sysfs_attr_fd);
@@ -665,6 +699,144 @@ exit:
 
 
 
+/** Generation of the buffer list of the device, 0 if the kernel adapter has none */
+static inline uint64_t
+PciDevice_readGeneration
+(
+    PciDevice *device
+)
+{
+    char generation_path[PDA_STRING_LIMIT];
+    snprintf(generation_path, PDA_STRING_LIMIT, "%s/generation", workp.dma_path);
+
+    int fd = open(generation_path, O_RDONLY);
+    if(fd < 0)
+    { return(0); }
+
+    uint64_t generation = 0;
+    if(pread(fd, &generation, sizeof(uint64_t), 0) != sizeof(uint64_t))
+    { generation = 0; }
+
+    close(fd);
+    return(generation);
+}
+
+
+
+/** Size, sg-list length and NUMA node of a buffer, read from its sysfs folder */
+static inline PdaDebugReturnCode
+PciDevice_readBufferInfo
+(
+    PciDevice     *device,
+    const char    *name,
+    PdaBufferInfo *info
+)
+{
+    char        path[PDA_STRING_LIMIT];
+    struct stat file_stat;
+
+    /** The buffer may be freed in the meantime, the caller skips it then */
+    snprintf(path, PDA_STRING_LIMIT, "%s/%s/map", workp.dma_path, name);
+    if(stat(path, &file_stat) != 0)
+    { return(ENOENT); }
+    info->size = file_stat.st_size;
+
+    snprintf(path, PDA_STRING_LIMIT, "%s/%s/sg", workp.dma_path, name);
+    if(stat(path, &file_stat) != 0)
+    { return(ENOENT); }
+    info->sg_entries = file_stat.st_size / sizeof(struct scatter);
+
+    info->numa_node = -1;
+    snprintf(path, PDA_STRING_LIMIT, "%s/%s/numa_node", workp.dma_path, name);
+    int fd = open(path, O_RDONLY);
+    if(fd >= 0)
+    {
+        if(pread(fd, &info->numa_node, sizeof(int32_t), 0) != sizeof(int32_t))
+        { info->numa_node = -1; }
+        close(fd);
+    }
+
+    return(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_queryBuffers
+(
+    PciDevice      *device,
+    PdaBufferInfo  *infos,
+    const uint64_t  max,
+    uint64_t       *count,
+    uint64_t       *generation
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN(ERROR(EINVAL, "This is no valid device pointer!\n")); }
+
+    if( (count == NULL) || (generation == NULL) || ((infos == NULL) && (max != 0)) )
+    { RETURN(ERROR(EINVAL, "This is no valid target pointer!\n")); }
+
+    /** Read before scanning, a change during the scan shows up in the next call */
+    uint64_t current = PciDevice_readGeneration(device);
+    if( (current != 0) && (current == *generation) )
+    { RETURN(PDA_SUCCESS); }
+
+    DIR *directory = opendir(workp.dma_path);
+    if(directory == NULL)
+    { RETURN(ERROR(errno, "Unable to open UIO sysfs DMA directory (%s)!\n", workp.dma_path)); }
+
+    uint64_t       buffer_count    = 0;
+    struct dirent *directory_entry = NULL;
+    while(NULL != (directory_entry = readdir(directory) ) )
+    {
+        uint64_t index = 0;
+        if( (directory_entry->d_type != DT_DIR) ||
+            (sscanf(directory_entry->d_name, "%"SCNu64"", &index) != 1) )
+        { continue; }
+
+        if(buffer_count < max)
+        {
+            PdaBufferInfo *info = &infos[buffer_count];
+            if(PciDevice_readBufferInfo(device, directory_entry->d_name, info) != PDA_SUCCESS)
+            { continue; }
+
+            info->index    = index;
+            info->attached = 0;
+
+            PdaDebugReturnCode ret = PDA_SUCCESS;
+            for
+            (
+                DMABuffer *buffer  = device->dma_buffer_list;
+                (buffer != NULL) && (ret == PDA_SUCCESS);
+                ret                = DMABuffer_getNext(buffer, &buffer)
+            )
+            {
+                uint64_t buffer_index = 0;
+                if( (DMABuffer_getIndex(buffer, &buffer_index) == PDA_SUCCESS) &&
+                    (buffer_index == index) )
+                {
+                    info->attached = 1;
+                    break;
+                }
+            }
+        }
+
+        buffer_count++;
+    }
+
+    closedir(directory);
+
+    *count      = buffer_count;
+    *generation = (buffer_count > max) ? 0 : current;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
 PCI_GET_FUNCTION( domain_id, DomainID, uint16_t *domain_id );
 PCI_GET_FUNCTION( bus_id, BusID, uint8_t *bus_id );
 PCI_GET_FUNCTION( device_id, DeviceID, uint8_t *device_id );
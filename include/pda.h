@@ -41,6 +41,9 @@
 #include <pda/defines.h>
 #include <pda/device_operator.h>
 #include <pda/pci.h>
+#include <pda/dma_pool.h>
+#include <pda/dma_ring.h>
+#include <pda/dma_recorder.h>
 #include <pda/debug.h>
 
 #endif /*PDA_H*/
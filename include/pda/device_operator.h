@@ -100,6 +100,22 @@ PDACheckVersion
 PdaDebugReturnCode
 PDAInit();
 
+/**
+ * Keep DMA buffers out of child processes. While enabled, every buffer mapping which
+ * is created afterwards (DMABuffer_wrapMap, DMABuffer_mapWindows, allocated, looked up
+ * and imported buffers) is marked with MADV_DONTFORK. fork() then doesn't copy their
+ * page tables, which makes it fast for processes with large buffers. Registered user
+ * memory is marked as well, so that a write after fork() can't move the pinned pages
+ * away from the device by copy-on-write. The advice covers whole pages, neighbouring
+ * data in the first and last page of user memory is affected too. Child processes
+ * can't access the buffers and have to attach to them again.
+ * @param  [in] enable
+ *         Enables (true) or disables (false) the protection for new mappings.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PDASetForkProtection(bool enable);
+
 /**
  * Remove or unload kernel dependend components. Needs to be called in a root context.
  * @return PDA_SUCCESS if no error happened, something different if an error happened.
@@ -59,6 +59,39 @@ extern "C"
 /*! Can be passed if the PDA should choose a free buffer ID. */
 #define PDA_BUFFER_INDEX_UNDEFINED 0xFFFFFFFFFFFFFFFF
 
+/*! Buffer flags, see PciDevice_allocDMABufferFlags and PciDevice_getDMABufferFlags. */
+#define PDA_BUFFER_FLAGS_NONE        0x0
+/*! Pre-fault the whole mapping while mapping the buffer (MAP_POPULATE). */
+#define PDA_BUFFER_POPULATE          0x1
+/*! Pre-fault the whole mapping with one thread per CPU on the NUMA node of the device. */
+#define PDA_BUFFER_POPULATE_PARALLEL 0x2
+/*! Zero kernel buffers after allocation with DMABuffer_clear (one thread per CPU). */
+#define PDA_BUFFER_ZERO              0x4
+/*! Mapping modes (cache attributes) of kernel buffers. User buffers are always cached. */
+#define PDA_BUFFER_MAP_UNCACHED       0x00
+/*! Write-combining mapping, fast streaming reads with non-temporal loads (see DMABuffer_readStream). */
+#define PDA_BUFFER_MAP_WRITE_COMBINING 0x10
+/*! Cached (write-back) mapping, DMA is cache-coherent on x86. */
+#define PDA_BUFFER_MAP_CACHED         0x20
+/*! Mask to extract the mapping mode from the buffer flags. */
+#define PDA_BUFFER_MAP_MASK           0x30
+
+/*! Checksum algorithms, see DMABuffer_checksum. */
+#define PDA_CHECKSUM_CRC32C           0x0
+/*! 64 bit xxHash (seed 0), can't be split over several threads. */
+#define PDA_CHECKSUM_XXH64            0x1
+/*! Adler-32 as used by zlib. */
+#define PDA_CHECKSUM_ADLER32          0x2
+
+/*! Patterns, see DMABuffer_fillPattern. Word n is seed + n. */
+#define PDA_PATTERN_INCREMENT         0x0
+/*! Word n is the state of a 64 bit Galois LFSR after n steps (taps 64, 63, 61, 60). */
+#define PDA_PATTERN_LFSR              0x1
+/*! Every word is the seed. */
+#define PDA_PATTERN_CONSTANT          0x2
+/*! Returned by DMABuffer_verifyPattern if the range matches the pattern. */
+#define PDA_PATTERN_NO_MISMATCH       0xFFFFFFFFFFFFFFFF
+
 /*! Macro to generate getter functions. Do not use directly and take look at module PciDevice_get. */
 #define DMA_BUFFER_GET_DEFINITION( name, type )  \
     PdaDebugReturnCode                           \
@@ -90,6 +123,32 @@ struct DMABuffer_SGNode_struct
     DMABuffer_SGNode *prev;      /*!< Previous scatter/gather list entry */
 };
 
+/*! Largest descriptor (in bytes) which can be described by DMABuffer_DescriptorFormat. */
+#define PDA_DESCRIPTOR_SIZE_MAX 64
+
+/*! Layout of a device specific scatter/gather descriptor, see
+ *  DMABuffer_buildDescriptors. Fields are stored little endian with a width of
+ *  16, 32 or 64 bits at a byte offset inside the descriptor.
+ **/
+typedef struct DMABuffer_DescriptorFormat_struct
+{
+    uint8_t  size;           /*!< Size (in bytes) of one descriptor */
+    uint8_t  address_offset; /*!< Byte offset of the device address */
+    uint8_t  address_bits;   /*!< Width of the device address */
+    uint8_t  length_offset;  /*!< Byte offset of the length */
+    uint8_t  length_bits;    /*!< Width of the length */
+    uint8_t  length_shift;   /*!< The length is stored in units of (1 << length_shift) bytes */
+    uint8_t  flags_offset;   /*!< Byte offset of the flags */
+    uint8_t  flags_bits;     /*!< Width of the flags, 0 if the descriptor has no flags */
+    uint64_t flags;          /*!< Flags of every descriptor */
+    uint64_t last_flags;     /*!< Flags which are added to the last descriptor */
+} DMABuffer_DescriptorFormat;
+
+/*! 16 byte descriptors with 64 bit address, 32 bit length and 32 bit flags. */
+#define PDA_DESCRIPTOR_FORMAT_64 { 16, 0, 64, 8, 32, 0, 12, 32, 0, 0 }
+/*! 8 byte descriptors with 32 bit address and 32 bit length. */
+#define PDA_DESCRIPTOR_FORMAT_32 { 8, 0, 32, 4, 32, 0, 0, 0, 0, 0 }
+
 
 
 /**
@@ -109,6 +168,463 @@ struct DMABuffer_SGNode_struct
 PdaDebugReturnCode
 DMABuffer_wrapMap(DMABuffer *buffer) PDA_WARN_UNUSED_RETURN;
 
+/**
+ * Map a part of the buffer several times back to back into the virtual address
+ * space of the process (see DMABuffer_wrapMap). With n_copies = 2 this gives a
+ * ring view of only this part, with n_copies = 1 a separate linear view. The
+ * mappings use the cache mode of the buffer and stay valid until they are
+ * unmapped with DMABuffer_unmapWindows or the buffer is freed.
+ * @param  [in] buffer
+ *         Pointer to the buffer object (or to a slice).
+ * @param  [in] n_copies
+ *         Number of consecutive copies.
+ * @param  [in] offset
+ *         Start offset (in bytes) of the window, has to be page aligned.
+ * @param  [in] length
+ *         Length (in bytes) of the window, has to be a multiple of the page size.
+ * @param  [out] map
+ *         Start of the first copy.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_mapWindows
+(
+    DMABuffer      *buffer,
+    const uint64_t  n_copies,
+    const size_t    offset,
+    const size_t    length,
+    void          **map
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Unmap windows obtained by DMABuffer_mapWindows.
+ * @param  [in] buffer
+ *         Pointer to the buffer object the windows were mapped from.
+ * @param  [in] map
+ *         Start of the first copy.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_unmapWindows
+(
+    DMABuffer *buffer,
+    void      *map
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Translate a pointer into the user space mapping (first or second mapping) of
+ * the buffer into the related device (bus) address. The lookup tables are built
+ * from the scatter/gather list on first use, a translation takes O(log n) in the
+ * number of scatter/gather entries.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] virt
+ *         Pointer into the buffer.
+ * @param  [out] bus
+ *         Device address.
+ * @return PDA_SUCCESS if no error happened, EINVAL if virt is not part of the buffer.
+ */
+PdaDebugReturnCode
+DMABuffer_virtToBus
+(
+    const DMABuffer *buffer,
+    const void      *virt,
+    uint64_t        *bus
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Translate a device (bus) address into a pointer into the first user space
+ * mapping of the buffer (see DMABuffer_virtToBus).
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] bus
+ *         Device address.
+ * @param  [out] virt
+ *         Pointer into the buffer.
+ * @return PDA_SUCCESS if no error happened, EINVAL if bus is not part of the buffer.
+ */
+PdaDebugReturnCode
+DMABuffer_busToVirt
+(
+    const DMABuffer  *buffer,
+    const uint64_t    bus,
+    void            **virt
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Translate an array of pointers into device addresses (see DMABuffer_virtToBus).
+ * Consecutive addresses in the same scatter/gather entry are translated in
+ * constant time.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] virt
+ *         Array of count pointers into the buffer.
+ * @param  [out] bus
+ *         Array of count device addresses. Invalid pointers are translated to 0.
+ * @param  [in] count
+ *         Number of addresses.
+ * @return PDA_SUCCESS if all addresses were translated, EINVAL otherwise.
+ */
+PdaDebugReturnCode
+DMABuffer_virtToBusBatch
+(
+    const DMABuffer   *buffer,
+    const void *const *virt,
+    uint64_t          *bus,
+    const uint64_t     count
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Translate an array of device addresses into pointers (see DMABuffer_busToVirt).
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] bus
+ *         Array of count device addresses.
+ * @param  [out] virt
+ *         Array of count pointers. Invalid addresses are translated to NULL.
+ * @param  [in] count
+ *         Number of addresses.
+ * @return PDA_SUCCESS if all addresses were translated, EINVAL otherwise.
+ */
+PdaDebugReturnCode
+DMABuffer_busToVirtBatch
+(
+    const DMABuffer  *buffer,
+    const uint64_t   *bus,
+    void            **virt,
+    const uint64_t    count
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Encode the scatter/gather list of the buffer into a table of device specific
+ * descriptors. Entries which are longer than max_segment (or than the length
+ * field can express) are split into several descriptors. The table is written
+ * in blocks of whole descriptors, so dst may also point into a device BAR.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] format
+ *         Layout of one descriptor.
+ * @param  [out] dst
+ *         Destination of the descriptor table.
+ * @param  [in] max_bytes
+ *         Size (in bytes) of the destination.
+ * @param  [in] max_segment
+ *         Maximum length (in bytes) of one descriptor, 0 for no limit.
+ * @param  [out] entries
+ *         Number of descriptors. If the destination is too small, the number of
+ *         descriptors which would be needed.
+ * @return PDA_SUCCESS if no error happened, ENOSPC if the destination is too
+ *         small, ERANGE if an address doesn't fit into the address field,
+ *         EINVAL if fields overlap or overrun the descriptor or the flags
+ *         don't fit into the flags field.
+ */
+PdaDebugReturnCode
+DMABuffer_buildDescriptors
+(
+    const DMABuffer                  *buffer,
+    const DMABuffer_DescriptorFormat *format,
+    void                             *dst,
+    const size_t                      max_bytes,
+    const size_t                      max_segment,
+    uint64_t                         *entries
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get a view on a part of the buffer, which can be used like a buffer of its
+ * own (map, sg-list, address translation) without copying. The view shares the
+ * mapping of the buffer and gets its own trimmed sg-list. The buffer can't be
+ * freed as long as views on it exist.
+ * @param  [in] buffer
+ *         Pointer to the buffer object (or to another view).
+ * @param  [in] offset
+ *         Start offset (in bytes) of the view inside the buffer.
+ * @param  [in] length
+ *         Length (in bytes) of the view.
+ * @param  [out] view
+ *         Pointer to the new view, which has to be released with DMABuffer_release.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_slice
+(
+    DMABuffer     *buffer,
+    const size_t   offset,
+    const size_t   length,
+    DMABuffer    **view
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Release a view obtained by DMABuffer_slice.
+ * @param  [in] view
+ *         Pointer to the view.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_release
+(
+    DMABuffer *view
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Export the buffer as dma-buf file descriptor. The descriptor can be passed to
+ * another process (e.g. over a UNIX socket with SCM_RIGHTS), which attaches it
+ * with PciDevice_importDMABuffer. The kernel buffer can't be freed as long as
+ * exported descriptors are open anywhere.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [out] fd
+ *         New dma-buf file descriptor, which has to be closed by the caller.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_exportFd
+(
+    const DMABuffer *buffer,
+    int             *fd
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Pre-fault all pages of the buffer mapping (and of the second mapping if the
+ * buffer is wrap mapped), so that later accesses do not take a page fault per
+ * page. The time it took is available through DMABuffer_getPopulateTime.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] threads
+ *         Number of threads which touch the pages in parallel. Pass 0 to use one
+ *         thread per CPU of the NUMA node of the device.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_populate
+(
+    DMABuffer      *buffer,
+    const uint64_t  threads
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Zero the whole buffer. The work is split over threads which run on the NUMA node
+ * of the device, large buffers are written with non-temporal stores so the zeroes
+ * don't evict other data from the cache. The adapter doesn't clear the memory it
+ * allocates, see also PDA_BUFFER_ZERO.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] threads
+ *         Number of threads which clear the buffer in parallel. Pass 0 to use one
+ *         thread per CPU of the NUMA node of the device.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_clear
+(
+    DMABuffer      *buffer,
+    const uint64_t  threads
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Issue software prefetches for a part of the buffer, so that a following read
+ * does not stall on every cache line. The range may run over the end of the
+ * buffer and continues at its start. Prefetches have no effect on uncached
+ * mappings.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [in] length
+ *         Number of bytes to prefetch (at most the buffer length).
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_prefetch
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Copy data out of the buffer with non-temporal loads and stores where the CPU
+ * supports them (SSE4.1), so neither the DMA data nor the destination pollute the
+ * cache. The range may run over the end of the buffer and continues at its start.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [out] dst
+ *         Destination memory.
+ * @param  [in] length
+ *         Number of bytes to copy (at most the buffer length).
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_readStream
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    void            *dst,
+    const size_t     length
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Compute a checksum over a part of the buffer. CRC32C uses the crc32
+ * instruction (SSE4.2) on three interleaved streams where available. Long
+ * ranges can be split over several threads, the partial CRC32C and Adler-32
+ * checksums are combined into the checksum of the whole range. The range may
+ * run over the end of the buffer and continues at its start.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [in] length
+ *         Number of bytes (at most the buffer length).
+ * @param  [in] algorithm
+ *         One of PDA_CHECKSUM_*.
+ * @param  [in] threads
+ *         Number of threads, 0 for one thread per CPU of the NUMA node
+ *         of the device. Ranges shorter than 1 MiB per thread are not split.
+ * @param  [out] checksum
+ *         Resulting checksum.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_checksum
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const uint64_t   algorithm,
+    const uint64_t   threads,
+    uint64_t        *checksum
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Fill a part of the buffer with a pattern of 64 bit little-endian words. The
+ * words are counted from the start of the range, so the same range can be
+ * checked with DMABuffer_verifyPattern. The work is split over threads which
+ * run on the NUMA node of the device. Large aligned ranges are written with
+ * non-temporal stores. The range may run over the end of the buffer and
+ * continues at its start.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [in] length
+ *         Number of bytes (at most the buffer length).
+ * @param  [in] pattern
+ *         One of PDA_PATTERN_*.
+ * @param  [in] seed
+ *         First word of the pattern (a zero LFSR seed is replaced by 1).
+ * @param  [in] threads
+ *         Number of threads, 0 for one thread per CPU of the NUMA node
+ *         of the device. Ranges shorter than 1 MiB per thread are not split.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_fillPattern
+(
+    DMABuffer      *buffer,
+    const size_t    offset,
+    const size_t    length,
+    const uint64_t  pattern,
+    const uint64_t  seed,
+    const uint64_t  threads
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Check a part of the buffer against a pattern written by DMABuffer_fillPattern
+ * or by a device which generates the same pattern.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [in] length
+ *         Number of bytes (at most the buffer length).
+ * @param  [in] pattern
+ *         One of PDA_PATTERN_*.
+ * @param  [in] seed
+ *         First word of the pattern.
+ * @param  [in] threads
+ *         Number of threads, 0 for one thread per CPU of the NUMA node
+ *         of the device.
+ * @param  [out] mismatch
+ *         Offset of the first differing byte relative to the range start, or
+ *         PDA_PATTERN_NO_MISMATCH.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ *         A mismatch is not an error.
+ */
+PdaDebugReturnCode
+DMABuffer_verifyPattern
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const uint64_t   pattern,
+    const uint64_t   seed,
+    const uint64_t   threads,
+    uint64_t        *mismatch
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Send a part of the buffer over a connected TCP socket without copying it.
+ * The data is passed with MSG_ZEROCOPY, so the kernel still reads from the
+ * buffer after the call returned. Use DMABuffer_sendReleased to find out which
+ * data may be overwritten. If the socket does not support zero-copy, the range
+ * is sent with sendmsg from the mapping and is released right away. This is
+ * also the case for kernel buffers, their mapping can't be pinned. The range
+ * may run over the end of the buffer and continues at its start. All bytes are
+ * sent before the call returns, also on non-blocking sockets.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] offset
+ *         Start offset (in bytes) inside the buffer.
+ * @param  [in] length
+ *         Number of bytes (at most the buffer length).
+ * @param  [in] sockfd
+ *         Connected stream socket.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_send
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const int        sockfd
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Collect the completions of the kernel for a socket without blocking. Sends are
+ * released in the order in which they were issued.
+ * @param  [in] sockfd
+ *         Socket which was passed to DMABuffer_send.
+ * @param  [out] released
+ *         Number of bytes sent over the socket which the kernel does not need
+ *         any more.
+ * @param  [out] copied
+ *         Number of released bytes which the kernel copied anyway (e.g. over
+ *         loopback), can be NULL.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_sendReleased
+(
+    const int  sockfd,
+    uint64_t  *released,
+    uint64_t  *copied
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Wait until the kernel released all data sent over the socket and stop
+ * tracking it. Must be called before the socket is closed.
+ * @param  [in] sockfd
+ *         Socket which was passed to DMABuffer_send.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMABuffer_sendClose
+(
+    const int sockfd
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Free all buffers in the list.
  * @param  [in] buffer
@@ -138,14 +654,24 @@ DMABuffer_freeAllBuffers(DMABuffer *buffer) PDA_WARN_UNUSED_RETURN;
     DMA_BUFFER_GET_DEFINITION( Prev, DMABuffer **prev );
     /*! Get the length (in bytes) of the buffer. */
     DMA_BUFFER_GET_DEFINITION( Length, size_t *length );
-    /*! Get the raw pointer of the DMA buffer. */
+    /*! Get the raw pointer of the DMA buffer. Its cache attributes are reported by DMABuffer_getCacheMode. */
     DMA_BUFFER_GET_DEFINITION( Map, void **map );
+    /*! Get the mapping mode (one of PDA_BUFFER_MAP_*) which is in effect for the buffer. */
+    DMA_BUFFER_GET_DEFINITION( CacheMode, uint64_t *mode );
     /*! Get the raw pointer to the second mapping. */
     DMA_BUFFER_GET_DEFINITION( MapTwo, void **map_two );
     /*! Get the related scatter/gather list of the buffer. */
     DMA_BUFFER_GET_DEFINITION( SGList, DMABuffer_SGNode **sglist );
+    /*! Get the number of entries in the (coalesced) scatter/gather list of the buffer. */
+    DMA_BUFFER_GET_DEFINITION( SGEntries, uint64_t *entries );
     /*! Get the index of the buffer. */
     DMA_BUFFER_GET_DEFINITION( Index, uint64_t *index);
+    /*! Get the offset (in bytes) of a sub-buffer inside its parent buffer (0 for ordinary buffers). */
+    DMA_BUFFER_GET_DEFINITION( Offset, size_t *offset);
+    /*! Get the flags the buffer was attached with. */
+    DMA_BUFFER_GET_DEFINITION( Flags, uint64_t *flags);
+    /*! Get the time (in nanoseconds) it took to pre-fault the mapping (0 if not populated). */
+    DMA_BUFFER_GET_DEFINITION( PopulateTime, uint64_t *populate_time);
 
     /**
      * Get the first entry of the buffer list.
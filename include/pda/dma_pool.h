@@ -0,0 +1,165 @@
+/**
+ * @brief Class for managing pools of DMA sub-buffers.
+ *
+ * @cond SHOWHIDDEN
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * @endcond
+ */
+
+
+
+#ifndef DMA_POOL_H
+#define DMA_POOL_H
+
+#include <pda/defines.h>
+#include <pda/debug.h>
+#include <pda/pci.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \defgroup DMAPool DMAPool
+ *  @{
+ */
+
+/*! A DMAPool object allocates one large kernel DMA buffer and hands out
+ *  fixed-size sub-buffers (chunks) of it. Allocating and freeing chunks does
+ *  not involve the kernel adapter at all and takes constant time. Each thread
+ *  keeps a small cache of free chunks, so that the pool lock is only taken
+ *  every few operations.
+ *
+ *  The chunks are DMABuffer objects with their own mapping, length and
+ *  scatter/gather list (see DMABuffer_get). They must not be freed with
+ *  PciDevice_deleteDMABuffer and are only valid during the lifetime of the pool.
+ */
+typedef struct DMAPool_struct DMAPool;
+
+/**
+ * Allocate a new pool of DMA sub-buffers.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] index
+ *         Index of the underlying DMA buffer (see PciDevice_allocDMABuffer).
+ * @param  [in] chunk_size
+ *         Size (in bytes) of a single chunk.
+ * @param  [in] alignment
+ *         Alignment (in bytes, power of two) of the chunks relative to the
+ *         start of the underlying buffer. Pass 0 for no extra alignment.
+ *         Device addresses are aligned likewise up to the page size.
+ * @param  [in] chunk_count
+ *         Number of chunks in the pool.
+ * @param  [out] pool
+ *         Pointer to the pool pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMAPool_new
+(
+    PciDevice      *device,
+    const uint64_t  index,
+    const size_t    chunk_size,
+    const size_t    alignment,
+    const uint64_t  chunk_count,
+    DMAPool       **pool
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Delete the pool and free the underlying DMA buffer. All chunks become
+ * invalid.
+ * @param  [in] pool
+ *         Pointer to the pool object.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMAPool_delete
+(
+    DMAPool *pool
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get a free chunk from the pool.
+ * @param  [in] pool
+ *         Pointer to the pool object.
+ * @param  [out] chunk
+ *         Pointer to the chunk pointer.
+ * @return PDA_SUCCESS if no error happened, ENOMEM if the pool is exhausted.
+ */
+PdaDebugReturnCode
+DMAPool_alloc
+(
+    DMAPool    *pool,
+    DMABuffer **chunk
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Return a chunk to the pool.
+ * @param  [in] pool
+ *         Pointer to the pool object.
+ * @param  [in] chunk
+ *         Pointer to a chunk obtained from DMAPool_alloc.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMAPool_free
+(
+    DMAPool   *pool,
+    DMABuffer *chunk
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get the DMA buffer which backs the pool.
+ * @param  [in] pool
+ *         Pointer to the pool object.
+ * @param  [out] buffer
+ *         Pointer to the buffer pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMAPool_getBuffer
+(
+    const DMAPool  *pool,
+    DMABuffer     **buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/** @}*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DMA_POOL_H */
@@ -0,0 +1,202 @@
+/**
+ * @brief Class for recording DMA buffer ranges to files.
+ *
+ * @cond SHOWHIDDEN
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * @endcond
+ */
+
+
+
+#ifndef DMA_RECORDER_H
+#define DMA_RECORDER_H
+
+#include <pda/defines.h>
+#include <pda/debug.h>
+#include <pda/dma_buffer.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \defgroup DMARecorder DMARecorder
+ *  @{
+ */
+
+/*! File offsets, lengths and buffer addresses must be multiples of this value
+ *  to be written with direct I/O. */
+#define PDA_RECORDER_ALIGNMENT 4096
+
+/*! Default number of write requests in flight. */
+#define PDA_RECORDER_QUEUE_DEPTH 32
+/*! Default maximum size of one write request. */
+#define PDA_RECORDER_REQUEST_SIZE (1024 * 1024)
+
+/*! A DMARecorder object appends ranges of a DMA buffer to a file without
+ *  copying them. The file is opened with O_DIRECT and the writes are submitted
+ *  to an io_uring, so several requests are in flight at the same time. Ranges
+ *  which wrap around the end of the buffer are split, unless the buffer is wrap
+ *  mapped. If io_uring is not available, the recorder falls back to pwritev and
+ *  writes synchronously. Ranges which are not aligned to PDA_RECORDER_ALIGNMENT
+ *  (or file systems without O_DIRECT support) go through the page cache, as do
+ *  kernel allocated buffers, whose mappings can't be pinned for direct I/O.
+ *
+ *  The buffer data of a range must not be overwritten before the range is
+ *  reported as written by DMARecorder_getWritten.
+ */
+typedef struct DMARecorder_struct DMARecorder;
+
+/*! Statistics of a recorder, see DMARecorder_getStatistics. */
+typedef struct DMARecorderStatistics_struct
+{
+    uint64_t bytes;       /*!< Bytes written to the file */
+    uint64_t requests;    /*!< Completed write requests */
+    uint64_t direct;      /*!< Bytes which were written with direct I/O */
+    uint64_t max_pending; /*!< Largest number of requests in flight */
+    uint64_t nanoseconds; /*!< Time from the first submission to the last completion */
+    double   bandwidth;   /*!< Sustained bandwidth in bytes per second */
+} DMARecorderStatistics;
+
+/**
+ * Create a new recorder which writes ranges of a DMA buffer into a file. An
+ * existing file is truncated. The buffer is not owned by the recorder.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [in] path
+ *         Path of the file.
+ * @param  [in] queue_depth
+ *         Maximum number of requests in flight (0 for PDA_RECORDER_QUEUE_DEPTH).
+ * @param  [in] request_size
+ *         Maximum size of one request in bytes, longer ranges are split (0 for
+ *         PDA_RECORDER_REQUEST_SIZE). Must be a multiple of PDA_RECORDER_ALIGNMENT.
+ * @param  [out] recorder
+ *         Pointer to the recorder pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARecorder_new
+(
+    DMABuffer     *buffer,
+    const char    *path,
+    const uint64_t queue_depth,
+    const uint64_t request_size,
+    DMARecorder  **recorder
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Wait for all requests in flight, close the file and delete the recorder.
+ * @param  [in] recorder
+ *         Pointer to the recorder object.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ *         A failed write which was not reported before is reported here.
+ */
+PdaDebugReturnCode
+DMARecorder_delete
+(
+    DMARecorder *recorder
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Append a range of the buffer to the file. The call returns after the range is
+ * submitted and only blocks if the queue is full.
+ * @param  [in] recorder
+ *         Pointer to the recorder object.
+ * @param  [in] offset
+ *         Offset of the range in the buffer.
+ * @param  [in] length
+ *         Length of the range, it may wrap around the end of the buffer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARecorder_write
+(
+    DMARecorder  *recorder,
+    const size_t  offset,
+    const size_t  length
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Reap finished requests without blocking and return how many bytes are on
+ * disk. Ranges are counted in the order in which they were submitted, so the
+ * buffer may be reused up to this point.
+ * @param  [in] recorder
+ *         Pointer to the recorder object.
+ * @param  [out] bytes
+ *         Number of bytes written since the recorder was created.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARecorder_getWritten
+(
+    DMARecorder *recorder,
+    uint64_t    *bytes
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Wait until all submitted ranges are written.
+ * @param  [in] recorder
+ *         Pointer to the recorder object.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARecorder_flush
+(
+    DMARecorder *recorder
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get the statistics of the recorder, bandwidth included.
+ * @param  [in] recorder
+ *         Pointer to the recorder object.
+ * @param  [out] statistics
+ *         Pointer to the statistics which are filled.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARecorder_getStatistics
+(
+    DMARecorder           *recorder,
+    DMARecorderStatistics *statistics
+) PDA_WARN_UNUSED_RETURN;
+
+/** @}*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DMA_RECORDER_H */
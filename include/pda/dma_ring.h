@@ -0,0 +1,221 @@
+/**
+ * @brief Class for single producer / single consumer rings on top of DMA buffers.
+ *
+ * @cond SHOWHIDDEN
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * @endcond
+ */
+
+
+
+#ifndef DMA_RING_H
+#define DMA_RING_H
+
+#include <pda/defines.h>
+#include <pda/debug.h>
+#include <pda/bar.h>
+#include <pda/dma_buffer.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \defgroup DMARing DMARing
+ *  @{
+ */
+
+/*! Can be passed if a ring position register does not exist. */
+#define PDA_RING_REGISTER_NONE 0xFFFFFFFFFFFFFFFF
+
+/*! A DMARing object implements a lock-free single producer / single consumer
+ *  ring on top of a wrap mapped DMA buffer (see DMABuffer_wrapMap). Producer and
+ *  consumer may be two threads of the process, or the device on one side and a
+ *  thread on the other. Because of the second mapping behind the buffer, the
+ *  views returned by DMARing_peek and DMARing_reserve are always contiguous, even
+ *  if they cross the end of the buffer.
+ *
+ *  Producer and consumer positions live in separate cache lines. Each side
+ *  only writes its own position, so no locks are needed.
+ */
+typedef struct DMARing_struct DMARing;
+
+/**
+ * Create a new ring on top of a DMA buffer. The buffer is wrap mapped if that
+ * did not happen before. The buffer is not owned by the ring.
+ * @param  [in] buffer
+ *         Pointer to the buffer object.
+ * @param  [out] ring
+ *         Pointer to the ring pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_new
+(
+    DMABuffer  *buffer,
+    DMARing   **ring
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Delete the ring object. The underlying buffer stays untouched.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_delete
+(
+    DMARing *ring
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Attach device registers to the ring, if the device is one side of the ring.
+ * The device publishes its position (write pointer if it produces, read pointer
+ * if it consumes) in device_pointer, the ring publishes the position of this
+ * process in host_pointer. Both registers hold byte offsets into the buffer. The
+ * producer must never fill the ring completely, so one byte of the buffer stays
+ * unused in this mode.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [in] bar
+ *         Pointer to the bar which contains the registers.
+ * @param  [in] device_pointer
+ *         Bar offset of the device position register or PDA_RING_REGISTER_NONE.
+ * @param  [in] host_pointer
+ *         Bar offset of the host position register or PDA_RING_REGISTER_NONE.
+ * @param  [in] register_size
+ *         Size of the registers in bytes (4 or 8).
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_setDeviceRegisters
+(
+    DMARing           *ring,
+    const Bar         *bar,
+    const Bar_address  device_pointer,
+    const Bar_address  host_pointer,
+    const uint8_t      register_size
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Consumer side: get a zero-copy view of the data which is ready to be read.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [out] data
+ *         Pointer to the first readable byte.
+ * @param  [out] bytes
+ *         Number of readable bytes behind data (may be 0).
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_peek
+(
+    DMARing   *ring,
+    void     **data,
+    uint64_t  *bytes
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Consumer side: release data which was returned by DMARing_peek.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [in] bytes
+ *         Number of bytes to release.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_consume
+(
+    DMARing        *ring,
+    const uint64_t  bytes
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Producer side: get a zero-copy view of the free space in the ring.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [out] data
+ *         Pointer to the first writable byte.
+ * @param  [out] bytes
+ *         Number of writable bytes behind data (may be 0).
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_reserve
+(
+    DMARing   *ring,
+    void     **data,
+    uint64_t  *bytes
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Producer side: publish data which was written into the view returned by
+ * DMARing_reserve.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [in] bytes
+ *         Number of bytes to publish.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_commit
+(
+    DMARing        *ring,
+    const uint64_t  bytes
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get the DMA buffer which backs the ring.
+ * @param  [in] ring
+ *         Pointer to the ring object.
+ * @param  [out] buffer
+ *         Pointer to the buffer pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+DMARing_getBuffer
+(
+    const DMARing  *ring,
+    DMABuffer     **buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/** @}*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DMA_RING_H */
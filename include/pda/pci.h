@@ -81,6 +81,29 @@ typedef uint64_t (*PciInterrupt)
     const void*
 );
 
+/*! Metadata of one buffer of a device, as reported by PciDevice_queryBuffers.
+ */
+typedef struct PdaBufferInfo_struct
+{
+    uint64_t index;      /*!< Index of the buffer */
+    uint64_t size;       /*!< Size of the buffer in bytes */
+    uint64_t sg_entries; /*!< Number of scatter/gather entries as reported by the kernel */
+    int32_t  numa_node;  /*!< NUMA node the memory was requested on, -1 if unknown */
+    uint8_t  attached;   /*!< Nonzero if the buffer is attached to this process */
+} PdaBufferInfo;
+
+/*! Function pointer prototype for the completion callback of an asynchronous
+ *  buffer allocation (see PciDevice_allocDMABufferAsync). The buffer is NULL
+ *  if the allocation failed.
+ */
+typedef void (*PciDevice_AllocCallback)
+(
+    PciDevice          *device,
+    DMABuffer          *buffer,
+    PdaDebugReturnCode  ret,
+    void               *ctx
+);
+
 
 
 /**
@@ -170,6 +193,121 @@ PciDevice_allocDMABuffer
     DMABuffer          **buffer
 ) PDA_WARN_UNUSED_RETURN;
 
+/**
+ * Allocate a DMA buffer with additional flags. See also module DMABuffer.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] index
+ *         The ID is a reference to the persistently allocated DMA buffer. The function
+ *         fails if an explicitly given ID already exists.
+ * @param  [in] size
+ *         Target size of the DMA buffer. Value will be rounded up to a multiple of a
+ *         page size.
+ * @param  [in] flags
+ *         Combination of PDA_BUFFER_* flags, e.g. PDA_BUFFER_POPULATE to pre-fault
+ *         the mapping (see DMABuffer_getPopulateTime) and one of the PDA_BUFFER_MAP_*
+ *         mapping modes. Buffers are mapped uncached by default.
+ * @param  [out] buffer
+ *         Pointer to a buffer pointer. This function also instantiates the buffer object itself.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_allocDMABufferFlags
+(
+    PciDevice           *device,
+    const uint64_t       index,
+    const size_t         size,
+    const uint64_t       flags,
+    DMABuffer          **buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Allocate several DMA buffers in one call. The buffers get consecutive indices
+ * behind the highest index in use. Mapping and scatter/gather list loading of
+ * already allocated buffers overlaps with the kernel allocation of the remaining
+ * ones. Either all buffers are allocated or none.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] count
+ *         Number of buffers to allocate.
+ * @param  [in] sizes
+ *         Array of count target sizes (see PciDevice_allocDMABuffer).
+ * @param  [out] buffers
+ *         Array of count buffer pointers, which is filled by this function.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_allocDMABuffers
+(
+    PciDevice           *device,
+    const uint64_t       count,
+    const size_t        *sizes,
+    DMABuffer          **buffers
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Allocate a DMA buffer in the background. The call returns immediately, the
+ * kernel allocation and the mapping run in a separate thread. Finished
+ * allocations are signaled through the descriptor of
+ * PciDevice_getAllocEventFd and reported by PciDevice_completeAllocations,
+ * which adds the buffers to the device and calls the callbacks.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] index
+ *         Index of the buffer, or PDA_BUFFER_INDEX_UNDEFINED.
+ * @param  [in] size
+ *         Target size (see PciDevice_allocDMABuffer).
+ * @param  [in] callback
+ *         Completion callback, may be NULL.
+ * @param  [in] ctx
+ *         User pointer which is passed to the callback.
+ * @return PDA_SUCCESS if the allocation was started, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_allocDMABufferAsync
+(
+    PciDevice               *device,
+    const uint64_t           index,
+    const size_t             size,
+    PciDevice_AllocCallback  callback,
+    void                    *ctx
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get an event descriptor (eventfd) which becomes readable when asynchronous
+ * allocations finished. It can be used with poll/epoll and is owned by the device.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [out] fd
+ *         Event descriptor.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_getAllocEventFd
+(
+    PciDevice *device,
+    int       *fd
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Report finished asynchronous allocations without blocking. The buffers are
+ * added to the device and the callbacks are called from the calling thread.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [out] completed
+ *         Number of reported allocations, may be NULL.
+ * @param  [out] pending
+ *         Number of allocations which are still running, may be NULL.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_completeAllocations
+(
+    PciDevice *device,
+    uint64_t  *completed,
+    uint64_t  *pending
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Register a user space malloced buffer.
  * @param  [in] device
@@ -196,6 +334,101 @@ PciDevice_registerDMABuffer
     DMABuffer          **buffer
 );
 
+/**
+ * Register user memory through the registration cache of the device. If an existing
+ * registration covers the range completely, a slice of it is returned and the costly
+ * pinning and mapping is skipped. Otherwise the range is extended to page boundaries
+ * and registered. The returned buffer is a slice (see DMABuffer_slice) and must be
+ * given back with PciDevice_releaseCachedDMABuffer instead of being deleted. Unused
+ * registrations stay cached until more than 1 GiB is idle, the least recently used
+ * ones are deregistered first.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] start
+ *         Pointer to the start of the user memory range.
+ * @param  [in] size
+ *         Size of the range in bytes.
+ * @param  [out] buffer
+ *         Pointer to a buffer pointer, is set to a slice covering exactly the range.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_registerCachedDMABuffer
+(
+    PciDevice           *device,
+    void                *start,
+    const size_t         size,
+    DMABuffer          **buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Give back a buffer from PciDevice_registerCachedDMABuffer. The underlying
+ * registration stays cached for later requests.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] buffer
+ *         Buffer which was returned by PciDevice_registerCachedDMABuffer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_releaseCachedDMABuffer
+(
+    PciDevice           *device,
+    DMABuffer           *buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Drop all cached registrations which overlap a memory range. This must be called
+ * before cached memory is unmapped or freed, otherwise later requests may get a
+ * registration which still points to the old pages. Unused registrations are
+ * deregistered immediately, registrations in use are not handed out any more and
+ * are deregistered as soon as their last buffer is released.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] start
+ *         Pointer to the start of the memory range.
+ * @param  [in] size
+ *         Size of the range in bytes.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_invalidateRegistrations
+(
+    PciDevice           *device,
+    const void          *start,
+    const size_t         size
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Allocate a hugepage backed user space buffer on the NUMA node of the device and
+ * register it. Physically consecutive pages are merged, so the scatter/gather list
+ * usually has only one entry per hugepage or less (see DMABuffer_getSGEntries).
+ * The memory is owned by the library and released together with the buffer.
+ * Hugepages of the requested size must be reserved in the system (vm.nr_hugepages).
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] index
+ *         The ID is a reference to the persistently allocated DMA buffer. The function
+ *         fails if an explicitly given ID already exists.
+ * @param  [in] size
+ *         Target size of the DMA buffer. Value will be rounded up to a multiple of
+ *         the hugepage size.
+ * @param  [in] page_size
+ *         Hugepage size in bytes (2MB or 1GB on x86). Pass 0 for 2MB pages.
+ * @param  [out] buffer
+ *         Pointer to a buffer pointer. This function also instantiates the buffer object itself.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_allocHugeUserDMABuffer
+(
+    PciDevice           *device,
+    const uint64_t       index,
+    const size_t         size,
+    const size_t         page_size,
+    DMABuffer          **buffer
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Delete the given buffer pointer. See also module DMABuffer.
  * @param  [in] device
@@ -211,6 +444,40 @@ PciDevice_deleteDMABuffer
     DMABuffer *buffer
 );
 
+/**
+ * Enable or disable deferred freeing. While enabled, PciDevice_deleteDMABuffer only
+ * unlinks kernel buffers from the device and returns. Unmapping and giving the memory
+ * back to the kernel adapter is done by a background thread of the device. Registered
+ * user memory is still unpinned before PciDevice_deleteDMABuffer returns, because the
+ * caller owns it. Disabling waits for all queued buffers to be freed.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] enable
+ *         Nonzero starts the background thread, zero stops it.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ *         When disabling, errors of previously queued buffers are reported.
+ */
+PdaDebugReturnCode
+PciDevice_setDeferredFree
+(
+    PciDevice     *device,
+    const uint8_t  enable
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Wait until all buffers queued by deferred freeing are freed, e.g. before shutdown or
+ * before memory is needed again. Deleting the device drains the queue as well.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @return PDA_SUCCESS if no error happened, something different if freeing one of the
+ *         queued buffers failed since the last call.
+ */
+PdaDebugReturnCode
+PciDevice_drainFrees
+(
+    PciDevice *device
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Delete all buffers attached to the given device. See also module DMABuffer.
  * @param  [in] device
@@ -238,6 +505,54 @@ PciDevice_getListOfBuffers
      uint64_t  **ids
 );
 
+/**
+ * Get the metadata of all buffers of the device in one call. The kernel adapter
+ * maintains a generation number for the buffer list of every device. If it still
+ * equals the one passed in, nothing changed and the call returns without touching
+ * infos and count, so that callers which poll keep their previous result. Kernel
+ * adapters without a generation number always lead to a full query.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [out] infos
+ *         Array which is filled with the metadata of up to max buffers.
+ * @param  [in] max
+ *         Number of entries in infos.
+ * @param  [out] count
+ *         Number of buffers of the device. If this is more than max, only the first
+ *         max entries are filled and the generation is reset to 0, so that the next
+ *         call queries again.
+ * @param  [in,out] generation
+ *         Generation returned by the previous call, 0 forces a query. Returns the
+ *         generation the result belongs to.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_queryBuffers
+(
+    PciDevice      *device,
+    PdaBufferInfo  *infos,
+    const uint64_t  max,
+    uint64_t       *count,
+    uint64_t       *generation
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Attach all persistent buffers of the device, which are not yet known to this
+ * process (e.g. after a restart). The buffers are mapped by a bounded set of threads,
+ * their scatter/gather lists are loaded on the first DMABuffer_getSGList. Processes
+ * which only need a few buffers can skip this call, PciDevice_getDMABuffer attaches
+ * single buffers on demand.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ *         Buffers which could be mapped are attached in any case.
+ */
+PdaDebugReturnCode
+PciDevice_attachDMABuffers
+(
+    PciDevice *device
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Get an already allocated buffer. See also module DMABuffer.
  * @param  [in] device
@@ -257,6 +572,51 @@ PciDevice_getDMABuffer
     DMABuffer      **buffer
 ) PDA_WARN_UNUSED_RETURN;
 
+/**
+ * Attach a buffer which another process exported with DMABuffer_exportFd. The
+ * buffer is mapped through the dma-buf, no sysfs lookup is needed. Freeing the
+ * buffer object only detaches it, the exporting process owns the kernel buffer.
+ * @param  [in] device
+ *         Pointer to the device object the buffer was allocated for. Descriptors
+ *         exported for another device are rejected.
+ * @param  [in] fd
+ *         dma-buf file descriptor. The buffer keeps its own duplicate, so the
+ *         caller may close it afterwards.
+ * @param  [out] buffer
+ *         Pointer to the buffer pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_importDMABuffer
+(
+    PciDevice           *device,
+    const int            fd,
+    DMABuffer          **buffer
+) PDA_WARN_UNUSED_RETURN;
+
+/**
+ * Get an already allocated buffer with additional flags. The flags only take
+ * effect if the buffer is attached by this call. The mapping mode is always the
+ * one the buffer was allocated with. See also module DMABuffer.
+ * @param  [in] device
+ *         Pointer to the device object.
+ * @param  [in] index
+ *         The ID is a reference to the persistently allocated DMA buffer.
+ * @param  [in] flags
+ *         Combination of PDA_BUFFER_* flags (see PciDevice_allocDMABufferFlags).
+ * @param  [out] buffer
+ *         Pointer to the buffer pointer.
+ * @return PDA_SUCCESS if no error happened, something different if an error happened.
+ */
+PdaDebugReturnCode
+PciDevice_getDMABufferFlags
+(
+    PciDevice       *device,
+    const uint64_t   index,
+    const uint64_t   flags,
+    DMABuffer      **buffer
+) PDA_WARN_UNUSED_RETURN;
+
 /**
  * Get a Basic Address Register (BAR) reference. See also module Bar.
  * @param  [in] device
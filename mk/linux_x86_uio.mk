@@ -1,5 +1,5 @@
 CC=gcc
 INCLUDE=-I./include/ -I./src/ 
 CFLAGS=--std=gnu99 -Wall -Wunused-result -Wno-format-truncation -fno-tree-vectorize
-LDFLAGS=-lpci -pthread
+LDFLAGS=-lpci -pthread -lrt
 CLEANUP_FILES = .lo .la .o '~' bin
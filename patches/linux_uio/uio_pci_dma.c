@@ -37,6 +37,7 @@
 
 #include <linux/device.h>
 #include <linux/kobject.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/pci.h>
 #include <linux/sort.h>
@@ -54,6 +55,12 @@
 #define UIO_PDA_IOMMU
 //#define UIO_PDA_USE_PAGEFAULT_HANDLER
 
+#ifdef UIO_PDA_IOMMU
+    #define UIO_PCI_DMA_SG_LENGTH(_sg) sg_dma_len(_sg)
+#else
+    #define UIO_PCI_DMA_SG_LENGTH(_sg) ((_sg)->length)
+#endif
+
 
 #include "uio_pci_dma.h"
 
@@ -69,10 +76,14 @@ struct uio_pci_dma_device
     struct kobject       *dma_kobj;
     struct bin_attribute  attr_bar[PCI_NUM_RESOURCES];
     bool                  msi_enabled;
+    uint64_t              generation;
 };
 
 DEFINE_MUTEX(alloc_free_lock);
 
+/* Source of the buffer and device generation numbers, protected by alloc_free_lock */
+static uint64_t buffer_generation;
+
 static inline int
 uio_pci_dma_allocate_kernel_memory(struct uio_pci_dma_private *priv);
 
@@ -274,6 +285,10 @@ probe
     BIN_ATTR_PDA(max_read_request_size, sizeof(int), S_IRUGO,
         uio_pci_dma_sysfs_readrq, NULL, NULL);
 
+    /* attr_bin_generation */
+    BIN_ATTR_PDA(generation, sizeof(uint64_t), S_IRUGO,
+        uio_pci_dma_sysfs_dma_generation, NULL, NULL);
+
     UIO_DEBUG_PRINTF("Enabling the PCI Device\n");
     err = pci_enable_device(pci_device);
     if(err)
@@ -304,6 +319,10 @@ probe
     dma_device->pdev           = pci_device;
     dma_device->msi_enabled    = msi_enabled;
 
+    mutex_lock(&alloc_free_lock);
+    dma_device->generation     = ++buffer_generation;
+    mutex_unlock(&alloc_free_lock);
+
     dma_device->info.name      = DRIVER_NAME;
     dma_device->info.version   = UIO_PCI_DMA_VERSION;
     dma_device->info.irq       = pci_device->irq;
@@ -339,6 +358,11 @@ probe
     if( (err = sysfs_create_bin_file(dma_kobj, attr_bin_max_read_request_size)) )
     { UIO_PDA_ERROR("Can't create entry for maximum read request size!\n", exit_max_read_request_size); }
 
+    /* Add an entry which changes whenever a buffer of the device is allocated or freed */
+    UIO_DEBUG_PRINTF("Add generation entry\n");
+    if( (err = sysfs_create_bin_file(dma_kobj, attr_bin_generation)) )
+    { UIO_PDA_ERROR("Can't create entry for the device generation!\n", exit_generation); }
+
     /* create attributes for BAR mappings */
     if(pci_request_regions(pci_device, DRIVER_NAME))
     {
@@ -376,7 +400,7 @@ probe
     /** Set driver specific data. */
     UIO_DEBUG_PRINTF("Register device and set the driver specific data\n");
     if(uio_register_device(&pci_device->dev, &dma_device->info) )
-    { UIO_PDA_ERROR( "Registering device failed!\n", exit_max_read_request_size); }
+    { UIO_PDA_ERROR( "Registering device failed!\n", exit_generation); }
     pci_set_drvdata(pci_device, dma_device);
 
     printk(DRIVER_NAME " : initialized new DMA device (%x %x)\n",
@@ -391,6 +415,9 @@ exit_bars:
         { sysfs_remove_bin_file(&pci_device->dev.kobj, &dma_device->attr_bar[i]); }
     }
 
+exit_generation:
+    sysfs_remove_bin_file(dma_kobj, attr_bin_generation);
+
 exit_max_read_request_size:
     sysfs_remove_bin_file(dma_kobj, attr_bin_max_read_request_size);
 
@@ -425,6 +452,9 @@ exit:
     if(attr_bin_max_read_request_size)
     { kfree(attr_bin_max_read_request_size); }
 
+    if(attr_bin_generation)
+    { kfree(attr_bin_generation); }
+
     UIO_DEBUG_RETURN(err);
 }
 
@@ -497,6 +527,8 @@ static int __init mod_init(void)
     UIO_DEBUG_ENTER();
         printk(DRIVER_DESC " version: " UIO_PCI_DMA_VERSION "\n");
         printk(DRIVER_DESC " minor  : " UIO_PCI_DMA_MINOR "\n");
+        /* Seeded with the wall clock, so that numbers are not reused after reloading */
+        buffer_generation = ktime_to_ns(ktime_get_real());
     UIO_DEBUG_RETURN(pci_register_driver(&driver));
 }
 
@@ -508,6 +540,21 @@ static void __exit mod_exit(void)
     UIO_DEBUG_PRINTF("mod_exit EXIT\n");
 }
 
+/*! \brief uio_pci_dma_device_changed
+ *         Gives the device behind a "dma" folder a new generation number,
+ *         called with alloc_free_lock held whenever its buffer list changed. */
+static inline void
+uio_pci_dma_device_changed(struct kobject *dma_kobj)
+{
+    struct device *device
+        = container_of(dma_kobj->parent, struct device, kobj);
+    struct uio_pci_dma_device *dma_device
+        = pci_get_drvdata(container_of(device, struct pci_dev, dev));
+
+    if(dma_device)
+    { dma_device->generation = ++buffer_generation; }
+}
+
 /** CALLBACKS */
 
 /*! \brief uio_pci_dma_request_buffer_write
@@ -556,7 +603,13 @@ BIN_ATTR_WRITE_CALLBACK( request_buffer_write )
     priv->page_list = NULL;
     priv->pfn_list  = NULL;
     priv->length    = 0;
-    priv->start     = request->start;
+    priv->exports    = 0;
+    priv->generation = ++buffer_generation;
+    priv->start      = request->start;
+
+    /* Importers check that a dma-buf belongs to their device */
+    snprintf(priv->exp_name, UIO_PCI_DMA_EXP_NAME_SIZE, "%s/%s",
+             dev_name(priv->device), kobject_name(&priv->kobj));
 
     if(request->start == 0)
     {
@@ -577,6 +630,22 @@ BIN_ATTR_WRITE_CALLBACK( request_buffer_write )
     BIN_ATTR_PDA(sg, (priv->length * sizeof(struct scatter) ), S_IRUGO,
                  uio_pci_dma_sysfs_mock, uio_pci_dma_sysfs_mock, uio_pci_dma_sysfs_map_sg);
 
+    /* Define and allocate the struct attr_bin_flags */
+    BIN_ATTR_PDA(flags, sizeof(uint32_t), S_IRUGO,
+                 uio_pci_dma_sysfs_buffer_flags, NULL, NULL);
+
+    /* Define and allocate the struct attr_bin_dmabuf */
+    BIN_ATTR_PDA(dmabuf, sizeof(int32_t), S_IRUGO,
+                 uio_pci_dma_sysfs_buffer_dmabuf, NULL, NULL);
+
+    /* Define and allocate the struct attr_bin_generation */
+    BIN_ATTR_PDA(generation, sizeof(uint64_t), S_IRUGO,
+                 uio_pci_dma_sysfs_buffer_generation, NULL, NULL);
+
+    /* Define and allocate the struct attr_bin_numa_node */
+    BIN_ATTR_PDA(numa_node, sizeof(int32_t), S_IRUGO,
+                 uio_pci_dma_sysfs_buffer_numa_node, NULL, NULL);
+
     UIO_DEBUG_PRINTF("uio_pci_dma_request_buffer_write size %llu\n",
         (priv->length * sizeof(struct scatterlist) ) );
 
@@ -588,6 +657,24 @@ BIN_ATTR_WRITE_CALLBACK( request_buffer_write )
     if(sysfs_create_bin_file(&priv->kobj, attr_bin_sg))
     { UIO_PDA_ERROR("Can't create entry for sg list exposing!\n", exit_binfile); }
 
+    /* Add entry to expose the flags (mapping mode) of the DMA buffer */
+    if(sysfs_create_bin_file(&priv->kobj, attr_bin_flags))
+    { UIO_PDA_ERROR("Can't create entry for buffer flags!\n", exit_binfile); }
+
+    /* Add entry to export the DMA buffer as dma-buf */
+    if(sysfs_create_bin_file(&priv->kobj, attr_bin_dmabuf))
+    { UIO_PDA_ERROR("Can't create entry for dma-buf export!\n", exit_binfile); }
+
+    /* Add entry to expose the generation number of the DMA buffer */
+    if(sysfs_create_bin_file(&priv->kobj, attr_bin_generation))
+    { UIO_PDA_ERROR("Can't create entry for buffer generation!\n", exit_binfile); }
+
+    /* Add entry to expose the NUMA node the memory was requested on */
+    if(sysfs_create_bin_file(&priv->kobj, attr_bin_numa_node))
+    { UIO_PDA_ERROR("Can't create entry for buffer NUMA node!\n", exit_binfile); }
+
+    uio_pci_dma_device_changed(kobj);
+
     kobject_uevent(&priv->kobj, KOBJ_ADD);
 
     mutex_unlock(&alloc_free_lock);
@@ -601,8 +688,32 @@ exit_binfile:
     attrib.attr.name = "sg";
     sysfs_remove_bin_file(&priv->kobj, &attrib);
 
+    attrib.attr.name = "flags";
+    sysfs_remove_bin_file(&priv->kobj, &attrib);
+
+    attrib.attr.name = "dmabuf";
+    sysfs_remove_bin_file(&priv->kobj, &attrib);
+
+    attrib.attr.name = "generation";
+    sysfs_remove_bin_file(&priv->kobj, &attrib);
+
+    attrib.attr.name = "numa_node";
+    sysfs_remove_bin_file(&priv->kobj, &attrib);
+
     kobject_del(&priv->kobj);
 
+    if(attr_bin_numa_node)
+    { kfree(attr_bin_numa_node); }
+
+    if(attr_bin_generation)
+    { kfree(attr_bin_generation); }
+
+    if(attr_bin_dmabuf)
+    { kfree(attr_bin_dmabuf); }
+
+    if(attr_bin_flags)
+    { kfree(attr_bin_flags); }
+
     if(attr_bin_sg)
     { kfree(attr_bin_sg);  }
 
@@ -747,16 +858,35 @@ uio_pci_dma_allocate_user_memory
 
     sg_init_table( (priv->sg), pages);
 
+    /* Physically consecutive pages (e.g. hugepages) are merged into one entry,
+     * as long as the entry stays below the maximum segment size of the device. */
+    size_t max_segment = dma_get_max_seg_size(priv->device) & PAGE_MASK;
+    if( (max_segment == 0) || (max_segment > (UINT_MAX & PAGE_MASK)) )
+    { max_segment = UINT_MAX & PAGE_MASK; }
+
     UIO_DEBUG_PRINTF("Put pages into scatter gather list\n");
+    priv->length = 0;
     uint64_t i;
     for(i=0; i<pages; i++)
     {
         struct page *current_page = priv->page_list[i];
-        sg_set_page( &priv->sg[i], current_page, PAGE_SIZE, 0);
+        if
+        (
+            (i > 0) &&
+            (page_to_pfn(current_page) == (page_to_pfn(priv->page_list[i-1]) + 1)) &&
+            ((priv->sg[priv->length - 1].length + PAGE_SIZE) <= max_segment)
+        )
+        { priv->sg[priv->length - 1].length += PAGE_SIZE; }
+        else
+        {
+            sg_set_page( &priv->sg[priv->length], current_page, PAGE_SIZE, 0);
+            priv->length++;
+        }
         #ifdef UIO_PDA_USE_PAGEFAULT_HANDLER
         priv->pfn_list[i] = page_to_pfn(current_page);
         #endif
     }
+    sg_mark_end(&priv->sg[priv->length - 1]);
 
     if(program_iommu(priv) == UIO_PCI_DMA_ERROR)
     { UIO_PDA_ERROR("SG list conversion failed!\n", exit); }
@@ -983,14 +1113,37 @@ BIN_ATTR_WRITE_CALLBACK( delete_buffer_write )
     KSET_FIND( kset_pointer, tmp_string, buffer_kobj );
     if(buffer_kobj != NULL)
     {
+        struct uio_pci_dma_private *priv =
+            container_of(buffer_kobj, struct uio_pci_dma_private, kobj);
+        if(priv->exports > 0)
+        {
+            printk(DRIVER_NAME " : buffer %s is still exported as dma-buf!\n", tmp_string);
+            mutex_unlock(&alloc_free_lock);
+            UIO_DEBUG_RETURN(-EBUSY);
+        }
+
         attrib.attr.name = "map";
         sysfs_remove_bin_file(buffer_kobj, &attrib);
 
         attrib.attr.name = "sg";
         sysfs_remove_bin_file(buffer_kobj, &attrib);
 
+        attrib.attr.name = "flags";
+        sysfs_remove_bin_file(buffer_kobj, &attrib);
+
+        attrib.attr.name = "dmabuf";
+        sysfs_remove_bin_file(buffer_kobj, &attrib);
+
+        attrib.attr.name = "generation";
+        sysfs_remove_bin_file(buffer_kobj, &attrib);
+
+        attrib.attr.name = "numa_node";
+        sysfs_remove_bin_file(buffer_kobj, &attrib);
+
         uio_pci_dma_free(buffer_kobj);
         kobject_del(buffer_kobj);
+
+        uio_pci_dma_device_changed(kobj);
     }
     else
     { printk(DRIVER_NAME " : freeing of buffer %s failed!\n", tmp_string); }
@@ -1117,6 +1270,98 @@ uio_mmap_ops =
 };
 #endif
 
+/*! \brief uio_pci_dma_pgprot
+ *         Page protection for a buffer mapping according to the mapping
+ *         mode requested on allocation. DMA is cache-coherent on x86, so
+ *         a write-back mapping is safe. */
+static inline pgprot_t
+uio_pci_dma_pgprot
+(
+    struct uio_pci_dma_private *priv,
+    pgprot_t                    prot
+)
+{
+    switch(priv->flags & UIO_PCI_DMA_MAP_MASK)
+    {
+        case UIO_PCI_DMA_MAP_CACHED : { return(prot); }
+        case UIO_PCI_DMA_MAP_WC     : { return(pgprot_writecombine(prot)); }
+        default                     : { return(pgprot_noncached(prot)); }
+    }
+}
+
+
+
+/*! \brief uio_pci_dma_mmap_buffer
+ *         Maps a buffer into a user space VMA, used by the map attribute
+ *         and by exported dma-bufs. The mapping starts at the page offset
+ *         of the VMA, mappings which run over the end of the buffer wrap
+ *         around. */
+static int
+uio_pci_dma_mmap_buffer
+(
+    struct uio_pci_dma_private *priv,
+    struct vm_area_struct      *vma
+)
+{
+    UIO_DEBUG_ENTER();
+
+    int ret = 0;
+
+    vma->vm_page_prot = uio_pci_dma_pgprot(priv, vma->vm_page_prot);
+
+#ifndef UIO_PDA_USE_PAGEFAULT_HANDLER
+    unsigned long       start        = vma->vm_start;
+    uint64_t            request_size = (vma->vm_end - vma->vm_start);
+    size_t              buffer_size  = priv->size;
+    struct scatterlist *sgp          = priv->sg;
+    size_t              mapped_size  = 0;
+    uint64_t            position     = ((uint64_t)vma->vm_pgoff << PAGE_SHIFT) % buffer_size;
+    uint64_t            skip         = position;
+
+    /** Find the entry which contains the start offset */
+    while(skip >= UIO_PCI_DMA_SG_LENGTH(sgp))
+    {
+        skip -= UIO_PCI_DMA_SG_LENGTH(sgp);
+        sgp   = sg_next(sgp);
+    }
+    position -= skip;
+
+    for(mapped_size = 0; mapped_size<request_size; )
+    {
+        unsigned long pfn = page_to_pfn( sg_page(sgp) ) + (skip >> PAGE_SHIFT);
+        uint64_t sg_size  = UIO_PCI_DMA_SG_LENGTH(sgp) - skip;
+        if(sg_size > (request_size - mapped_size))
+        { sg_size = request_size - mapped_size; }
+
+        if( (ret = remap_pfn_range(vma, start, pfn, sg_size, vma->vm_page_prot)) < 0)
+        { ret = UIO_PCI_DMA_ERROR; UIO_PDA_ERROR("Buffer mapping failed!\n", exit); }
+
+        start        = start + sg_size;
+        sgp          = sg_next(sgp);
+        mapped_size += sg_size;
+        position    += skip + sg_size;
+        skip         = 0;
+
+        /** Wrap if needed */
+        if(position >= buffer_size)
+        {
+            sgp      = priv->sg;
+            position = 0;
+        }
+    }
+#else
+    vma->vm_private_data  = priv;
+    vma->vm_flags        &= ~VM_PFNMAP;
+    vma->vm_flags        |= VM_MIXEDMAP;
+    vma->vm_ops           = &uio_mmap_ops;
+#endif
+
+exit:
+    UIO_DEBUG_RETURN(ret);
+}
+
+
+
 /*! \brief uio_pci_dma_map
  *         Callback function that gets called when someone mmaps the related
  *         map attribute. The user process needs to map the whole file. The
@@ -1150,44 +1395,117 @@ BIN_ATTR_MAP_CALLBACK( map )
                        "to MAP_SHARED or something similar.\n", exit);
     }
 
-#ifndef UIO_PDA_USE_PAGEFAULT_HANDLER
-    unsigned long       start        = vma->vm_start;
-    vma->vm_page_prot                = pgprot_noncached(vma->vm_page_prot);
-    uint64_t            request_size = (vma->vm_end - vma->vm_start);
-    size_t              buffer_size  = priv->size;
-    struct scatterlist *sgp          = priv->sg;
-    size_t              mapped_size  = 0;
-    for(mapped_size = 0; mapped_size<request_size; )
+    ret = uio_pci_dma_mmap_buffer(priv, vma);
+
+exit:
+    UIO_DEBUG_RETURN(ret);
+}
+
+
+
+#ifdef PDA_DMA_BUF
+/*! \brief dma-buf export
+ *         A buffer is exported as dma-buf by reading its dmabuf attribute,
+ *         which installs a new file descriptor in the reading process. The
+ *         descriptor can be passed to other processes, which map it without
+ *         any sysfs lookup, or be attached to other devices. Buffers can't be
+ *         freed as long as exports exist. */
+static struct sg_table*
+uio_pci_dma_dmabuf_map
+(
+    struct dma_buf_attachment *attachment,
+    enum dma_data_direction    direction
+)
+{
+    UIO_DEBUG_ENTER();
+
+    struct uio_pci_dma_private *priv  = attachment->dmabuf->priv;
+    struct sg_table            *table = kzalloc(sizeof(struct sg_table), GFP_KERNEL);
+    if(!table)
+    { UIO_PDA_ERROR("Allocation failed!\n", exit); }
+
+    if(sg_alloc_table(table, priv->length, GFP_KERNEL) != 0)
+    { UIO_PDA_ERROR("SG table allocation failed!\n", exit_table); }
+
+    /* Same order as the user space mapping */
+    struct scatterlist *src = priv->sg;
+    struct scatterlist *dst = NULL;
+    int                 i   = 0;
+    for_each_sg(table->sgl, dst, priv->length, i)
     {
-        unsigned long pfn = page_to_pfn( sg_page(sgp) );
-        uint64_t sg_size  =
+        uint64_t sg_size =
         #ifdef UIO_PDA_IOMMU
-            sg_dma_len(sgp);
+            sg_dma_len(src);
         #else
-            sgp->length;
+            src->length;
         #endif
-        if( (ret = remap_pfn_range(vma, start, pfn, sg_size, vma->vm_page_prot)) < 0)
-        { ret = UIO_PCI_DMA_ERROR; UIO_PDA_ERROR("Buffer mapping failed!\n", exit); }
+        sg_set_page(dst, sg_page(src), sg_size, 0);
+        src = sg_next(src);
+    }
 
-        start        = start + sg_size;
-        sgp          = sg_next(sgp);
-        mapped_size += sg_size;
+    if(dma_map_sgtable(attachment->dev, table, direction, 0) != 0)
+    { UIO_PDA_ERROR("Mapping for the importing device failed!\n", exit_sg); }
 
-        /** Wrap if needed */
-        if( (mapped_size % buffer_size) == 0 )
-        { sgp = priv->sg; }
-    }
-#else
-    vma->vm_private_data  = priv;
-    vma->vm_flags        &= ~VM_PFNMAP;
-    vma->vm_flags        |= VM_MIXEDMAP;
-    vma->vm_ops           = &uio_mmap_ops;
-#endif
+    UIO_DEBUG_RETURN(table);
+
+exit_sg:
+    sg_free_table(table);
+
+exit_table:
+    kfree(table);
 
 exit:
-    UIO_DEBUG_RETURN(ret);
+    UIO_DEBUG_RETURN(ERR_PTR(-ENOMEM));
 }
 
+static void
+uio_pci_dma_dmabuf_unmap
+(
+    struct dma_buf_attachment *attachment,
+    struct sg_table           *table,
+    enum dma_data_direction    direction
+)
+{
+    UIO_DEBUG_ENTER();
+
+    dma_unmap_sgtable(attachment->dev, table, direction, 0);
+    sg_free_table(table);
+    kfree(table);
+}
+
+static int
+uio_pci_dma_dmabuf_mmap
+(
+    struct dma_buf        *dmabuf,
+    struct vm_area_struct *vma
+)
+{
+    UIO_DEBUG_ENTER();
+    UIO_DEBUG_RETURN( uio_pci_dma_mmap_buffer(dmabuf->priv, vma) );
+}
+
+static void
+uio_pci_dma_dmabuf_release(struct dma_buf *dmabuf)
+{
+    UIO_DEBUG_ENTER();
+
+    struct uio_pci_dma_private *priv = dmabuf->priv;
+
+    mutex_lock(&alloc_free_lock);
+    priv->exports--;
+    mutex_unlock(&alloc_free_lock);
+}
+
+static const struct dma_buf_ops
+uio_pci_dma_dmabuf_ops =
+{
+    .map_dma_buf   = uio_pci_dma_dmabuf_map,
+    .unmap_dma_buf = uio_pci_dma_dmabuf_unmap,
+    .mmap          = uio_pci_dma_dmabuf_mmap,
+    .release       = uio_pci_dma_dmabuf_release
+};
+#endif /** PDA_DMA_BUF */
+
 
 
 /*! \brief uio_pci_dma_map_sg
@@ -1310,6 +1628,136 @@ BIN_ATTR_READ_CALLBACK( mps )
     UIO_DEBUG_RETURN(sizeof(int));
 }
 
+/*! \brief uio_pci_dma_sysfs_buffer_flags
+ *         Exposes the flags (mapping mode) a buffer was requested with, so
+ *         that processes which attach later can find out how it is mapped.
+ */
+BIN_ATTR_READ_CALLBACK( buffer_flags )
+{
+    UIO_DEBUG_ENTER();
+
+    struct uio_pci_dma_private *priv =
+        container_of(kobj, struct uio_pci_dma_private, kobj);
+
+    if( (offset != 0) || (count < sizeof(uint32_t)) )
+    { UIO_DEBUG_RETURN(0); }
+
+    memcpy(buffer, &priv->flags, sizeof(uint32_t));
+
+    UIO_DEBUG_RETURN(sizeof(uint32_t));
+}
+
+/*! \brief uio_pci_dma_sysfs_buffer_generation
+ *         Exposes a number which is unique for every buffer allocation, so
+ *         that user space can detect stale cached metadata after a buffer
+ *         was freed and allocated again under the same name.
+ */
+BIN_ATTR_READ_CALLBACK( buffer_generation )
+{
+    UIO_DEBUG_ENTER();
+
+    struct uio_pci_dma_private *priv =
+        container_of(kobj, struct uio_pci_dma_private, kobj);
+
+    if( (offset != 0) || (count < sizeof(uint64_t)) )
+    { UIO_DEBUG_RETURN(0); }
+
+    memcpy(buffer, &priv->generation, sizeof(uint64_t));
+
+    UIO_DEBUG_RETURN(sizeof(uint64_t));
+}
+
+/*! \brief uio_pci_dma_sysfs_buffer_numa_node
+ *         Exposes the NUMA node (int32_t) the buffer memory was requested
+ *         on, -1 if no node was given or the memory belongs to user space.
+ */
+BIN_ATTR_READ_CALLBACK( buffer_numa_node )
+{
+    UIO_DEBUG_ENTER();
+
+    struct uio_pci_dma_private *priv =
+        container_of(kobj, struct uio_pci_dma_private, kobj);
+
+    if( (offset != 0) || (count < sizeof(int32_t)) )
+    { UIO_DEBUG_RETURN(0); }
+
+    int32_t numa_node = (priv->start == 0) ? priv->numa_node : -1;
+    memcpy(buffer, &numa_node, sizeof(int32_t));
+
+    UIO_DEBUG_RETURN(sizeof(int32_t));
+}
+
+/*! \brief uio_pci_dma_sysfs_dma_generation
+ *         Exposes the generation number (uint64_t) of the device, which
+ *         changes whenever one of its buffers is allocated or freed. User
+ *         space can skip rescanning the "dma" folder while it is unchanged.
+ */
+BIN_ATTR_READ_CALLBACK( dma_generation )
+{
+    UIO_DEBUG_ENTER();
+
+    struct device *device
+        = container_of(kobj->parent, struct device, kobj);
+    struct uio_pci_dma_device *dma_device
+        = pci_get_drvdata(container_of(device, struct pci_dev, dev));
+
+    if( (offset != 0) || (count < sizeof(uint64_t)) || (dma_device == NULL) )
+    { UIO_DEBUG_RETURN(0); }
+
+    mutex_lock(&alloc_free_lock);
+    memcpy(buffer, &dma_device->generation, sizeof(uint64_t));
+    mutex_unlock(&alloc_free_lock);
+
+    UIO_DEBUG_RETURN(sizeof(uint64_t));
+}
+
+/*! \brief uio_pci_dma_sysfs_buffer_dmabuf
+ *         Exports the buffer as dma-buf and returns the new file descriptor
+ *         (int32_t), which is valid in the reading process.
+ */
+BIN_ATTR_READ_CALLBACK( buffer_dmabuf )
+{
+    UIO_DEBUG_ENTER();
+
+#ifdef PDA_DMA_BUF
+    struct uio_pci_dma_private *priv =
+        container_of(kobj, struct uio_pci_dma_private, kobj);
+
+    if( (offset != 0) || (count < sizeof(int32_t)) )
+    { UIO_DEBUG_RETURN(0); }
+
+    DEFINE_DMA_BUF_EXPORT_INFO(export_info);
+    export_info.exp_name = priv->exp_name;
+    export_info.ops      = &uio_pci_dma_dmabuf_ops;
+    export_info.size     = priv->size;
+    export_info.flags    = O_RDWR | O_CLOEXEC;
+    export_info.priv     = priv;
+
+    mutex_lock(&alloc_free_lock);
+    struct dma_buf *dmabuf = dma_buf_export(&export_info);
+    if(IS_ERR(dmabuf))
+    {
+        mutex_unlock(&alloc_free_lock);
+        UIO_DEBUG_RETURN(PTR_ERR(dmabuf));
+    }
+    priv->exports++;
+    mutex_unlock(&alloc_free_lock);
+
+    int32_t fd = dma_buf_fd(dmabuf, O_CLOEXEC);
+    if(fd < 0)
+    {
+        dma_buf_put(dmabuf);
+        UIO_DEBUG_RETURN(fd);
+    }
+
+    memcpy(buffer, &fd, sizeof(int32_t));
+
+    UIO_DEBUG_RETURN(sizeof(int32_t));
+#else
+    UIO_DEBUG_RETURN(-EOPNOTSUPP);
+#endif /** PDA_DMA_BUF */
+}
+
 /*! \brief uio_pci_dma_sysfs_readrq
  *
  */
@@ -1335,6 +1783,13 @@ module_init(mod_init);
 module_exit(mod_exit);
 
 MODULE_VERSION(UIO_PCI_DMA_VERSION);
+#ifdef PDA_DMA_BUF
+  #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    MODULE_IMPORT_NS("DMA_BUF");
+  #elif LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+    MODULE_IMPORT_NS(DMA_BUF);
+  #endif
+#endif /** PDA_DMA_BUF */
 MODULE_LICENSE(DRIVER_LICENSE);
 MODULE_AUTHOR(DRIVER_AUTHOR);
 MODULE_DESCRIPTION(DRIVER_DESC);
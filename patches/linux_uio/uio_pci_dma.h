@@ -48,7 +48,7 @@
 #define LINUX_VERSION_CODE KERNEL_VERSION(2,6,35)
 */
 
-#define UIO_PCI_DMA_VERSION "0.13.0"
+#define UIO_PCI_DMA_VERSION "0.20.0"
 #define UIO_PCI_DMA_MINOR   "0"
 
 #define UIO_PCI_DMA_SUCCESS 0
@@ -56,6 +56,15 @@
 
 #define UIO_PCI_DMA_BUFFER_NAME_SIZE 128
 
+/** Exported dma-bufs are named "<PCI device>/<buffer name>" */
+#define UIO_PCI_DMA_EXP_NAME_SIZE (UIO_PCI_DMA_BUFFER_NAME_SIZE + 32)
+
+/** Mapping modes, passed in the flags of a buffer request */
+#define UIO_PCI_DMA_MAP_UNCACHED 0x0
+#define UIO_PCI_DMA_MAP_WC       0x1
+#define UIO_PCI_DMA_MAP_CACHED   0x2
+#define UIO_PCI_DMA_MAP_MASK     0x3
+
 #define MB_SIZE 1048576
 
 #ifndef __KERNEL__
@@ -93,6 +102,7 @@ uio_pci_dma_private
     size_t     size;
     int32_t    numa_node;
     uint64_t   start;
+    uint32_t   flags;
 
     /* Kernel internal stuff */
     struct     kobject       kobj;
@@ -106,6 +116,9 @@ uio_pci_dma_private
     struct     device       *device;
     struct     page        **page_list;
     unsigned long           *pfn_list;
+    uint64_t                 exports;
+    uint64_t                 generation;
+    char                     exp_name[UIO_PCI_DMA_EXP_NAME_SIZE];
 };
 
 struct scatter
@@ -286,6 +299,11 @@ struct scatter
 BIN_ATTR_READ_CALLBACK( mps );
 BIN_ATTR_READ_CALLBACK( readrq );
 BIN_ATTR_READ_CALLBACK( mock );
+BIN_ATTR_READ_CALLBACK( buffer_flags );
+BIN_ATTR_READ_CALLBACK( buffer_dmabuf );
+BIN_ATTR_READ_CALLBACK( buffer_generation );
+BIN_ATTR_READ_CALLBACK( buffer_numa_node );
+BIN_ATTR_READ_CALLBACK( dma_generation );
 
 BIN_ATTR_WRITE_CALLBACK( request_buffer_write );
 BIN_ATTR_WRITE_CALLBACK( delete_buffer_write );
@@ -366,6 +384,16 @@ BIN_ATTR_MAP_CALLBACK( map_sg );
 #define PDA_MAX_PAGE_ORDER_INCLUSIVE
 #endif
 
+/**
+ * Buffers are exported as dma-buf with dma_map_sgtable(), which was introduced
+ * in kernel 5.8. Kernel 5.16 moves the dma-buf symbols into the DMA_BUF
+ * namespace and kernel 6.13 expects the namespace as a string.
+ **/
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 8, 0) || defined(RHEL_RELEASE_9_6)
+#define PDA_DMA_BUF
+#include <linux/dma-buf.h>
+#endif
+
 #endif /** __KERNEL__ */
 
 #endif /** UIO_PCI_DMA_H */
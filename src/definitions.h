@@ -38,6 +38,8 @@
 #ifndef UIO_DEFINITIONS_H
 #define UIO_DEFINITIONS_H
 
+#include <stdbool.h>
+
 #define UIO_SYSFS_DIR "/sys/bus/pci/drivers/uio_pci_generic"
 #define UIO_DMA_SYSFS_DIR "/sys/bus/pci/drivers/uio_pci_dma"
 
@@ -52,4 +54,7 @@
 // function  3 bit  1 hex/dec
 #define UIO_PATH_FORMAT "%04x:%02x:%02x.%1d"
 
+/* Set by PDASetForkProtection, defined in device_operator_inc.c */
+extern bool pda_fork_protection;
+
 #endif /*UIO_DEFINITIONS_H*/
@@ -56,31 +56,13 @@
 
 #include <definitions.h>
 #include <dma_buffer_int.h>
+#include <parallel_int.h>
 #include <pda.h>
 
 #include <uio_pci_dma.h>
 
 #include "config.h"
 
-typedef struct DMABufferInternal_struct DMABufferInternal;
-
-struct DMABuffer_struct
-{
-    PciDevice          *device;
-    pda_buffer_type     type;
-    uint64_t            index;
-    size_t              length;
-    void               *map;
-    void               *map_two;
-    DMABuffer_SGNode   *sglist;
-
-    DMABuffer          *next;
-    DMABuffer          *prev;
-
-    /* backend-dependend */
-    DMABufferInternal  *internal;
-};
-
 /*-system-dependend-----------------------------------------------------------------------*/
 
 #include "dma_buffer.inc"
@@ -93,73 +75,426 @@ DMABuffer_coalesqueSGlist(DMABuffer_SGNode **sglist_in)
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
     DMABuffer_SGNode *sglist = *sglist_in;
+    if(sglist == NULL)
+    { RETURN(PDA_SUCCESS); }
 
-    /** get the number of entries */
+    /** Merge consecutive entries in a single pass, the list is compacted in place */
     uint64_t number_entries = 0;
-    for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
-    { number_entries++; }
-    uint64_t new_number_entries = number_entries;
-
-    /** Coalesce consecutive entries */
+    uint64_t j              = 0;
     for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
     {
-        if( (sgtmp->length == 0) || (sgtmp->next == NULL) )
-        { continue; }
+        number_entries++;
 
-        if( (sgtmp->d_pointer + sgtmp->length) == sgtmp->next->d_pointer)
+        if( (j > 0) &&
+            ( (sglist[j - 1].d_pointer + sglist[j - 1].length) == sgtmp->d_pointer) &&
+            ( (sglist[j - 1].u_pointer + sglist[j - 1].length) == sgtmp->u_pointer) )
         {
-            sgtmp->length = sgtmp->length + sgtmp->next->length;
-            sgtmp->next->length = 0;
-            new_number_entries--;
+            sglist[j - 1].length += sgtmp->length;
+            continue;
         }
+
+        sglist[j] = sgtmp[0];
+        j++;
     }
 
-    /** Don't go into recursion if nothing changed this time */
-    if(number_entries == new_number_entries)
+    if(j == number_entries)
     { RETURN(PDA_SUCCESS); }
 
-    /** Allocate the new list */
-    DMABuffer_SGNode *new_sglist
-        = calloc(new_number_entries, sizeof(DMABuffer_SGNode) );
+    /** Shrink the list and readjust the pointers */
+    DMABuffer_SGNode *new_sglist = realloc(sglist, j * sizeof(DMABuffer_SGNode) );
+    if(new_sglist == NULL)
+    { new_sglist = sglist; }
 
-    /** Copy the stuff into a smaller list and ... */
-    uint64_t j = 0;
-    for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    for(uint64_t i = 0; i < j; i++)
     {
-        if(sgtmp->length == 0)
-        { continue; }
+        new_sglist[i].prev = (i == 0)       ? NULL : &new_sglist[i - 1];
+        new_sglist[i].next = (i == (j - 1)) ? NULL : &new_sglist[i + 1];
+    }
 
-        new_sglist[j] = sgtmp[0];
-        j++;
+    DEBUG_PRINTF(PDADEBUG_VALUE, "Coalesced %" PRIu64 " sg-entries into %" PRIu64 "\n",
+                 number_entries, j);
+
+    *sglist_in = new_sglist;
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+void
+DMABuffer_initSlice
+(
+    DMABuffer       *slice,
+    DMABuffer       *parent,
+    const size_t     offset,
+    const size_t     length
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    memset(slice, 0, sizeof(DMABuffer) );
+
+    slice->device   = parent->device;
+    slice->type     = PDA_BUFFER_SLICE;
+    slice->index    = parent->index;
+    slice->length   = length;
+    slice->map      = parent->map + offset;
+    slice->map_two  = MAP_FAILED;
+    slice->sglist   = NULL;
+    slice->parent   = parent;
+    slice->offset   = offset;
+    slice->internal = NULL;
+
+    DEBUG_PRINTF(PDADEBUG_EXIT, "");
+}
+
+
+
+void
+DMABuffer_freeSGList
+(
+    DMABuffer *buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer->translation != NULL)
+    {
+        free(buffer->translation);
+        buffer->translation = NULL;
     }
 
-    if(j != new_number_entries)
+    if(buffer->sglist != NULL)
     {
-        DEBUG_PRINTF(PDADEBUG_ERROR, "Invalid Number of entries!\n");
-        free(new_sglist);
-        RETURN(!PDA_SUCCESS);
+        free(buffer->sglist);
+        buffer->sglist = NULL;
     }
 
-    /** ... readjust the pointers */
-    for(uint64_t i = 0; i < j; i++)
+    DEBUG_PRINTF(PDADEBUG_EXIT, "");
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_slice
+(
+    DMABuffer     *buffer,
+    const size_t   offset,
+    const size_t   length,
+    DMABuffer    **view
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (view == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (length == 0) || (offset >= buffer->length) || (length > (buffer->length - offset)) )
+    { RETURN( ERROR(EINVAL, "Slice exceeds the buffer!\n") ); }
+
+    /** Slices of slices refer to the underlying buffer directly */
+    DMABuffer *parent        = buffer;
+    size_t     parent_offset = offset;
+    if(buffer->type == PDA_BUFFER_SLICE)
     {
-        if(i == 0)
-        { new_sglist[0].prev = NULL; }
-        else
-        { new_sglist[i].prev = &new_sglist[i - 1]; }
+        parent         = buffer->parent;
+        parent_offset += buffer->offset;
+    }
+
+    DMABuffer *slice = malloc(sizeof(DMABuffer) );
+    if(slice == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    DMABuffer_initSlice(slice, parent, parent_offset, length);
 
-        if(i == (j-1) )
-        { new_sglist[i].next = NULL; }
+    if(DMABuffer_sliceSGList(parent, parent_offset, length, &(slice->sglist) ) != PDA_SUCCESS)
+    {
+        free(slice);
+        RETURN( ERROR(EINVAL, "Generating the slice sg-list failed!\n") );
+    }
+
+    __atomic_fetch_add(&parent->references, 1, __ATOMIC_ACQ_REL);
+
+    *view = slice;
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_release
+(
+    DMABuffer *view
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(view == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(view->type != PDA_BUFFER_SLICE)
+    { RETURN( ERROR(EINVAL, "Only slices can be released!\n") ); }
+
+    __atomic_fetch_sub(&view->parent->references, 1, __ATOMIC_ACQ_REL);
+
+    DMABuffer_freeSGList(view);
+    free(view);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+/** Returns the largest i with array[i] <= value, array[0] <= value is assumed */
+static inline
+uint64_t
+DMABuffer_searchEntry
+(
+    const uint64_t *array,
+    const uint64_t  entries,
+    const uint64_t  value
+)
+{
+    uint64_t low  = 0;
+    uint64_t high = entries;
+    while( (high - low) > 1 )
+    {
+        uint64_t middle = low + ((high - low) / 2);
+        if(array[middle] <= value)
+        { low = middle; }
         else
-        { new_sglist[i].next = &new_sglist[i + 1]; }
+        { high = middle; }
     }
+    return(low);
+}
+
 
-    /** Free the old list, return the next list */
-    free(*sglist_in);
-    *sglist_in = new_sglist;
 
-    /**  ... go into recursion */
-    RETURN( DMABuffer_coalesqueSGlist(sglist_in) );
+typedef struct DMABufferBusEntry_struct
+{
+    uint64_t bus;
+    uint64_t entry;
+} DMABufferBusEntry;
+
+static int
+DMABuffer_compareBus(const void *a, const void *b)
+{
+    uint64_t bus_a = ((const DMABufferBusEntry*)a)->bus;
+    uint64_t bus_b = ((const DMABufferBusEntry*)b)->bus;
+    return( (bus_a > bus_b) - (bus_a < bus_b) );
+}
+
+
+
+DMABufferTranslation*
+DMABuffer_getTranslation
+(
+    DMABuffer *buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    DMABufferTranslation *translation =
+        __atomic_load_n(&buffer->translation, __ATOMIC_ACQUIRE);
+    if(translation != NULL)
+    { RETURN(translation); }
+
+    DMABuffer_SGNode *sglist = NULL;
+    if( (DMABuffer_getSGList(buffer, &sglist) != PDA_SUCCESS) || (sglist == NULL) )
+    { RETURN(NULL); }
+
+    uint64_t entries = 0;
+    for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    { entries++; }
+
+    /** All tables live in one allocation behind the header */
+    translation =
+        malloc(sizeof(DMABufferTranslation) + ( ( (4 * entries) + 1) * sizeof(uint64_t) ) );
+    DMABufferBusEntry *sorted = calloc(entries, sizeof(DMABufferBusEntry) );
+    if( (translation == NULL) || (sorted == NULL) )
+    {
+        free(translation);
+        free(sorted);
+        RETURN(NULL);
+    }
+
+    translation->entries      = entries;
+    translation->offsets      = (uint64_t*)(translation + 1);
+    translation->bus          = translation->offsets + entries + 1;
+    translation->sorted_bus   = translation->bus + entries;
+    translation->sorted_entry = translation->sorted_bus + entries;
+
+    uint64_t i      = 0;
+    uint64_t offset = 0;
+    for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    {
+        translation->offsets[i] = offset;
+        translation->bus[i]     = (uint64_t)sgtmp->d_pointer;
+        sorted[i].bus           = (uint64_t)sgtmp->d_pointer;
+        sorted[i].entry         = i;
+        offset += sgtmp->length;
+        i++;
+    }
+    translation->offsets[entries] = offset;
+
+    qsort(sorted, entries, sizeof(DMABufferBusEntry), DMABuffer_compareBus);
+    for(i = 0; i < entries; i++)
+    {
+        translation->sorted_bus[i]   = sorted[i].bus;
+        translation->sorted_entry[i] = sorted[i].entry;
+    }
+    free(sorted);
+
+    /** Another thread may have been faster */
+    DMABufferTranslation *expected = NULL;
+    if
+    (
+        !__atomic_compare_exchange_n(&buffer->translation, &expected, translation,
+                                     false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+    )
+    {
+        free(translation);
+        translation = expected;
+    }
+
+    RETURN(translation);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_sliceSGList
+(
+    DMABuffer         *parent,
+    const size_t       offset,
+    const size_t       length,
+    DMABuffer_SGNode **sglist
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (length == 0) || ((offset + length) > parent->length) )
+    { RETURN( ERROR(EINVAL, "Slice exceeds the parent buffer!\n") ); }
+
+    DMABufferTranslation *translation = DMABuffer_getTranslation(parent);
+    if(translation == NULL)
+    { RETURN( ERROR(EINVAL, "Loading the parent sg-list failed!\n") ); }
+
+    if(translation->offsets[translation->entries] < (offset + length) )
+    { RETURN( ERROR(EINVAL, "Sg-list does not cover the slice!\n") ); }
+
+    /** The parent sg-list is an array, the first and last entry are found by binary search */
+    uint64_t first =
+        DMABuffer_searchEntry(translation->offsets, translation->entries, offset);
+    uint64_t last  =
+        DMABuffer_searchEntry(translation->offsets, translation->entries, offset + length - 1);
+    uint64_t entries = last - first + 1;
+
+    DMABuffer_SGNode *new_sglist = calloc(entries, sizeof(DMABuffer_SGNode) );
+    if(new_sglist == NULL)
+    { RETURN( ERROR(ENOMEM, "Allocating sg-list failed!\n") ); }
+
+    /** Trim the first and the last entry to the slice boundaries */
+    size_t            skip  = offset - translation->offsets[first];
+    size_t            left  = length;
+    DMABuffer_SGNode *sgtmp = &parent->sglist[first];
+    for(uint64_t i = 0; i < entries; i++)
+    {
+        size_t chunk = sgtmp->length - skip;
+        if(chunk > left)
+        { chunk = left; }
+
+        new_sglist[i].length    = chunk;
+        new_sglist[i].u_pointer = sgtmp->u_pointer + skip;
+        new_sglist[i].d_pointer = sgtmp->d_pointer + skip;
+        new_sglist[i].k_pointer = sgtmp->k_pointer;
+        new_sglist[i].prev      = (i == 0) ? NULL : &new_sglist[i - 1];
+        new_sglist[i].next      = (i == (entries - 1) ) ? NULL : &new_sglist[i + 1];
+
+        left  -= chunk;
+        skip   = 0;
+        sgtmp  = sgtmp->next;
+    }
+
+    *sglist = new_sglist;
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+static inline
+PdaDebugReturnCode
+DMABuffer_translateVirt
+(
+    const DMABuffer            *buffer,
+    const DMABufferTranslation *translation,
+    const void                 *virt,
+    uint64_t                   *hint,
+    uint64_t                   *bus
+)
+{
+    const uint8_t *pointer = (const uint8_t*)virt;
+    const uint8_t *map     = (const uint8_t*)buffer->map;
+    const uint8_t *map_two = (const uint8_t*)buffer->map_two;
+    uint64_t       offset  = 0;
+
+    if( (pointer >= map) && (pointer < (map + buffer->length) ) )
+    { offset = pointer - map; }
+    else if( (buffer->map_two != MAP_FAILED) && (map_two != NULL) &&
+             (pointer >= map_two) && (pointer < (map_two + buffer->length) ) )
+    { offset = pointer - map_two; }
+    else
+    { return(EINVAL); }
+
+    /** Consecutive addresses usually hit the same entry */
+    uint64_t entry = *hint;
+    if( (offset < translation->offsets[entry]) || (offset >= translation->offsets[entry + 1]) )
+    {
+        if(offset >= translation->offsets[translation->entries])
+        { return(EINVAL); }
+
+        entry = DMABuffer_searchEntry(translation->offsets, translation->entries, offset);
+        *hint = entry;
+    }
+
+    *bus = translation->bus[entry] + (offset - translation->offsets[entry]);
+    return(PDA_SUCCESS);
+}
+
+
+
+static inline
+PdaDebugReturnCode
+DMABuffer_translateBus
+(
+    const DMABuffer            *buffer,
+    const DMABufferTranslation *translation,
+    const uint64_t              bus,
+    uint64_t                   *hint,
+    void                      **virt
+)
+{
+    uint64_t sorted = *hint;
+    uint64_t entry  = translation->sorted_entry[sorted];
+    uint64_t start  = translation->sorted_bus[sorted];
+    uint64_t size   = translation->offsets[entry + 1] - translation->offsets[entry];
+
+    if( (bus < start) || (bus >= (start + size) ) )
+    {
+        if(bus < translation->sorted_bus[0])
+        { return(EINVAL); }
+
+        sorted = DMABuffer_searchEntry(translation->sorted_bus, translation->entries, bus);
+        entry  = translation->sorted_entry[sorted];
+        start  = translation->sorted_bus[sorted];
+        size   = translation->offsets[entry + 1] - translation->offsets[entry];
+        if(bus >= (start + size) )
+        { return(EINVAL); }
+
+        *hint = sorted;
+    }
+
+    *virt = (uint8_t*)buffer->map + translation->offsets[entry] + (bus - start);
+    return(PDA_SUCCESS);
 }
 
 
@@ -172,11 +507,7 @@ DMABuffer_delete(DMABuffer *buffer)
     if(buffer == NULL)
     { goto exit; }
 
-    if(buffer->sglist != NULL)
-    {
-        free(buffer->sglist);
-        buffer->sglist = NULL;
-    }
+    DMABuffer_freeSGList(buffer);
 
     if( (buffer->prev != NULL) && (buffer->next != NULL) )
     {
@@ -354,16 +685,250 @@ DMABuffer_getSGList
     DMABuffer *buf = (DMABuffer*)buffer;
 
     if(buf->sglist == NULL)
-    { ret += DMABuffer_loadSGList(buf, buf->device); }
+    {
+        if(buf->type == PDA_BUFFER_SLICE)
+        { ret += DMABuffer_sliceSGList(buf->parent, buf->offset, buf->length, &(buf->sglist) ); }
+        else
+        { ret += DMABuffer_loadSGList(buf, buf->device); }
+    }
 
     *sglist = buf->sglist;
 
     RETURN(ret);
 }
 
+
+
+PdaDebugReturnCode
+DMABuffer_getSGEntries
+(
+    const DMABuffer *buffer,
+    uint64_t        *entries
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (entries == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABuffer_SGNode *sglist = NULL;
+    if(DMABuffer_getSGList(buffer, &sglist) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Loading sg-list failed!\n") ); }
+
+    *entries = 0;
+    for(DMABuffer_SGNode *sgtmp = sglist; sgtmp != NULL; sgtmp = sgtmp->next)
+    { (*entries)++; }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_virtToBus
+(
+    const DMABuffer *buffer,
+    const void      *virt,
+    uint64_t        *bus
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    RETURN( DMABuffer_virtToBusBatch(buffer, &virt, bus, 1) );
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_busToVirt
+(
+    const DMABuffer  *buffer,
+    const uint64_t    bus,
+    void            **virt
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    RETURN( DMABuffer_busToVirtBatch(buffer, &bus, virt, 1) );
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_virtToBusBatch
+(
+    const DMABuffer   *buffer,
+    const void *const *virt,
+    uint64_t          *bus,
+    const uint64_t     count
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (virt == NULL) || (bus == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    const DMABufferTranslation *translation = DMABuffer_getTranslation( (DMABuffer*)buffer );
+    if(translation == NULL)
+    { RETURN( ERROR(EINVAL, "Building the translation table failed!\n") ); }
+
+    PdaDebugReturnCode ret  = PDA_SUCCESS;
+    uint64_t           hint = 0;
+    for(uint64_t i = 0; i < count; i++)
+    {
+        if(DMABuffer_translateVirt(buffer, translation, virt[i], &hint, &bus[i]) != PDA_SUCCESS)
+        {
+            bus[i] = 0;
+            ret    = EINVAL;
+        }
+    }
+
+    RETURN(ret);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_busToVirtBatch
+(
+    const DMABuffer  *buffer,
+    const uint64_t   *bus,
+    void            **virt,
+    const uint64_t    count
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (bus == NULL) || (virt == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    const DMABufferTranslation *translation = DMABuffer_getTranslation( (DMABuffer*)buffer );
+    if(translation == NULL)
+    { RETURN( ERROR(EINVAL, "Building the translation table failed!\n") ); }
+
+    PdaDebugReturnCode ret  = PDA_SUCCESS;
+    uint64_t           hint = 0;
+    for(uint64_t i = 0; i < count; i++)
+    {
+        if(DMABuffer_translateBus(buffer, translation, bus[i], &hint, &virt[i]) != PDA_SUCCESS)
+        {
+            virt[i] = NULL;
+            ret     = EINVAL;
+        }
+    }
+
+    RETURN(ret);
+}
+
+
+
+/** Work description for touching the pages of a mapping in parallel */
+typedef struct DMABufferPopulate_struct
+{
+    volatile uint8_t *map[2];
+    size_t            length;
+    size_t            page_size;
+} DMABufferPopulate;
+
+static void
+DMABuffer_populateWorker
+(
+    void           *context,
+    const uint64_t  thread,
+    const uint64_t  threads
+)
+{
+    DMABufferPopulate *work  = (DMABufferPopulate*)context;
+    uint64_t           pages = work->length / work->page_size;
+
+    /** Each thread takes a consecutive share of pages, a read fault is enough to insert them */
+    uint64_t first = (pages * thread) / threads;
+    uint64_t last  = (pages * (thread + 1)) / threads;
+    for(uint8_t m = 0; m < 2; m++)
+    {
+        if(work->map[m] == NULL)
+        { continue; }
+
+        for(uint64_t page = first; page < last; page++)
+        { (void)work->map[m][page * work->page_size]; }
+    }
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_populate
+(
+    DMABuffer      *buffer,
+    const uint64_t  threads
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (buffer->map == MAP_FAILED) || (buffer->map == NULL) )
+    { RETURN( ERROR(EINVAL, "Buffer is not mapped!\n") ); }
+
+    DMABufferPopulate work =
+    {
+        .map       = { (volatile uint8_t*)buffer->map, NULL },
+        .length    = buffer->length,
+        .page_size = (size_t)sysconf(_SC_PAGESIZE)
+    };
+
+    if( (buffer->map_two != MAP_FAILED) && (buffer->map_two != NULL) )
+    { work.map[1] = (volatile uint8_t*)buffer->map_two; }
+
+    int32_t numa_node = -1;
+    #ifdef NUMA_AVAIL
+    if(buffer->device != NULL)
+    { numa_node = PciDevice_getNumaNode(buffer->device); }
+    #endif /* NUMA_AVAIL */
+
+    uint64_t start = DMABuffer_timeNs();
+
+    if(pda_parallelRun(pda_parallelThreads(threads, work.length / work.page_size, numa_node),
+                       numa_node, DMABuffer_populateWorker, &work) != PDA_SUCCESS)
+    { RETURN( ERROR(EFAULT, "Populating the mapping failed!\n") ); }
+
+    buffer->populate_time = DMABuffer_timeNs() - start;
+
+    DEBUG_PRINTF(PDADEBUG_VALUE, "Populated %zu bytes in %" PRIu64 " ns\n",
+                 buffer->length, buffer->populate_time);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_getCacheMode
+(
+    const DMABuffer *buffer,
+    uint64_t        *mode
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (mode == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    const DMABuffer *mapped = (buffer->type == PDA_BUFFER_SLICE) ? buffer->parent : buffer;
+    *mode = mapped->flags & PDA_BUFFER_MAP_MASK;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
 DMA_BUFFER_GET_FUNCTION( next, Next, DMABuffer **next );
 DMA_BUFFER_GET_FUNCTION( prev, Prev, DMABuffer **prev );
 DMA_BUFFER_GET_FUNCTION( map, Map, void **map);
 DMA_BUFFER_GET_FUNCTION( map_two, MapTwo, void **map_two );
 DMA_BUFFER_GET_FUNCTION( length, Length, size_t *length );
 DMA_BUFFER_GET_FUNCTION( index, Index, uint64_t *index);
+DMA_BUFFER_GET_FUNCTION( offset, Offset, size_t *offset);
+DMA_BUFFER_GET_FUNCTION( flags, Flags, uint64_t *flags);
+DMA_BUFFER_GET_FUNCTION( populate_time, PopulateTime, uint64_t *populate_time);
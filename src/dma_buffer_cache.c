@@ -0,0 +1,594 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+
+#include "config.h"
+
+/** Idle registrations are kept until they exceed this size */
+#define PDA_REGISTRATION_CACHE_IDLE (1024UL * 1024UL * 1024UL)
+
+/**
+ * One registration. Entries are kept in an AVL tree ordered by start address,
+ * each node knows the largest end address in its subtree (interval tree).
+ */
+typedef struct DMABufferCacheEntry_struct DMABufferCacheEntry;
+struct DMABufferCacheEntry_struct
+{
+    uintptr_t            start;
+    uintptr_t            end;
+    DMABuffer           *buffer;
+    uint64_t             users;
+    bool                 stale;
+
+    DMABufferCacheEntry *left;
+    DMABufferCacheEntry *right;
+    uintptr_t            max_end;
+    int32_t              height;
+
+    /** Idle entries, least recently used first */
+    DMABufferCacheEntry *idle_prev;
+    DMABufferCacheEntry *idle_next;
+
+    /** All entries, also stale ones which left the tree */
+    DMABufferCacheEntry *next;
+};
+
+struct DMABufferCache_struct
+{
+    pthread_mutex_t      lock;
+    DMABufferCacheEntry *root;
+    DMABufferCacheEntry *entries;
+    DMABufferCacheEntry *idle_first;
+    DMABufferCacheEntry *idle_last;
+    uint64_t             idle_bytes;
+};
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline int32_t
+DMABufferCache_height(const DMABufferCacheEntry *node)
+{ return( (node == NULL) ? 0 : node->height ); }
+
+
+
+static inline void
+DMABufferCache_update(DMABufferCacheEntry *node)
+{
+    int32_t left  = DMABufferCache_height(node->left);
+    int32_t right = DMABufferCache_height(node->right);
+    node->height  = 1 + ( (left > right) ? left : right );
+
+    node->max_end = node->end;
+    if( (node->left != NULL) && (node->left->max_end > node->max_end) )
+    { node->max_end = node->left->max_end; }
+    if( (node->right != NULL) && (node->right->max_end > node->max_end) )
+    { node->max_end = node->right->max_end; }
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_rotateRight(DMABufferCacheEntry *node)
+{
+    DMABufferCacheEntry *pivot = node->left;
+    node->left   = pivot->right;
+    pivot->right = node;
+    DMABufferCache_update(node);
+    DMABufferCache_update(pivot);
+    return(pivot);
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_rotateLeft(DMABufferCacheEntry *node)
+{
+    DMABufferCacheEntry *pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    DMABufferCache_update(node);
+    DMABufferCache_update(pivot);
+    return(pivot);
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_balance(DMABufferCacheEntry *node)
+{
+    DMABufferCache_update(node);
+    int32_t factor = DMABufferCache_height(node->left) - DMABufferCache_height(node->right);
+
+    if(factor > 1)
+    {
+        if(DMABufferCache_height(node->left->left) < DMABufferCache_height(node->left->right) )
+        { node->left = DMABufferCache_rotateLeft(node->left); }
+        return(DMABufferCache_rotateRight(node) );
+    }
+
+    if(factor < -1)
+    {
+        if(DMABufferCache_height(node->right->right) < DMABufferCache_height(node->right->left) )
+        { node->right = DMABufferCache_rotateRight(node->right); }
+        return(DMABufferCache_rotateLeft(node) );
+    }
+
+    return(node);
+}
+
+
+
+/** Entries with the same start are ordered by their address */
+static inline bool
+DMABufferCache_less
+(
+    const DMABufferCacheEntry *a,
+    const DMABufferCacheEntry *b
+)
+{
+    if(a->start != b->start)
+    { return(a->start < b->start); }
+    return( (uintptr_t)a < (uintptr_t)b );
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_insert
+(
+    DMABufferCacheEntry *node,
+    DMABufferCacheEntry *entry
+)
+{
+    if(node == NULL)
+    {
+        entry->left  = NULL;
+        entry->right = NULL;
+        DMABufferCache_update(entry);
+        return(entry);
+    }
+
+    if(DMABufferCache_less(entry, node) )
+    { node->left = DMABufferCache_insert(node->left, entry); }
+    else
+    { node->right = DMABufferCache_insert(node->right, entry); }
+
+    return(DMABufferCache_balance(node) );
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_removeMin
+(
+    DMABufferCacheEntry  *node,
+    DMABufferCacheEntry **min
+)
+{
+    if(node->left == NULL)
+    {
+        *min = node;
+        return(node->right);
+    }
+
+    node->left = DMABufferCache_removeMin(node->left, min);
+    return(DMABufferCache_balance(node) );
+}
+
+
+
+static DMABufferCacheEntry*
+DMABufferCache_remove
+(
+    DMABufferCacheEntry *node,
+    DMABufferCacheEntry *entry
+)
+{
+    if(node == NULL)
+    { return(NULL); }
+
+    if(node != entry)
+    {
+        if(DMABufferCache_less(entry, node) )
+        { node->left = DMABufferCache_remove(node->left, entry); }
+        else
+        { node->right = DMABufferCache_remove(node->right, entry); }
+        return(DMABufferCache_balance(node) );
+    }
+
+    if(node->right == NULL)
+    { return(node->left); }
+
+    DMABufferCacheEntry *successor = NULL;
+    DMABufferCacheEntry *right     = DMABufferCache_removeMin(node->right, &successor);
+    successor->left  = node->left;
+    successor->right = right;
+    return(DMABufferCache_balance(successor) );
+}
+
+
+
+/** Find a registration which covers [start, end) completely */
+static DMABufferCacheEntry*
+DMABufferCache_findCovering
+(
+    DMABufferCacheEntry *node,
+    const uintptr_t      start,
+    const uintptr_t      end
+)
+{
+    if( (node == NULL) || (node->max_end < end) )
+    { return(NULL); }
+
+    DMABufferCacheEntry *found = DMABufferCache_findCovering(node->left, start, end);
+    if(found != NULL)
+    { return(found); }
+
+    /** The right subtree only has larger start addresses */
+    if(node->start > start)
+    { return(NULL); }
+
+    if(node->end >= end)
+    { return(node); }
+
+    return(DMABufferCache_findCovering(node->right, start, end) );
+}
+
+
+
+/** Find any registration which overlaps [start, end) */
+static DMABufferCacheEntry*
+DMABufferCache_findOverlapping
+(
+    DMABufferCacheEntry *node,
+    const uintptr_t      start,
+    const uintptr_t      end
+)
+{
+    if( (node == NULL) || (node->max_end <= start) )
+    { return(NULL); }
+
+    DMABufferCacheEntry *found = DMABufferCache_findOverlapping(node->left, start, end);
+    if(found != NULL)
+    { return(found); }
+
+    if(node->start >= end)
+    { return(NULL); }
+
+    if(node->end > start)
+    { return(node); }
+
+    return(DMABufferCache_findOverlapping(node->right, start, end) );
+}
+
+
+
+static void
+DMABufferCache_idleRemove
+(
+    DMABufferCache      *cache,
+    DMABufferCacheEntry *entry
+)
+{
+    if(entry->idle_prev != NULL)
+    { entry->idle_prev->idle_next = entry->idle_next; }
+    else
+    { cache->idle_first = entry->idle_next; }
+
+    if(entry->idle_next != NULL)
+    { entry->idle_next->idle_prev = entry->idle_prev; }
+    else
+    { cache->idle_last = entry->idle_prev; }
+
+    entry->idle_prev   = NULL;
+    entry->idle_next   = NULL;
+    cache->idle_bytes -= entry->end - entry->start;
+}
+
+
+
+static void
+DMABufferCache_idleAppend
+(
+    DMABufferCache      *cache,
+    DMABufferCacheEntry *entry
+)
+{
+    entry->idle_prev = cache->idle_last;
+    entry->idle_next = NULL;
+
+    if(cache->idle_last != NULL)
+    { cache->idle_last->idle_next = entry; }
+    else
+    { cache->idle_first = entry; }
+
+    cache->idle_last   = entry;
+    cache->idle_bytes += entry->end - entry->start;
+}
+
+
+
+/** Deregister an unused entry, it must not be in the idle list any more */
+static PdaDebugReturnCode
+DMABufferCache_drop
+(
+    DMABufferCache      *cache,
+    DMABufferCacheEntry *entry
+)
+{
+    if(!entry->stale)
+    { cache->root = DMABufferCache_remove(cache->root, entry); }
+
+    DMABufferCacheEntry **link = &cache->entries;
+    while(*link != entry)
+    { link = &(*link)->next; }
+    *link = entry->next;
+
+    PdaDebugReturnCode ret = PciDevice_deleteDMABuffer(entry->buffer->device, entry->buffer);
+    free(entry);
+    return(ret);
+}
+
+
+
+/** Deregister the least recently used idle entries beyond the cache limit */
+static PdaDebugReturnCode
+DMABufferCache_evict(DMABufferCache *cache)
+{
+    PdaDebugReturnCode ret = PDA_SUCCESS;
+
+    while(cache->idle_bytes > PDA_REGISTRATION_CACHE_IDLE)
+    {
+        DMABufferCacheEntry *entry = cache->idle_first;
+        DMABufferCache_idleRemove(cache, entry);
+        if(DMABufferCache_drop(cache, entry) != PDA_SUCCESS)
+        { ret = EFAULT; }
+    }
+
+    return(ret);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABufferCache_new
+(
+    DMABufferCache **cache
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    DMABufferCache *new_cache = calloc(1, sizeof(DMABufferCache) );
+    if(new_cache == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    pthread_mutex_init(&new_cache->lock, NULL);
+    *cache = new_cache;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+void
+DMABufferCache_delete
+(
+    DMABufferCache *cache
+)
+{
+    if(cache == NULL)
+    { return; }
+
+    /** The registrations themselves are freed together with the buffer list */
+    DMABufferCacheEntry *entry = cache->entries;
+    while(entry != NULL)
+    {
+        DMABufferCacheEntry *next = entry->next;
+        free(entry);
+        entry = next;
+    }
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+
+
+PdaDebugReturnCode
+DMABufferCache_register
+(
+    DMABufferCache  *cache,
+    PciDevice       *device,
+    void            *start,
+    const size_t     size,
+    DMABuffer      **view
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin     = (uintptr_t)start;
+    uintptr_t end       = begin + size;
+
+    if( (size == 0) || (end < begin) )
+    { RETURN( ERROR(EINVAL, "Invalid range!\n") ); }
+
+    pthread_mutex_lock(&cache->lock);
+
+    DMABufferCacheEntry *entry = DMABufferCache_findCovering(cache->root, begin, end);
+    if(entry == NULL)
+    {
+        entry = calloc(1, sizeof(DMABufferCacheEntry) );
+        if(entry == NULL)
+        {
+            pthread_mutex_unlock(&cache->lock);
+            RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") );
+        }
+
+        entry->start = begin & ~(page_size - 1);
+        entry->end   = (end + page_size - 1) & ~(page_size - 1);
+
+        if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, (void*)entry->start,
+            entry->end - entry->start, &entry->buffer) != PDA_SUCCESS)
+        {
+            free(entry);
+            pthread_mutex_unlock(&cache->lock);
+            RETURN( ERROR(EFAULT, "Registering the range failed!\n") );
+        }
+
+        cache->root    = DMABufferCache_insert(cache->root, entry);
+        entry->next    = cache->entries;
+        cache->entries = entry;
+    }
+    else if(entry->users == 0)
+    { DMABufferCache_idleRemove(cache, entry); }
+
+    entry->users++;
+
+    PdaDebugReturnCode ret = DMABuffer_slice(entry->buffer, begin - entry->start, size, view);
+    if(ret != PDA_SUCCESS)
+    {
+        if(--entry->users == 0)
+        {
+            DMABufferCache_idleAppend(cache, entry);
+            ret += DMABufferCache_evict(cache);
+        }
+        pthread_mutex_unlock(&cache->lock);
+        RETURN( ERROR(ret, "Creating the view failed!\n") );
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABufferCache_release
+(
+    DMABufferCache *cache,
+    DMABuffer      *view
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    pthread_mutex_lock(&cache->lock);
+
+    DMABufferCacheEntry *entry = cache->entries;
+    while( (entry != NULL) && (entry->buffer != view->parent) )
+    { entry = entry->next; }
+
+    if( (entry == NULL) || (DMABuffer_release(view) != PDA_SUCCESS) )
+    {
+        pthread_mutex_unlock(&cache->lock);
+        RETURN( ERROR(EINVAL, "Not a cached registration!\n") );
+    }
+
+    PdaDebugReturnCode ret = PDA_SUCCESS;
+    if(--entry->users == 0)
+    {
+        /** Invalidated ranges are deregistered as soon as nobody uses them */
+        if(entry->stale)
+        { ret = DMABufferCache_drop(cache, entry); }
+        else
+        {
+            DMABufferCache_idleAppend(cache, entry);
+            ret = DMABufferCache_evict(cache);
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Deregistration failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABufferCache_invalidate
+(
+    DMABufferCache *cache,
+    const void     *start,
+    const size_t    size
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uintptr_t          begin = (uintptr_t)start;
+    uintptr_t          end   = begin + size;
+    PdaDebugReturnCode ret   = PDA_SUCCESS;
+
+    pthread_mutex_lock(&cache->lock);
+
+    DMABufferCacheEntry *entry = NULL;
+    while( (entry = DMABufferCache_findOverlapping(cache->root, begin, end) ) != NULL)
+    {
+        if(entry->users == 0)
+        {
+            DMABufferCache_idleRemove(cache, entry);
+            if(DMABufferCache_drop(cache, entry) != PDA_SUCCESS)
+            { ret = EFAULT; }
+        }
+        else
+        {
+            /** Views in use keep their pages, but new lookups must not find them */
+            cache->root  = DMABufferCache_remove(cache->root, entry);
+            entry->stale = true;
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Deregistration failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,662 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dma_buffer_int.h>
+#include <parallel_int.h>
+#include <pda.h>
+
+#include "config.h"
+
+#if defined(__x86_64__)
+    #include <immintrin.h>
+    #define DMA_BUFFER_CRC32C_HW_AVAIL
+#endif
+
+/** CRC32C (Castagnoli) polynomial in reflected bit order */
+#define DMA_BUFFER_CRC32C_POLY  0x82F63B78
+/** Length of each of the three interleaved hardware CRC streams */
+#define DMA_BUFFER_CRC32C_BLOCK 4096
+/** Ranges are only split into parts of at least this length */
+#define DMA_BUFFER_CHECKSUM_PART (1024 * 1024)
+
+#define DMA_BUFFER_ADLER32_BASE 65521
+/** Largest n such that 255n(n+1)/2 + (n+1)(BASE-1) fits into 32 bits */
+#define DMA_BUFFER_ADLER32_NMAX 5552
+
+#define DMA_BUFFER_XXH64_PRIME1 11400714785074694791ULL
+#define DMA_BUFFER_XXH64_PRIME2 14029467366897019727ULL
+#define DMA_BUFFER_XXH64_PRIME3 1609587929392839161ULL
+#define DMA_BUFFER_XXH64_PRIME4 9650029242287828579ULL
+#define DMA_BUFFER_XXH64_PRIME5 2870177450012600261ULL
+
+/** Streaming state of XXH64, the data of a wrapped range arrives in two parts */
+typedef struct DMABufferXXH64_struct
+{
+    uint64_t total;
+    uint64_t v[4];
+    uint8_t  memory[32];
+    uint64_t stored;
+} DMABufferXXH64;
+
+/** Tables for the CRC32C software fallback and for combining CRCs */
+static pthread_once_t dma_buffer_crc32c_once = PTHREAD_ONCE_INIT;
+static uint32_t       dma_buffer_crc32c_table[256];
+static uint32_t       dma_buffer_crc32c_x2n[32];
+static uint32_t       dma_buffer_crc32c_block_shift[2];
+
+/** Work of a checksum which is split over several threads */
+typedef struct DMABufferChecksum_struct
+{
+    const DMABuffer *buffer;
+    size_t           offset;
+    size_t           length;
+    size_t           buffer_length;
+    size_t           part_length;
+    uint64_t         algorithm;
+    uint64_t         partial[PDA_PARALLEL_MAX_THREADS];
+    size_t           partial_length[PDA_PARALLEL_MAX_THREADS];
+    bool             failed;
+} DMABufferChecksum;
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline uint64_t
+DMABuffer_read64(const uint8_t *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value) );
+    return(value);
+}
+
+
+
+static inline uint32_t
+DMABuffer_read32(const uint8_t *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value) );
+    return(value);
+}
+
+
+
+/** Multiply a and b modulo the CRC32C polynomial */
+static uint32_t
+DMABuffer_crc32cMultiply
+(
+    uint32_t a,
+    uint32_t b
+)
+{
+    uint32_t m = 1U << 31;
+    uint32_t p = 0;
+
+    for(;;)
+    {
+        if(a & m)
+        {
+            p ^= b;
+            if( (a & (m - 1)) == 0 )
+            { break; }
+        }
+        m >>= 1;
+        b  = (b & 1) ? ( (b >> 1) ^ DMA_BUFFER_CRC32C_POLY ) : (b >> 1);
+    }
+
+    return(p);
+}
+
+
+
+/** x^(8 * length) modulo the CRC32C polynomial, the operator to append length zero bytes */
+static uint32_t
+DMABuffer_crc32cShift(size_t length)
+{
+    uint32_t p = 1U << 31;
+    uint32_t k = 3;
+
+    while(length != 0)
+    {
+        if(length & 1)
+        { p = DMABuffer_crc32cMultiply(dma_buffer_crc32c_x2n[k & 31], p); }
+        length >>= 1;
+        k++;
+    }
+
+    return(p);
+}
+
+
+
+static void
+DMABuffer_crc32cInit(void)
+{
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for(uint32_t bit = 0; bit < 8; bit++)
+        { crc = (crc & 1) ? ( (crc >> 1) ^ DMA_BUFFER_CRC32C_POLY ) : (crc >> 1); }
+        dma_buffer_crc32c_table[i] = crc;
+    }
+
+    uint32_t p = 1U << 30;
+    for(uint32_t i = 0; i < 32; i++)
+    {
+        dma_buffer_crc32c_x2n[i] = p;
+        p = DMABuffer_crc32cMultiply(p, p);
+    }
+
+    dma_buffer_crc32c_block_shift[0] = DMABuffer_crc32cShift(DMA_BUFFER_CRC32C_BLOCK);
+    dma_buffer_crc32c_block_shift[1] = DMABuffer_crc32cShift(2 * DMA_BUFFER_CRC32C_BLOCK);
+}
+
+
+
+static uint32_t
+DMABuffer_crc32cSoftware
+(
+    uint32_t       crc,
+    const uint8_t *data,
+    size_t         length
+)
+{
+    while(length-- > 0)
+    { crc = dma_buffer_crc32c_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8); }
+
+    return(crc);
+}
+
+
+
+#ifdef DMA_BUFFER_CRC32C_HW_AVAIL
+/**
+ * The crc32 instruction has a latency of three cycles, but a throughput of one
+ * per cycle. Three independent streams over consecutive blocks keep it busy, the
+ * stream CRCs are shifted over the following blocks and combined afterwards.
+ */
+__attribute__((__target__("sse4.2")))
+static uint32_t
+DMABuffer_crc32cHardware
+(
+    uint32_t       crc,
+    const uint8_t *data,
+    size_t         length
+)
+{
+    while( (length > 0) && ( ( (uintptr_t)data & 7) != 0) )
+    {
+        crc = _mm_crc32_u8(crc, *data++);
+        length--;
+    }
+
+    while(length >= (3 * DMA_BUFFER_CRC32C_BLOCK) )
+    {
+        uint64_t crc0 = crc;
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+
+        const uint8_t *end = data + DMA_BUFFER_CRC32C_BLOCK;
+        for(; data < end; data += 8)
+        {
+            crc0 = _mm_crc32_u64(crc0, DMABuffer_read64(data) );
+            crc1 = _mm_crc32_u64(crc1, DMABuffer_read64(data + DMA_BUFFER_CRC32C_BLOCK) );
+            crc2 = _mm_crc32_u64(crc2, DMABuffer_read64(data + (2 * DMA_BUFFER_CRC32C_BLOCK) ) );
+        }
+
+        crc = DMABuffer_crc32cMultiply(dma_buffer_crc32c_block_shift[1], (uint32_t)crc0) ^
+              DMABuffer_crc32cMultiply(dma_buffer_crc32c_block_shift[0], (uint32_t)crc1) ^
+              (uint32_t)crc2;
+
+        data   += 2 * DMA_BUFFER_CRC32C_BLOCK;
+        length -= 3 * DMA_BUFFER_CRC32C_BLOCK;
+    }
+
+    for(; length >= 8; length -= 8, data += 8)
+    { crc = (uint32_t)_mm_crc32_u64(crc, DMABuffer_read64(data) ); }
+
+    while(length-- > 0)
+    { crc = _mm_crc32_u8(crc, *data++); }
+
+    return(crc);
+}
+#endif /* DMA_BUFFER_CRC32C_HW_AVAIL */
+
+
+
+/** Continue the (unconditioned) CRC register over the given data */
+static inline uint32_t
+DMABuffer_crc32cUpdate
+(
+    uint32_t       crc,
+    const uint8_t *data,
+    size_t         length
+)
+{
+    #ifdef DMA_BUFFER_CRC32C_HW_AVAIL
+    if(__builtin_cpu_supports("sse4.2"))
+    { return(DMABuffer_crc32cHardware(crc, data, length) ); }
+    #endif /* DMA_BUFFER_CRC32C_HW_AVAIL */
+
+    return(DMABuffer_crc32cSoftware(crc, data, length) );
+}
+
+
+
+static uint32_t
+DMABuffer_adler32Update
+(
+    uint32_t       adler,
+    const uint8_t *data,
+    size_t         length
+)
+{
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while(length > 0)
+    {
+        size_t chunk = (length < DMA_BUFFER_ADLER32_NMAX) ? length : DMA_BUFFER_ADLER32_NMAX;
+        length -= chunk;
+
+        for(; chunk >= 8; chunk -= 8, data += 8)
+        {
+            a += data[0]; b += a;
+            a += data[1]; b += a;
+            a += data[2]; b += a;
+            a += data[3]; b += a;
+            a += data[4]; b += a;
+            a += data[5]; b += a;
+            a += data[6]; b += a;
+            a += data[7]; b += a;
+        }
+
+        for(; chunk > 0; chunk--)
+        {
+            a += *data++;
+            b += a;
+        }
+
+        a %= DMA_BUFFER_ADLER32_BASE;
+        b %= DMA_BUFFER_ADLER32_BASE;
+    }
+
+    return( (b << 16) | a );
+}
+
+
+
+/** Checksum of A followed by B, from the checksums of A and B (as in zlib) */
+static uint32_t
+DMABuffer_adler32Combine
+(
+    const uint32_t adler1,
+    const uint32_t adler2,
+    const size_t   length2
+)
+{
+    uint64_t remainder = length2 % DMA_BUFFER_ADLER32_BASE;
+    uint64_t sum1      = adler1 & 0xFFFF;
+    uint64_t sum2      = (remainder * sum1) % DMA_BUFFER_ADLER32_BASE;
+
+    sum1 += (adler2 & 0xFFFF) + DMA_BUFFER_ADLER32_BASE - 1;
+    sum2 += ( (adler1 >> 16) & 0xFFFF) + ( (adler2 >> 16) & 0xFFFF) +
+            DMA_BUFFER_ADLER32_BASE - remainder;
+
+    if(sum1 >= DMA_BUFFER_ADLER32_BASE)
+    { sum1 -= DMA_BUFFER_ADLER32_BASE; }
+    if(sum1 >= DMA_BUFFER_ADLER32_BASE)
+    { sum1 -= DMA_BUFFER_ADLER32_BASE; }
+    if(sum2 >= (2 * DMA_BUFFER_ADLER32_BASE) )
+    { sum2 -= (2 * DMA_BUFFER_ADLER32_BASE); }
+    if(sum2 >= DMA_BUFFER_ADLER32_BASE)
+    { sum2 -= DMA_BUFFER_ADLER32_BASE; }
+
+    return( (uint32_t)( sum1 | (sum2 << 16) ) );
+}
+
+
+
+static inline uint64_t
+DMABuffer_rotl64
+(
+    const uint64_t value,
+    const uint32_t bits
+)
+{
+    return( (value << bits) | (value >> (64 - bits) ) );
+}
+
+
+
+static inline uint64_t
+DMABuffer_xxh64Round
+(
+    uint64_t       acc,
+    const uint64_t input
+)
+{
+    acc += input * DMA_BUFFER_XXH64_PRIME2;
+    acc  = DMABuffer_rotl64(acc, 31);
+    return(acc * DMA_BUFFER_XXH64_PRIME1);
+}
+
+
+
+static inline uint64_t
+DMABuffer_xxh64Merge
+(
+    uint64_t acc,
+    uint64_t value
+)
+{
+    acc ^= DMABuffer_xxh64Round(0, value);
+    return( (acc * DMA_BUFFER_XXH64_PRIME1) + DMA_BUFFER_XXH64_PRIME4 );
+}
+
+
+
+static void
+DMABuffer_xxh64Init(DMABufferXXH64 *state)
+{
+    memset(state, 0, sizeof(DMABufferXXH64) );
+    state->v[0] = DMA_BUFFER_XXH64_PRIME1 + DMA_BUFFER_XXH64_PRIME2;
+    state->v[1] = DMA_BUFFER_XXH64_PRIME2;
+    state->v[2] = 0;
+    state->v[3] = 0 - DMA_BUFFER_XXH64_PRIME1;
+}
+
+
+
+static void
+DMABuffer_xxh64Update
+(
+    DMABufferXXH64 *state,
+    const uint8_t  *data,
+    size_t          length
+)
+{
+    state->total += length;
+
+    /** Complete a stripe which was started by the previous part */
+    if(state->stored > 0)
+    {
+        size_t fill = 32 - state->stored;
+        if(length < fill)
+        {
+            memcpy(state->memory + state->stored, data, length);
+            state->stored += length;
+            return;
+        }
+
+        memcpy(state->memory + state->stored, data, fill);
+        for(uint32_t i = 0; i < 4; i++)
+        { state->v[i] = DMABuffer_xxh64Round(state->v[i], DMABuffer_read64(state->memory + (8 * i) ) ); }
+
+        data         += fill;
+        length       -= fill;
+        state->stored = 0;
+    }
+
+    uint64_t v0 = state->v[0];
+    uint64_t v1 = state->v[1];
+    uint64_t v2 = state->v[2];
+    uint64_t v3 = state->v[3];
+    for(; length >= 32; length -= 32, data += 32)
+    {
+        v0 = DMABuffer_xxh64Round(v0, DMABuffer_read64(data +  0) );
+        v1 = DMABuffer_xxh64Round(v1, DMABuffer_read64(data +  8) );
+        v2 = DMABuffer_xxh64Round(v2, DMABuffer_read64(data + 16) );
+        v3 = DMABuffer_xxh64Round(v3, DMABuffer_read64(data + 24) );
+    }
+    state->v[0] = v0;
+    state->v[1] = v1;
+    state->v[2] = v2;
+    state->v[3] = v3;
+
+    memcpy(state->memory, data, length);
+    state->stored = length;
+}
+
+
+
+static uint64_t
+DMABuffer_xxh64Digest(const DMABufferXXH64 *state)
+{
+    uint64_t hash = DMA_BUFFER_XXH64_PRIME5;
+
+    if(state->total >= 32)
+    {
+        hash = DMABuffer_rotl64(state->v[0],  1) + DMABuffer_rotl64(state->v[1],  7) +
+               DMABuffer_rotl64(state->v[2], 12) + DMABuffer_rotl64(state->v[3], 18);
+        for(uint32_t i = 0; i < 4; i++)
+        { hash = DMABuffer_xxh64Merge(hash, state->v[i]); }
+    }
+
+    hash += state->total;
+
+    const uint8_t *data = state->memory;
+    const uint8_t *end  = state->memory + state->stored;
+    for(; (data + 8) <= end; data += 8)
+    {
+        hash ^= DMABuffer_xxh64Round(0, DMABuffer_read64(data) );
+        hash  = (DMABuffer_rotl64(hash, 27) * DMA_BUFFER_XXH64_PRIME1) + DMA_BUFFER_XXH64_PRIME4;
+    }
+
+    if( (data + 4) <= end )
+    {
+        hash ^= (uint64_t)DMABuffer_read32(data) * DMA_BUFFER_XXH64_PRIME1;
+        hash  = (DMABuffer_rotl64(hash, 23) * DMA_BUFFER_XXH64_PRIME2) + DMA_BUFFER_XXH64_PRIME3;
+        data += 4;
+    }
+
+    for(; data < end; data++)
+    {
+        hash ^= (*data) * DMA_BUFFER_XXH64_PRIME5;
+        hash  = DMABuffer_rotl64(hash, 11) * DMA_BUFFER_XXH64_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= DMA_BUFFER_XXH64_PRIME2;
+    hash ^= hash >> 29;
+    hash *= DMA_BUFFER_XXH64_PRIME3;
+    hash ^= hash >> 32;
+
+    return(hash);
+}
+
+
+
+/** Checksum of a range, which consists of at most two parts if it wraps */
+static uint64_t
+DMABuffer_checksumRange
+(
+    const DMABufferRange *range,
+    const uint64_t        algorithm
+)
+{
+    switch(algorithm)
+    {
+        case PDA_CHECKSUM_CRC32C :
+        {
+            uint32_t crc = 0xFFFFFFFF;
+            for(uint8_t i = 0; i < 2; i++)
+            { crc = DMABuffer_crc32cUpdate(crc, range->pointer[i], range->length[i]); }
+            return(~crc);
+        }
+
+        case PDA_CHECKSUM_ADLER32 :
+        {
+            uint32_t adler = 1;
+            for(uint8_t i = 0; i < 2; i++)
+            { adler = DMABuffer_adler32Update(adler, range->pointer[i], range->length[i]); }
+            return(adler);
+        }
+
+        default :
+        {
+            DMABufferXXH64 state;
+            DMABuffer_xxh64Init(&state);
+            for(uint8_t i = 0; i < 2; i++)
+            { DMABuffer_xxh64Update(&state, range->pointer[i], range->length[i]); }
+            return(DMABuffer_xxh64Digest(&state) );
+        }
+    }
+}
+
+
+
+static void
+DMABuffer_checksumWorker
+(
+    void           *context,
+    const uint64_t  thread,
+    const uint64_t  threads
+)
+{
+    DMABufferChecksum *work  = (DMABufferChecksum*)context;
+    size_t             start = thread * work->part_length;
+    size_t             end   = start + work->part_length;
+
+    if( (thread == (threads - 1) ) || (end > work->length) )
+    { end = work->length; }
+
+    work->partial_length[thread] = (start < end) ? (end - start) : 0;
+    if(work->partial_length[thread] == 0)
+    { return; }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(work->buffer, (work->offset + start) % work->buffer_length,
+                              work->partial_length[thread], &range) != PDA_SUCCESS)
+    {
+        work->failed = true;
+        return;
+    }
+
+    work->partial[thread] = DMABuffer_checksumRange(&range, work->algorithm);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABuffer_checksum
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const uint64_t   algorithm,
+    const uint64_t   threads,
+    uint64_t        *checksum
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (checksum == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(algorithm > PDA_CHECKSUM_ADLER32)
+    { RETURN( ERROR(EINVAL, "Unknown checksum algorithm!\n") ); }
+
+    pthread_once(&dma_buffer_crc32c_once, DMABuffer_crc32cInit);
+
+    DMABufferChecksum work =
+    {
+        .buffer    = buffer,
+        .offset    = offset,
+        .length    = length,
+        .algorithm = algorithm,
+        .failed    = false
+    };
+
+    if(DMABuffer_getLength(buffer, &work.buffer_length) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Invalid buffer!\n") ); }
+
+    if( (offset >= work.buffer_length) || (length > work.buffer_length) )
+    { RETURN( ERROR(EINVAL, "Range exceeds the buffer!\n") ); }
+
+    int32_t numa_node = -1;
+    #ifdef NUMA_AVAIL
+    if(buffer->device != NULL)
+    { numa_node = PciDevice_getNumaNode(buffer->device); }
+    #endif /* NUMA_AVAIL */
+
+    /** xxHash has no combine operation, it always runs in one thread */
+    uint64_t parts = 1;
+    if(algorithm != PDA_CHECKSUM_XXH64)
+    { parts = pda_parallelThreads(threads, length / DMA_BUFFER_CHECKSUM_PART, numa_node); }
+
+    work.part_length = (length + parts - 1) / parts;
+
+    if( (pda_parallelRun(parts, numa_node, DMABuffer_checksumWorker, &work) != PDA_SUCCESS) ||
+        work.failed )
+    { RETURN( ERROR(EFAULT, "Checksum computation failed!\n") ); }
+
+    uint64_t result = work.partial[0];
+    for(uint64_t i = 1; i < parts; i++)
+    {
+        if(work.partial_length[i] == 0)
+        { continue; }
+
+        if(algorithm == PDA_CHECKSUM_CRC32C)
+        {
+            result = DMABuffer_crc32cMultiply(DMABuffer_crc32cShift(work.partial_length[i]),
+                                              (uint32_t)result) ^ (uint32_t)work.partial[i];
+        }
+        else
+        {
+            result = DMABuffer_adler32Combine( (uint32_t)result, (uint32_t)work.partial[i],
+                                               work.partial_length[i]);
+        }
+    }
+
+    /** The empty range has a defined checksum, too */
+    if(length == 0)
+    {
+        DMABufferRange empty = { { NULL, NULL }, { 0, 0 } };
+        result = DMABuffer_checksumRange(&empty, algorithm);
+    }
+
+    *checksum = result;
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,237 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+
+#include "config.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define DMA_BUFFER_STREAM_AVAIL
+#endif
+
+#define DMA_BUFFER_CACHE_LINE 64
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+/**
+ * Resolve [offset, offset + length) into user space pointers. The offset may be
+ * anywhere in the buffer and the access may run over the end of the buffer, it
+ * then continues at the start. With a wrap mapping this is a single range.
+ */
+PdaDebugReturnCode
+DMABuffer_resolveRange
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    DMABufferRange  *range
+)
+{
+    void   *map        = NULL;
+    void   *map_two    = NULL;
+    size_t  buffer_len = 0;
+    if( (DMABuffer_getMap(buffer, &map) != PDA_SUCCESS) ||
+        (DMABuffer_getMapTwo(buffer, &map_two) != PDA_SUCCESS) ||
+        (DMABuffer_getLength(buffer, &buffer_len) != PDA_SUCCESS) )
+    { return(EINVAL); }
+
+    if( (offset >= buffer_len) || (length > buffer_len) )
+    { return(EINVAL); }
+
+    range->pointer[0] = (uint8_t*)map + offset;
+    range->length[0]  = length;
+    range->pointer[1] = NULL;
+    range->length[1]  = 0;
+
+    bool wrap_mapped = (map_two != MAP_FAILED) && (map_two != NULL);
+    if( ((offset + length) > buffer_len) && !wrap_mapped )
+    {
+        range->length[0]  = buffer_len - offset;
+        range->pointer[1] = (uint8_t*)map;
+        range->length[1]  = length - range->length[0];
+    }
+
+    return(PDA_SUCCESS);
+}
+
+
+
+#ifdef DMA_BUFFER_STREAM_AVAIL
+/**
+ * Copy with non-temporal loads (MOVNTDQA) and stores (MOVNTDQ). The loads only
+ * bypass the cache on write-combining memory, the stores keep the destination
+ * out of the cache in any case.
+ */
+__attribute__((__target__("sse4.1")))
+static void
+DMABuffer_copyStream
+(
+    uint8_t       *dst,
+    const uint8_t *src,
+    size_t         length
+)
+{
+    /** Align the source, MOVNTDQA needs 16 byte aligned addresses */
+    size_t head = (16 - ((uintptr_t)src & 15)) & 15;
+    if(head > length)
+    { head = length; }
+    memcpy(dst, src, head);
+    dst    += head;
+    src    += head;
+    length -= head;
+
+    bool aligned_dst = (((uintptr_t)dst & 15) == 0);
+    while(length >= DMA_BUFFER_CACHE_LINE)
+    {
+        __m128i a = _mm_stream_load_si128( (__m128i*)(src +  0) );
+        __m128i b = _mm_stream_load_si128( (__m128i*)(src + 16) );
+        __m128i c = _mm_stream_load_si128( (__m128i*)(src + 32) );
+        __m128i d = _mm_stream_load_si128( (__m128i*)(src + 48) );
+
+        if(aligned_dst)
+        {
+            _mm_stream_si128( (__m128i*)(dst +  0), a );
+            _mm_stream_si128( (__m128i*)(dst + 16), b );
+            _mm_stream_si128( (__m128i*)(dst + 32), c );
+            _mm_stream_si128( (__m128i*)(dst + 48), d );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)(dst +  0), a );
+            _mm_storeu_si128( (__m128i*)(dst + 16), b );
+            _mm_storeu_si128( (__m128i*)(dst + 32), c );
+            _mm_storeu_si128( (__m128i*)(dst + 48), d );
+        }
+
+        dst    += DMA_BUFFER_CACHE_LINE;
+        src    += DMA_BUFFER_CACHE_LINE;
+        length -= DMA_BUFFER_CACHE_LINE;
+    }
+
+    _mm_sfence();
+    memcpy(dst, src, length);
+}
+#endif /* DMA_BUFFER_STREAM_AVAIL */
+
+
+
+static inline
+void
+DMABuffer_copyOut
+(
+    uint8_t       *dst,
+    const uint8_t *src,
+    const size_t   length
+)
+{
+    #ifdef DMA_BUFFER_STREAM_AVAIL
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        DMABuffer_copyStream(dst, src, length);
+        return;
+    }
+    #endif /* DMA_BUFFER_STREAM_AVAIL */
+
+    memcpy(dst, src, length);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABuffer_prefetch
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(buffer, offset, length, &range) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Range exceeds the buffer!\n") ); }
+
+    for(uint8_t i = 0; i < 2; i++)
+    {
+        const uint8_t *line =
+            (const uint8_t*)((uintptr_t)range.pointer[i] & ~(uintptr_t)(DMA_BUFFER_CACHE_LINE - 1));
+        const uint8_t *end  = range.pointer[i] + range.length[i];
+        for(; line < end; line += DMA_BUFFER_CACHE_LINE)
+        { __builtin_prefetch(line, 0, 3); }
+    }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_readStream
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    void            *dst,
+    const size_t     length
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (dst == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(buffer, offset, length, &range) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Range exceeds the buffer!\n") ); }
+
+    DMABuffer_copyOut( (uint8_t*)dst, range.pointer[0], range.length[0]);
+    if(range.length[1] > 0)
+    { DMABuffer_copyOut( (uint8_t*)dst + range.length[0], range.pointer[1], range.length[1]); }
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,264 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+
+/** Descriptors are encoded into a small staging block and written out at once */
+#define DMA_BUFFER_DESCRIPTOR_BATCH 64
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline uint64_t
+DMABuffer_fieldMax(const uint8_t bits)
+{
+    return( (bits >= 64) ? UINT64_MAX : ( (1ULL << bits) - 1) );
+}
+
+
+
+/** Fields are encoded without masking, so the format is checked once before */
+static PdaDebugReturnCode
+DMABuffer_checkFormat(const DMABuffer_DescriptorFormat *format)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (format->size == 0) || (format->size > PDA_DESCRIPTOR_SIZE_MAX) )
+    { ERROR_EXIT( EINVAL, exit, "Invalid descriptor size!\n" ); }
+
+    if(format->length_shift >= 32)
+    { ERROR_EXIT( EINVAL, exit, "Invalid length shift!\n" ); }
+
+    const uint8_t offsets[3] =
+        { format->address_offset, format->length_offset, format->flags_offset };
+    const uint8_t bits[3] =
+        { format->address_bits, format->length_bits, format->flags_bits };
+    const uint8_t fields = (format->flags_bits != 0) ? 3 : 2;
+
+    for(uint8_t i = 0; i < fields; i++)
+    {
+        if( (bits[i] != 16) && (bits[i] != 32) && (bits[i] != 64) )
+        { ERROR_EXIT( EINVAL, exit, "Invalid field width!\n" ); }
+
+        if( (offsets[i] + (bits[i] / 8)) > format->size )
+        { ERROR_EXIT( EINVAL, exit, "Field overruns the descriptor!\n" ); }
+
+        for(uint8_t j = 0; j < i; j++)
+        {
+            if( (offsets[i] < (offsets[j] + (bits[j] / 8))) &&
+                (offsets[j] < (offsets[i] + (bits[i] / 8))) )
+            { ERROR_EXIT( EINVAL, exit, "Descriptor fields overlap!\n" ); }
+        }
+    }
+
+    uint64_t flags_max = (format->flags_bits != 0) ? DMABuffer_fieldMax(format->flags_bits) : 0;
+    if( (format->flags > flags_max) || (format->last_flags > flags_max) )
+    { ERROR_EXIT( EINVAL, exit, "Flags don't fit into the flags field!\n" ); }
+
+    RETURN(PDA_SUCCESS);
+
+exit:
+    RETURN( ERROR(EINVAL, "Invalid descriptor format!\n") );
+}
+
+
+
+static inline void
+DMABuffer_encodeField
+(
+    uint8_t        *descriptor,
+    const uint8_t   offset,
+    const uint8_t   bits,
+    const uint64_t  value
+)
+{
+    switch(bits)
+    {
+        case 16 :
+        {
+            uint16_t field = (uint16_t)value;
+            memcpy(descriptor + offset, &field, sizeof(field) );
+        }
+        break;
+
+        case 32 :
+        {
+            uint32_t field = (uint32_t)value;
+            memcpy(descriptor + offset, &field, sizeof(field) );
+        }
+        break;
+
+        case 64 :
+        { memcpy(descriptor + offset, &value, sizeof(value) ); }
+        break;
+    }
+}
+
+
+
+static inline __attribute__((always_inline)) void
+DMABuffer_encodeTable
+(
+    const DMABufferTranslation       *translation,
+    const DMABuffer_DescriptorFormat  format,
+    const uint64_t                    segment,
+    const uint64_t                    count,
+    uint8_t                          *out
+)
+{
+    uint8_t  staging[DMA_BUFFER_DESCRIPTOR_BATCH * PDA_DESCRIPTOR_SIZE_MAX];
+    uint64_t batched = 0;
+    uint64_t written = 0;
+
+    memset(staging, 0, sizeof(staging) );
+    for(uint64_t i = 0; i < translation->entries; i++)
+    {
+        uint64_t address = translation->bus[i];
+        uint64_t length  = translation->offsets[i + 1] - translation->offsets[i];
+
+        while(length > 0)
+        {
+            uint64_t chunk      = (length > segment) ? segment : length;
+            uint8_t *descriptor = &staging[batched * format.size];
+
+            DMABuffer_encodeField(descriptor, format.address_offset, format.address_bits, address);
+            DMABuffer_encodeField(descriptor, format.length_offset, format.length_bits,
+                                  chunk >> format.length_shift);
+
+            written++;
+            if(format.flags_bits != 0)
+            {
+                DMABuffer_encodeField(descriptor, format.flags_offset, format.flags_bits,
+                    (written == count) ? (format.flags | format.last_flags) : format.flags);
+            }
+
+            address += chunk;
+            length  -= chunk;
+            batched++;
+
+            if(batched == DMA_BUFFER_DESCRIPTOR_BATCH)
+            {
+                memcpy(out, staging, batched * format.size);
+                out    += batched * format.size;
+                batched = 0;
+            }
+        }
+    }
+
+    if(batched != 0)
+    { memcpy(out, staging, batched * format.size); }
+}
+
+
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABuffer_buildDescriptors
+(
+    const DMABuffer                  *buffer,
+    const DMABuffer_DescriptorFormat *format,
+    void                             *dst,
+    const size_t                      max_bytes,
+    const size_t                      max_segment,
+    uint64_t                         *entries
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (format == NULL) || (entries == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *entries = 0;
+
+    if(DMABuffer_checkFormat(format) != PDA_SUCCESS)
+    { RETURN(EINVAL); }
+
+    const DMABufferTranslation *translation = DMABuffer_getTranslation( (DMABuffer*)buffer );
+    if(translation == NULL)
+    { RETURN( ERROR(EINVAL, "Building the translation table failed!\n") ); }
+
+    /** Longest descriptor, limited by the caller and by the length field */
+    uint64_t unit    = 1ULL << format->length_shift;
+    uint64_t segment = DMABuffer_fieldMax(format->length_bits);
+             segment = (segment > (UINT64_MAX >> format->length_shift) ) ?
+                           UINT64_MAX : (segment << format->length_shift);
+    if( (max_segment != 0) && (max_segment < segment) )
+    { segment = max_segment; }
+    segment &= ~(unit - 1);
+    if(segment == 0)
+    { RETURN( ERROR(EINVAL, "Maximum segment is smaller than the length unit!\n") ); }
+
+    /** First pass: check the entries and count the descriptors */
+    uint64_t address_max = DMABuffer_fieldMax(format->address_bits);
+    uint64_t count       = 0;
+    for(uint64_t i = 0; i < translation->entries; i++)
+    {
+        uint64_t length = translation->offsets[i + 1] - translation->offsets[i];
+        if( (length & (unit - 1)) != 0 )
+        { RETURN( ERROR(EINVAL, "Entry length is not a multiple of the length unit!\n") ); }
+
+        if( (translation->bus[i] + (length - 1)) > address_max )
+        { RETURN( ERROR(ERANGE, "Device address doesn't fit into the descriptor!\n") ); }
+
+        count += (length <= segment) ? 1 : ( (length + segment - 1) / segment);
+    }
+
+    *entries = count;
+    if( (dst == NULL) || ( (count * format->size) > max_bytes) )
+    { RETURN(ENOSPC); }
+
+    /** Second pass: encode, the common 16 byte layout gets its own constant folded copy */
+    if( (format->size == 16) && (format->length_shift == 0) &&
+        (format->address_offset == 0) && (format->address_bits == 64) &&
+        (format->length_offset  == 8) && (format->length_bits  == 32) &&
+        (format->flags_offset  == 12) && (format->flags_bits   == 32) )
+    {
+        DMABuffer_DescriptorFormat common = PDA_DESCRIPTOR_FORMAT_64;
+        common.flags      = format->flags;
+        common.last_flags = format->last_flags;
+        DMABuffer_encodeTable(translation, common, segment, count, dst);
+    }
+    else
+    { DMABuffer_encodeTable(translation, *format, segment, count, dst); }
+
+    RETURN(PDA_SUCCESS);
+}
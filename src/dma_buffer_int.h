@@ -41,6 +41,7 @@
 #include <pda.h>
 #include <pda/defines.h>
 #include <pda/dma_buffer.h>
+#include <time.h>
 
 #define DMA_BUFFER_GET_FUNCTION( attr, name, type )                   \
     PdaDebugReturnCode                                                \
@@ -56,24 +57,91 @@
     }
 
 
+/** Monotonic time in nanoseconds, used for timing buffer setup steps */
+static inline uint64_t
+DMABuffer_timeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec );
+}
+
+
 enum enum_pda_buffer_types
 {
     PDA_BUFFER_KERNEL,
     PDA_BUFFER_USER,
-    PDA_BUFFER_LOOKUP
+    PDA_BUFFER_LOOKUP,
+    PDA_BUFFER_SLICE
 };
 
 typedef enum enum_pda_buffer_types pda_buffer_type;
 
+typedef struct DMABufferInternal_struct DMABufferInternal;
+
+/** A contiguous part of a buffer access, at most two for accesses over the wrap point */
+typedef struct DMABufferRange_struct
+{
+    uint8_t *pointer[2];
+    size_t   length[2];
+} DMABufferRange;
+
+/** Lookup tables for address translation, built on first use from the sg-list */
+typedef struct DMABufferTranslation_struct
+{
+    uint64_t  entries;
+    uint64_t *offsets;      /* buffer offset of each entry, plus the total length at the end */
+    uint64_t *bus;          /* bus address of each entry */
+    uint64_t *sorted_bus;   /* bus addresses in ascending order ... */
+    uint64_t *sorted_entry; /* ... and the related entries */
+} DMABufferTranslation;
+
+struct DMABuffer_struct
+{
+    PciDevice          *device;
+    pda_buffer_type     type;
+    uint64_t            index;
+    size_t              length;
+    void               *map;
+    void               *map_two;
+    DMABuffer_SGNode   *sglist;
+
+    DMABuffer          *next;
+    DMABuffer          *prev;
+
+    /* slices only, parent buffer and offset into it */
+    DMABuffer          *parent;
+    size_t              offset;
+
+    /* number of public slices which refer to this buffer */
+    uint64_t            references;
+
+    DMABufferTranslation *translation;
+
+    /* PDA_BUFFER_* flags and the time (ns) it took to pre-fault the mapping */
+    uint64_t            flags;
+    uint64_t            populate_time;
+
+    /* backend-dependend */
+    DMABufferInternal  *internal;
+};
 
-DMABuffer*
-DMABuffer_check_persistant(PciDevice *device)
-PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABuffer_check_persistant
+(
+    PciDevice  *device,
+    DMABuffer **dma_buffer_list
+) PDA_WARN_UNUSED_RETURN;
 
 PdaDebugReturnCode
 DMABuffer_delete_not_attached_buffers(PciDevice *device)
 PDA_WARN_UNUSED_RETURN;
 
+/** Directory of the buffers of a device, shared by all of them */
+const char*
+PciDevice_getDMAPath(const PciDevice *device);
+
 
 PdaDebugReturnCode
 DMABuffer_new
@@ -83,7 +151,44 @@ DMABuffer_new
     const uint64_t     index,
     void              *start,
     const size_t       length,
-    pda_buffer_type    buffer_type
+    pda_buffer_type    buffer_type,
+    const uint64_t     flags
+) PDA_WARN_UNUSED_RETURN;
+
+uint64_t
+DMABuffer_findNewIndex
+(
+    const uint64_t   new_index,
+    DMABuffer      **dma_buffer_list
+);
+
+PdaDebugReturnCode
+DMABuffer_importFd
+(
+    PciDevice         *device,
+    DMABuffer        **dma_buffer_list,
+    const int          fd
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABuffer_newHugeUser
+(
+    PciDevice         *device,
+    DMABuffer        **dma_buffer_list,
+    const uint64_t     index,
+    const size_t       length,
+    const size_t       page_size
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABuffer_newBatch
+(
+    PciDevice         *device,
+    DMABuffer        **dma_buffer_list,
+    const uint64_t     first_index,
+    const uint64_t     count,
+    const size_t      *lengths,
+    DMABuffer        **buffers
 ) PDA_WARN_UNUSED_RETURN;
 
 PdaDebugReturnCode
@@ -129,4 +234,83 @@ DMABuffer_coalesqueSGlist
     DMABuffer_SGNode **sglist
 ) PDA_WARN_UNUSED_RETURN;
 
+void
+DMABuffer_freeSGList
+(
+    DMABuffer *buffer
+);
+
+DMABufferTranslation*
+DMABuffer_getTranslation
+(
+    DMABuffer *buffer
+);
+
+void
+DMABuffer_initSlice
+(
+    DMABuffer       *slice,
+    DMABuffer       *parent,
+    const size_t     offset,
+    const size_t     length
+);
+
+PdaDebugReturnCode
+DMABuffer_resolveRange
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    DMABufferRange  *range
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABuffer_sliceSGList
+(
+    DMABuffer         *parent,
+    const size_t       offset,
+    const size_t       length,
+    DMABuffer_SGNode **sglist
+) PDA_WARN_UNUSED_RETURN;
+
+/** Registration cache for user memory, see PciDevice_registerCachedDMABuffer */
+typedef struct DMABufferCache_struct DMABufferCache;
+
+PdaDebugReturnCode
+DMABufferCache_new
+(
+    DMABufferCache **cache
+) PDA_WARN_UNUSED_RETURN;
+
+void
+DMABufferCache_delete
+(
+    DMABufferCache *cache
+);
+
+PdaDebugReturnCode
+DMABufferCache_register
+(
+    DMABufferCache  *cache,
+    PciDevice       *device,
+    void            *start,
+    const size_t     size,
+    DMABuffer      **view
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABufferCache_release
+(
+    DMABufferCache *cache,
+    DMABuffer      *view
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+DMABufferCache_invalidate
+(
+    DMABufferCache *cache,
+    const void     *start,
+    const size_t    size
+) PDA_WARN_UNUSED_RETURN;
+
 #endif /*DMA_BUFFER_INT_H*/
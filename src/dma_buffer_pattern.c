@@ -0,0 +1,649 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dma_buffer_int.h>
+#include <parallel_int.h>
+#include <pda.h>
+
+#include "config.h"
+
+#if defined(__x86_64__)
+    #include <immintrin.h>
+    #define DMA_BUFFER_PATTERN_AVX2_AVAIL
+#endif
+
+/** Feedback mask of the maximal length 64 bit Galois LFSR with taps 64, 63, 61, 60 */
+#define DMA_BUFFER_LFSR_MASK         0xD800000000000000ULL
+/** Ranges are only split into parts of at least this length */
+#define DMA_BUFFER_PATTERN_PART      (1024 * 1024)
+/** Verification looks for earlier mismatches of other threads after each chunk */
+#define DMA_BUFFER_PATTERN_CHUNK     (1024 * 1024)
+/** Fills beyond this length do not stay in the cache and bypass it */
+#define DMA_BUFFER_PATTERN_STREAMING (8 * 1024 * 1024)
+
+/** Position inside a pattern: the current word and the next byte inside of it */
+typedef struct DMABufferPatternState_struct
+{
+    uint64_t pattern;
+    uint64_t value;
+    uint8_t  byte;
+} DMABufferPatternState;
+
+/** Fill or verification which is split over several threads */
+typedef struct DMABufferPattern_struct
+{
+    const DMABuffer *buffer;
+    size_t           offset;
+    size_t           length;
+    size_t           buffer_length;
+    size_t           part_length;
+    uint64_t         pattern;
+    uint64_t         seed;
+    bool             verify;
+    bool             streaming;
+    bool             failed;
+    uint64_t         mismatch;
+} DMABufferPattern;
+
+/** LFSR state after eight steps is (state >> 8) ^ table[state & 0xFF] */
+static pthread_once_t dma_buffer_lfsr_once = PTHREAD_ONCE_INIT;
+static uint64_t       dma_buffer_lfsr_table[256];
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline uint64_t
+DMABuffer_read64(const uint8_t *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value) );
+    return(value);
+}
+
+
+
+static inline uint64_t
+DMABuffer_lfsrStep(const uint64_t state)
+{ return( (state >> 1) ^ ( (0 - (state & 1) ) & DMA_BUFFER_LFSR_MASK) ); }
+
+
+
+/**
+ * The feedback only reaches the upper bits, so the eight low bits which are shifted
+ * out determine the feedback of eight steps alone.
+ */
+static void
+DMABuffer_lfsrInit(void)
+{
+    for(uint64_t low = 0; low < 256; low++)
+    {
+        uint64_t state = low;
+        for(uint8_t step = 0; step < 8; step++)
+        { state = DMABuffer_lfsrStep(state); }
+        dma_buffer_lfsr_table[low] = state;
+    }
+}
+
+
+
+/** Multiply a vector with a GF(2) matrix which is stored as 64 columns */
+static inline uint64_t
+DMABuffer_lfsrApply
+(
+    const uint64_t *matrix,
+    uint64_t        vector
+)
+{
+    uint64_t result = 0;
+    for(uint64_t column = 0; vector != 0; column++, vector >>= 1)
+    {
+        if(vector & 1)
+        { result ^= matrix[column]; }
+    }
+
+    return(result);
+}
+
+
+
+/** LFSR state after the given number of steps, by squaring the step matrix */
+static uint64_t
+DMABuffer_lfsrJump
+(
+    uint64_t state,
+    uint64_t steps
+)
+{
+    uint64_t matrix[64];
+    uint64_t square[64];
+
+    for(uint64_t column = 0; column < 64; column++)
+    { matrix[column] = DMABuffer_lfsrStep(1ULL << column); }
+
+    while(steps != 0)
+    {
+        if(steps & 1)
+        { state = DMABuffer_lfsrApply(matrix, state); }
+
+        steps >>= 1;
+        if(steps == 0)
+        { break; }
+
+        for(uint64_t column = 0; column < 64; column++)
+        { square[column] = DMABuffer_lfsrApply(matrix, matrix[column]); }
+        memcpy(matrix, square, sizeof(matrix) );
+    }
+
+    return(state);
+}
+
+
+
+/** Value of the given word of a pattern */
+static uint64_t
+DMABuffer_patternWord
+(
+    const uint64_t pattern,
+    const uint64_t seed,
+    const uint64_t word
+)
+{
+    switch(pattern)
+    {
+        case PDA_PATTERN_INCREMENT :
+        { return(seed + word); }
+
+        case PDA_PATTERN_LFSR :
+        { return(DMABuffer_lfsrJump( (seed == 0) ? 1 : seed, word) ); }
+
+        default :
+        { return(seed); }
+    }
+}
+
+
+
+static inline void
+DMABuffer_patternNext(DMABufferPatternState *state)
+{
+    if(state->pattern == PDA_PATTERN_INCREMENT)
+    { state->value++; }
+    else if(state->pattern == PDA_PATTERN_LFSR)
+    { state->value = DMABuffer_lfsrStep(state->value); }
+}
+
+
+
+/** Fill or check single bytes, returns the index of the first mismatch or SIZE_MAX */
+static size_t
+DMABuffer_patternBytes
+(
+    uint8_t               *data,
+    const size_t           length,
+    DMABufferPatternState *state,
+    const bool             verify
+)
+{
+    for(size_t i = 0; i < length; i++)
+    {
+        uint8_t expected = (uint8_t)(state->value >> (8 * state->byte) );
+        if(!verify)
+        { data[i] = expected; }
+        else if(data[i] != expected)
+        { return(i); }
+
+        if(++state->byte == 8)
+        {
+            state->byte = 0;
+            DMABuffer_patternNext(state);
+        }
+    }
+
+    return(SIZE_MAX);
+}
+
+
+
+/**
+ * Fill or check whole words, returns the number of matching words. The state
+ * stays at the first mismatching word.
+ */
+static size_t
+DMABuffer_patternWordsScalar
+(
+    uint8_t               *data,
+    const size_t           words,
+    DMABufferPatternState *state,
+    const bool             verify
+)
+{
+    for(size_t i = 0; i < words; i++)
+    {
+        if(!verify)
+        { memcpy(data + (8 * i), &state->value, sizeof(uint64_t) ); }
+        else
+        {
+            uint64_t word;
+            memcpy(&word, data + (8 * i), sizeof(uint64_t) );
+            if(word != state->value)
+            { return(i); }
+        }
+
+        DMABuffer_patternNext(state);
+    }
+
+    return(words);
+}
+
+
+
+/**
+ * A single LFSR is a chain of dependent steps. Eight interleaved copies, each one
+ * eight steps ahead per iteration, produce eight words at a time.
+ */
+static size_t
+DMABuffer_patternWordsLFSR
+(
+    uint8_t               *data,
+    const size_t           words,
+    DMABufferPatternState *state,
+    const bool             verify
+)
+{
+    uint64_t lanes[8];
+    size_t   i = 0;
+
+    lanes[0] = state->value;
+    for(uint8_t lane = 1; lane < 8; lane++)
+    { lanes[lane] = DMABuffer_lfsrStep(lanes[lane - 1]); }
+
+    for(; (i + 8) <= words; i += 8)
+    {
+        uint8_t *block = data + (8 * i);
+        if(verify)
+        {
+            uint64_t difference = 0;
+            for(uint8_t lane = 0; lane < 8; lane++)
+            { difference |= DMABuffer_read64(block + (8 * lane) ) ^ lanes[lane]; }
+            if(difference != 0)
+            { break; }
+        }
+        else
+        { memcpy(block, lanes, sizeof(lanes) ); }
+
+        for(uint8_t lane = 0; lane < 8; lane++)
+        { lanes[lane] = (lanes[lane] >> 8) ^ dma_buffer_lfsr_table[lanes[lane] & 0xFF]; }
+    }
+
+    state->value = lanes[0];
+
+    return(i + DMABuffer_patternWordsScalar(data + (8 * i), words - i, state, verify) );
+}
+
+
+
+#ifdef DMA_BUFFER_PATTERN_AVX2_AVAIL
+/** Incrementing and constant patterns are generated four words at a time */
+__attribute__((__target__("avx2")))
+static size_t
+DMABuffer_patternWordsAVX2
+(
+    uint8_t               *data,
+    const size_t           words,
+    DMABufferPatternState *state,
+    const bool             verify,
+    const bool             streaming
+)
+{
+    size_t i = 0;
+
+    /** Non-temporal stores need 32 byte aligned addresses */
+    if(streaming && !verify)
+    {
+        size_t head = ( (32 - ( (uintptr_t)data & 31) ) & 31) / 8;
+        i = DMABuffer_patternWordsScalar(data, (head < words) ? head : words, state, false);
+    }
+
+    uint64_t base = state->value;
+    uint64_t step = (state->pattern == PDA_PATTERN_INCREMENT) ? 1 : 0;
+    __m256i  value =
+        _mm256_set_epi64x(base + (3 * step), base + (2 * step), base + step, base);
+    __m256i  increment = _mm256_set1_epi64x(4 * step);
+    size_t   start     = i;
+
+    if(verify)
+    {
+        for(; (i + 4) <= words; i += 4)
+        {
+            __m256i word = _mm256_loadu_si256( (const __m256i*)(data + (8 * i) ) );
+            if(_mm256_movemask_epi8(_mm256_cmpeq_epi64(word, value) ) != -1)
+            { break; }
+            value = _mm256_add_epi64(value, increment);
+        }
+    }
+    else if(streaming && ( ( (uintptr_t)(data + (8 * i) ) & 31) == 0) )
+    {
+        for(; (i + 4) <= words; i += 4)
+        {
+            _mm256_stream_si256( (__m256i*)(data + (8 * i) ), value);
+            value = _mm256_add_epi64(value, increment);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for(; (i + 4) <= words; i += 4)
+        {
+            _mm256_storeu_si256( (__m256i*)(data + (8 * i) ), value);
+            value = _mm256_add_epi64(value, increment);
+        }
+    }
+
+    state->value = base + ( (i - start) * step);
+
+    /** The remaining words or the block with the mismatch */
+    return(i + DMABuffer_patternWordsScalar(data + (8 * i), words - i, state, verify) );
+}
+#endif /* DMA_BUFFER_PATTERN_AVX2_AVAIL */
+
+
+
+/** Fill or check a contiguous piece, returns the index of the first mismatch or SIZE_MAX */
+static size_t
+DMABuffer_patternRun
+(
+    uint8_t               *data,
+    const size_t           length,
+    DMABufferPatternState *state,
+    const bool             verify,
+    const bool             streaming
+)
+{
+    size_t done = 0;
+
+    if(state->byte != 0)
+    {
+        size_t head = 8 - state->byte;
+        if(head > length)
+        { head = length; }
+
+        size_t mismatch = DMABuffer_patternBytes(data, head, state, verify);
+        if(mismatch != SIZE_MAX)
+        { return(mismatch); }
+        done = head;
+    }
+
+    size_t words = (length - done) / 8;
+    size_t good  = 0;
+
+    if(state->pattern == PDA_PATTERN_LFSR)
+    { good = DMABuffer_patternWordsLFSR(data + done, words, state, verify); }
+    #ifdef DMA_BUFFER_PATTERN_AVX2_AVAIL
+    else if(__builtin_cpu_supports("avx2") )
+    { good = DMABuffer_patternWordsAVX2(data + done, words, state, verify, streaming); }
+    #endif /* DMA_BUFFER_PATTERN_AVX2_AVAIL */
+    else
+    { good = DMABuffer_patternWordsScalar(data + done, words, state, verify); }
+
+    done += 8 * good;
+    if(good < words)
+    { return(done + DMABuffer_patternBytes(data + done, 8, state, true) ); }
+
+    size_t mismatch = DMABuffer_patternBytes(data + done, length - done, state, verify);
+    return( (mismatch == SIZE_MAX) ? SIZE_MAX : (done + mismatch) );
+}
+
+
+
+static void
+DMABuffer_patternWorker
+(
+    void           *context,
+    const uint64_t  thread,
+    const uint64_t  threads
+)
+{
+    DMABufferPattern *work  = (DMABufferPattern*)context;
+    size_t            start = thread * work->part_length;
+    size_t            end   = start + work->part_length;
+
+    if( (thread == (threads - 1) ) || (end > work->length) )
+    { end = work->length; }
+
+    if(start >= end)
+    { return; }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(work->buffer, (work->offset + start) % work->buffer_length,
+                              end - start, &range) != PDA_SUCCESS)
+    {
+        work->failed = true;
+        return;
+    }
+
+    DMABufferPatternState state =
+    {
+        .pattern = work->pattern,
+        .value   = DMABuffer_patternWord(work->pattern, work->seed, start / 8),
+        .byte    = (uint8_t)(start % 8)
+    };
+
+    size_t position = start;
+    for(uint8_t i = 0; i < 2; i++)
+    {
+        for(size_t done = 0; done < range.length[i]; done += DMA_BUFFER_PATTERN_CHUNK)
+        {
+            /** Parts behind a known mismatch do not need to be checked */
+            if(work->verify && (__atomic_load_n(&work->mismatch, __ATOMIC_RELAXED) < position) )
+            { return; }
+
+            size_t chunk = range.length[i] - done;
+            if(chunk > DMA_BUFFER_PATTERN_CHUNK)
+            { chunk = DMA_BUFFER_PATTERN_CHUNK; }
+
+            size_t mismatch = DMABuffer_patternRun(range.pointer[i] + done, chunk, &state,
+                                                   work->verify, work->streaming);
+            if(mismatch != SIZE_MAX)
+            {
+                uint64_t found    = position + mismatch;
+                uint64_t previous = __atomic_load_n(&work->mismatch, __ATOMIC_RELAXED);
+                while( (found < previous) &&
+                       !__atomic_compare_exchange_n(&work->mismatch, &previous, found, false,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+                { }
+                return;
+            }
+
+            position += chunk;
+        }
+    }
+}
+
+
+
+static PdaDebugReturnCode
+DMABuffer_patternExecute
+(
+    DMABufferPattern *work,
+    const uint64_t    threads
+)
+{
+    if(work->pattern > PDA_PATTERN_CONSTANT)
+    { return(EINVAL); }
+
+    pthread_once(&dma_buffer_lfsr_once, DMABuffer_lfsrInit);
+
+    if(DMABuffer_getLength(work->buffer, &work->buffer_length) != PDA_SUCCESS)
+    { return(EINVAL); }
+
+    if( (work->offset >= work->buffer_length) || (work->length > work->buffer_length) )
+    { return(EINVAL); }
+
+    work->mismatch  = PDA_PATTERN_NO_MISMATCH;
+    work->streaming = (work->length >= DMA_BUFFER_PATTERN_STREAMING);
+
+    int32_t numa_node = -1;
+    #ifdef NUMA_AVAIL
+    if(work->buffer->device != NULL)
+    { numa_node = PciDevice_getNumaNode(work->buffer->device); }
+    #endif /* NUMA_AVAIL */
+
+    uint64_t parts = pda_parallelThreads(threads, work->length / DMA_BUFFER_PATTERN_PART, numa_node);
+
+    /** Page aligned parts keep the vector loops of all threads aligned */
+    work->part_length = (work->length + parts - 1) / parts;
+    work->part_length = (work->part_length + 4095) & ~(size_t)4095;
+
+    if( (pda_parallelRun(parts, numa_node, DMABuffer_patternWorker, work) != PDA_SUCCESS) ||
+        work->failed )
+    { return(EFAULT); }
+
+    return(PDA_SUCCESS);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABuffer_fillPattern
+(
+    DMABuffer      *buffer,
+    const size_t    offset,
+    const size_t    length,
+    const uint64_t  pattern,
+    const uint64_t  seed,
+    const uint64_t  threads
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferPattern work =
+    {
+        .buffer  = buffer,
+        .offset  = offset,
+        .length  = length,
+        .pattern = pattern,
+        .seed    = seed,
+        .verify  = false,
+        .failed  = false
+    };
+
+    int ret = DMABuffer_patternExecute(&work, threads);
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Filling the buffer failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_clear
+(
+    DMABuffer      *buffer,
+    const uint64_t  threads
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferPattern work =
+    {
+        .buffer  = buffer,
+        .offset  = 0,
+        .length  = buffer->length,
+        .pattern = PDA_PATTERN_CONSTANT,
+        .seed    = 0,
+        .verify  = false,
+        .failed  = false
+    };
+
+    int ret = DMABuffer_patternExecute(&work, threads);
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Clearing the buffer failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_verifyPattern
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const uint64_t   pattern,
+    const uint64_t   seed,
+    const uint64_t   threads,
+    uint64_t        *mismatch
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (mismatch == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferPattern work =
+    {
+        .buffer  = buffer,
+        .offset  = offset,
+        .length  = length,
+        .pattern = pattern,
+        .seed    = seed,
+        .verify  = true,
+        .failed  = false
+    };
+
+    int ret = DMABuffer_patternExecute(&work, threads);
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Verifying the buffer failed!\n") ); }
+
+    *mismatch = work.mismatch;
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,479 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/errqueue.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+
+#include "config.h"
+
+#ifndef SO_ZEROCOPY
+    #define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+    #define MSG_ZEROCOPY 0x4000000
+#endif
+
+/** Initial number of sends which can wait for their completion */
+#define DMA_BUFFER_SEND_PENDING 64
+/** Poll timeout (ms) while waiting for completions */
+#define DMA_BUFFER_SEND_POLL    100
+
+/** One sendmsg call, zero-copy sends are numbered by the kernel */
+typedef struct DMABufferSend_struct
+{
+    uint64_t end;
+    uint32_t id;
+    bool     zerocopy;
+    bool     done;
+    bool     copied;
+} DMABufferSend;
+
+/** Zero-copy state of one socket */
+typedef struct DMABufferSocket_struct DMABufferSocket;
+struct DMABufferSocket_struct
+{
+    int              fd;
+    bool             zerocopy;
+    pthread_mutex_t  lock;
+
+    uint32_t         next_id;
+    uint64_t         sent;
+    uint64_t         released;
+    uint64_t         copied;
+
+    /** Ring of sends which are not released yet */
+    DMABufferSend   *pending;
+    uint64_t         capacity;
+    uint64_t         first;
+    uint64_t         count;
+
+    DMABufferSocket *next;
+};
+
+static pthread_mutex_t  dma_buffer_sockets_lock = PTHREAD_MUTEX_INITIALIZER;
+static DMABufferSocket *dma_buffer_sockets      = NULL;
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+/** Look up the state of a socket and create it on the first send */
+static DMABufferSocket*
+DMABuffer_findSocket
+(
+    const int  sockfd,
+    const bool create
+)
+{
+    pthread_mutex_lock(&dma_buffer_sockets_lock);
+
+    DMABufferSocket *tracker = dma_buffer_sockets;
+    while( (tracker != NULL) && (tracker->fd != sockfd) )
+    { tracker = tracker->next; }
+
+    if( (tracker == NULL) && create )
+    {
+        tracker = calloc(1, sizeof(DMABufferSocket) );
+        if(tracker != NULL)
+        {
+            tracker->pending  = calloc(DMA_BUFFER_SEND_PENDING, sizeof(DMABufferSend) );
+            tracker->capacity = DMA_BUFFER_SEND_PENDING;
+            if(tracker->pending == NULL)
+            {
+                free(tracker);
+                tracker = NULL;
+            }
+        }
+
+        if(tracker != NULL)
+        {
+            int one = 1;
+            tracker->fd       = sockfd;
+            tracker->zerocopy =
+                (setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one) ) == 0);
+            pthread_mutex_init(&tracker->lock, NULL);
+
+            tracker->next       = dma_buffer_sockets;
+            dma_buffer_sockets = tracker;
+        }
+    }
+
+    pthread_mutex_unlock(&dma_buffer_sockets_lock);
+    return(tracker);
+}
+
+
+
+/** Release the oldest sends as long as they are done */
+static void
+DMABuffer_releaseSends(DMABufferSocket *tracker)
+{
+    while(tracker->count > 0)
+    {
+        DMABufferSend *send = &tracker->pending[tracker->first];
+        if(!send->done)
+        { break; }
+
+        if(send->copied)
+        { tracker->copied += send->end - tracker->released; }
+        tracker->released = send->end;
+
+        tracker->first = (tracker->first + 1) % tracker->capacity;
+        tracker->count--;
+    }
+}
+
+
+
+static int
+DMABuffer_pushSend
+(
+    DMABufferSocket *tracker,
+    const bool       zerocopy
+)
+{
+    if(tracker->count == tracker->capacity)
+    {
+        DMABufferSend *pending = calloc(2 * tracker->capacity, sizeof(DMABufferSend) );
+        if(pending == NULL)
+        { return(ENOMEM); }
+
+        for(uint64_t i = 0; i < tracker->count; i++)
+        { pending[i] = tracker->pending[(tracker->first + i) % tracker->capacity]; }
+
+        free(tracker->pending);
+        tracker->pending   = pending;
+        tracker->capacity *= 2;
+        tracker->first     = 0;
+    }
+
+    DMABufferSend *send = &tracker->pending[(tracker->first + tracker->count) % tracker->capacity];
+    send->end      = tracker->sent;
+    send->zerocopy = zerocopy;
+    send->done     = !zerocopy;
+    send->copied   = !zerocopy;
+    send->id       = zerocopy ? tracker->next_id++ : 0;
+    tracker->count++;
+
+    DMABuffer_releaseSends(tracker);
+    return(PDA_SUCCESS);
+}
+
+
+
+/** Mark the zero-copy sends with the (wrapping) ids first to last as done */
+static void
+DMABuffer_completeSends
+(
+    DMABufferSocket *tracker,
+    const uint32_t   first,
+    const uint32_t   last,
+    const bool       copied
+)
+{
+    for(uint64_t i = 0; i < tracker->count; i++)
+    {
+        DMABufferSend *send = &tracker->pending[(tracker->first + i) % tracker->capacity];
+        if(send->zerocopy && ( (uint32_t)(send->id - first) <= (uint32_t)(last - first) ) )
+        {
+            send->done   = true;
+            send->copied = copied;
+        }
+    }
+
+    DMABuffer_releaseSends(tracker);
+}
+
+
+
+/** Read all notifications from the error queue of the socket without blocking */
+static int
+DMABuffer_reapSends(DMABufferSocket *tracker)
+{
+    for(;;)
+    {
+        uint8_t       control[CMSG_SPACE(sizeof(struct sock_extended_err) ) + 64];
+        struct msghdr message;
+        memset(&message, 0, sizeof(message) );
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        if(recvmsg(tracker->fd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+        {
+            if(errno == EINTR)
+            { continue; }
+            if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+            { return(PDA_SUCCESS); }
+            return(errno);
+        }
+
+        for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != NULL;
+            cmsg = CMSG_NXTHDR(&message, cmsg) )
+        {
+            if( !( (cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR) ) &&
+                !( (cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR) ) )
+            { continue; }
+
+            struct sock_extended_err error;
+            memcpy(&error, CMSG_DATA(cmsg), sizeof(error) );
+            if( (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) || (error.ee_errno != 0) )
+            { continue; }
+
+            DMABuffer_completeSends(tracker, error.ee_info, error.ee_data,
+                (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+        }
+    }
+}
+
+
+
+/** Wait for the socket to become writable or for a completion */
+static int
+DMABuffer_waitSocket
+(
+    DMABufferSocket *tracker,
+    const short      events
+)
+{
+    struct pollfd descriptor = { .fd = tracker->fd, .events = events, .revents = 0 };
+    if( (poll(&descriptor, 1, DMA_BUFFER_SEND_POLL) < 0) && (errno != EINTR) )
+    { return(errno); }
+
+    return(DMABuffer_reapSends(tracker) );
+}
+
+
+
+static int
+DMABuffer_sendRange
+(
+    DMABufferSocket *tracker,
+    struct iovec    *iov,
+    int              iovcnt,
+    const bool       kernel_buffer
+)
+{
+    bool zerocopy = tracker->zerocopy && !kernel_buffer;
+
+    while(iovcnt > 0)
+    {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message) );
+        message.msg_iov    = iov;
+        message.msg_iovlen = (size_t)iovcnt;
+
+        ssize_t sent = sendmsg(tracker->fd, &message, MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0) );
+        if(sent < 0)
+        {
+            int ret = errno;
+            if(ret == EINTR)
+            { continue; }
+
+            /** The socket buffer or the memory for notifications is used up */
+            if( (ret == EAGAIN) || (ret == EWOULDBLOCK) || (zerocopy && (ret == ENOBUFS) ) )
+            {
+                ret = DMABuffer_waitSocket(tracker, (ret == ENOBUFS) ? 0 : POLLOUT);
+                if(ret != PDA_SUCCESS)
+                { return(ret); }
+                continue;
+            }
+
+            /** Pages which can't be pinned are copied */
+            if(zerocopy && (ret == EFAULT) )
+            {
+                zerocopy = false;
+                continue;
+            }
+
+            return(ret);
+        }
+
+        tracker->sent += (uint64_t)sent;
+        int ret = DMABuffer_pushSend(tracker, zerocopy);
+        if(ret != PDA_SUCCESS)
+        { return(ret); }
+
+        while( (iovcnt > 0) && ( (size_t)sent >= iov->iov_len) )
+        {
+            sent -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if(iovcnt > 0)
+        {
+            iov->iov_base  = (uint8_t*)iov->iov_base + sent;
+            iov->iov_len  -= (size_t)sent;
+        }
+    }
+
+    return(PDA_SUCCESS);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMABuffer_send
+(
+    const DMABuffer *buffer,
+    const size_t     offset,
+    const size_t     length,
+    const int        sockfd
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(buffer == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(buffer, offset, length, &range) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Range exceeds the buffer!\n") ); }
+
+    struct iovec iov[2];
+    int          iovcnt = 0;
+    for(uint8_t i = 0; i < 2; i++)
+    {
+        if(range.length[i] != 0)
+        {
+            iov[iovcnt].iov_base = range.pointer[i];
+            iov[iovcnt].iov_len  = range.length[i];
+            iovcnt++;
+        }
+    }
+
+    DMABufferSocket *tracker = DMABuffer_findSocket(sockfd, true);
+    if(tracker == NULL)
+    { RETURN( ERROR(ENOMEM, "Allocating the socket state failed!\n") ); }
+
+    /** Slices share the mapping of their parent */
+    const DMABuffer *root = buffer;
+    while(root->parent != NULL)
+    { root = root->parent; }
+
+    pthread_mutex_lock(&tracker->lock);
+    int ret = DMABuffer_sendRange(tracker, iov, iovcnt, root->type == PDA_BUFFER_KERNEL);
+    pthread_mutex_unlock(&tracker->lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Sending the buffer range failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_sendReleased
+(
+    const int  sockfd,
+    uint64_t  *released,
+    uint64_t  *copied
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(released == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    DMABufferSocket *tracker = DMABuffer_findSocket(sockfd, false);
+    if(tracker == NULL)
+    { RETURN( ERROR(EINVAL, "Nothing was sent over this socket!\n") ); }
+
+    pthread_mutex_lock(&tracker->lock);
+    int ret   = DMABuffer_reapSends(tracker);
+    *released = tracker->released;
+    if(copied != NULL)
+    { *copied = tracker->copied; }
+    pthread_mutex_unlock(&tracker->lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Reading the completions failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMABuffer_sendClose
+(
+    const int sockfd
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    pthread_mutex_lock(&dma_buffer_sockets_lock);
+    DMABufferSocket **link = &dma_buffer_sockets;
+    while( (*link != NULL) && ( (*link)->fd != sockfd) )
+    { link = &(*link)->next; }
+
+    DMABufferSocket *tracker = *link;
+    if(tracker != NULL)
+    { *link = tracker->next; }
+    pthread_mutex_unlock(&dma_buffer_sockets_lock);
+
+    if(tracker == NULL)
+    { RETURN(PDA_SUCCESS); }
+
+    int ret = PDA_SUCCESS;
+    pthread_mutex_lock(&tracker->lock);
+    while( (tracker->count > 0) && (ret == PDA_SUCCESS) )
+    { ret = DMABuffer_waitSocket(tracker, 0); }
+    pthread_mutex_unlock(&tracker->lock);
+
+    pthread_mutex_destroy(&tracker->lock);
+    free(tracker->pending);
+    free(tracker);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Waiting for the completions failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,404 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+#include <pda/dma_pool.h>
+
+#include "config.h"
+
+/** Number of chunk indices a thread keeps in its cache */
+#define DMA_POOL_CACHE_SIZE  64
+/** Number of chunk indices moved between a cache and the pool at once */
+#define DMA_POOL_CACHE_BATCH (DMA_POOL_CACHE_SIZE / 2)
+
+typedef struct DMAPoolCache_struct DMAPoolCache;
+
+struct DMAPoolCache_struct
+{
+    DMAPool      *pool;
+    uint64_t      count;
+    uint64_t      entries[DMA_POOL_CACHE_SIZE];
+
+    DMAPoolCache *next;
+    DMAPoolCache *prev;
+};
+
+struct DMAPool_struct
+{
+    PciDevice       *device;
+    DMABuffer       *buffer;
+    size_t           chunk_size;
+    size_t           stride;
+    uint64_t         chunk_count;
+    DMABuffer       *chunks;
+
+    /** Global stack of free chunk indices, protected by lock */
+    pthread_mutex_t  lock;
+    uint64_t        *free_stack;
+    uint64_t         free_count;
+
+    /** Per-thread caches */
+    pthread_key_t    cache_key;
+    DMAPoolCache    *caches;
+};
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline
+void
+DMAPool_flushCache
+(
+    DMAPoolCache   *cache,
+    const uint64_t  count
+)
+{
+    DMAPool *pool = cache->pool;
+    for(uint64_t i = 0; (i < count) && (cache->count > 0); i++)
+    {
+        cache->count--;
+        pool->free_stack[pool->free_count] = cache->entries[cache->count];
+        pool->free_count++;
+    }
+}
+
+
+
+static
+void
+DMAPool_destroyCache(void *data)
+{
+    DMAPoolCache *cache = (DMAPoolCache*)data;
+    DMAPool      *pool  = cache->pool;
+
+    /** Called on thread exit, give all cached chunks back to the pool */
+    pthread_mutex_lock(&pool->lock);
+    {
+        DMAPool_flushCache(cache, cache->count);
+
+        if(cache->prev != NULL)
+        { cache->prev->next = cache->next; }
+        else
+        { pool->caches = cache->next; }
+
+        if(cache->next != NULL)
+        { cache->next->prev = cache->prev; }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    free(cache);
+}
+
+
+
+static inline
+DMAPoolCache*
+DMAPool_getCache(DMAPool *pool)
+{
+    DMAPoolCache *cache = (DMAPoolCache*)pthread_getspecific(pool->cache_key);
+    if(cache != NULL)
+    { return(cache); }
+
+    cache = (DMAPoolCache*)calloc(1, sizeof(DMAPoolCache) );
+    if(cache == NULL)
+    { return(NULL); }
+
+    cache->pool = pool;
+    if(pthread_setspecific(pool->cache_key, cache) != 0)
+    {
+        free(cache);
+        return(NULL);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    {
+        cache->next = pool->caches;
+        if(pool->caches != NULL)
+        { pool->caches->prev = cache; }
+        pool->caches = cache;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return(cache);
+}
+
+
+
+static inline
+PdaDebugReturnCode
+DMAPool_release(DMAPool *pool)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    PdaDebugReturnCode ret = PDA_SUCCESS;
+
+    if(pool->chunks != NULL)
+    {
+        for(uint64_t i = 0; i < pool->chunk_count; i++)
+        { DMABuffer_freeSGList(&pool->chunks[i]); }
+        free(pool->chunks);
+        pool->chunks = NULL;
+    }
+
+    if(pool->free_stack != NULL)
+    {
+        free(pool->free_stack);
+        pool->free_stack = NULL;
+    }
+
+    if(pool->buffer != NULL)
+    {
+        ret = PciDevice_deleteDMABuffer(pool->device, pool->buffer);
+        pool->buffer = NULL;
+    }
+
+    free(pool);
+    RETURN(ret);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMAPool_new
+(
+    PciDevice      *device,
+    const uint64_t  index,
+    const size_t    chunk_size,
+    const size_t    alignment,
+    const uint64_t  chunk_count,
+    DMAPool       **pool
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (pool == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (chunk_size == 0) || (chunk_count == 0) )
+    { RETURN( ERROR(EINVAL, "Empty pools are not supported!\n") ); }
+
+    if( (alignment & (alignment - 1) ) != 0)
+    { RETURN( ERROR(EINVAL, "Alignment is not a power of two!\n") ); }
+
+    *pool = NULL;
+
+    DMAPool *new_pool = (DMAPool*)calloc(1, sizeof(DMAPool) );
+    if(new_pool == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    new_pool->device      = device;
+    new_pool->chunk_size  = chunk_size;
+    new_pool->chunk_count = chunk_count;
+    new_pool->stride      = chunk_size;
+    if(alignment > 1)
+    { new_pool->stride = (chunk_size + alignment - 1) & ~(alignment - 1); }
+
+    if(PciDevice_allocDMABuffer(device, index, new_pool->stride * chunk_count,
+                                &new_pool->buffer) != PDA_SUCCESS)
+    {
+        new_pool->buffer = NULL;
+        ERROR_EXIT( ENOMEM, exit, "Allocating the pool buffer failed!\n" );
+    }
+
+    new_pool->chunks     = (DMABuffer*)calloc(chunk_count, sizeof(DMABuffer) );
+    new_pool->free_stack = (uint64_t*)calloc(chunk_count, sizeof(uint64_t) );
+    if( (new_pool->chunks == NULL) || (new_pool->free_stack == NULL) )
+    { ERROR_EXIT( ENOMEM, exit, "Memory allocation failed!\n" ); }
+
+    /** Push in reverse order, so that the chunks are handed out from the front */
+    for(uint64_t i = 0; i < chunk_count; i++)
+    {
+        DMABuffer_initSlice(&new_pool->chunks[i], new_pool->buffer,
+                            i * new_pool->stride, chunk_size);
+        new_pool->free_stack[i] = chunk_count - 1 - i;
+    }
+    new_pool->free_count = chunk_count;
+
+    if(pthread_mutex_init(&new_pool->lock, NULL) != 0)
+    { ERROR_EXIT( errno, exit, "Mutex initialization failed!\n" ); }
+
+    if(pthread_key_create(&new_pool->cache_key, DMAPool_destroyCache) != 0)
+    {
+        pthread_mutex_destroy(&new_pool->lock);
+        ERROR_EXIT( errno, exit, "Thread key creation failed!\n" );
+    }
+
+    DEBUG_PRINTF(PDADEBUG_VALUE, "Pool with %" PRIu64 " chunks of %zu bytes (stride %zu)\n",
+                 chunk_count, chunk_size, new_pool->stride);
+
+    *pool = new_pool;
+    RETURN(PDA_SUCCESS);
+
+exit:
+    if(DMAPool_release(new_pool) != PDA_SUCCESS)
+    { DEBUG_PRINTF(PDADEBUG_ERROR, "Releasing the pool buffer failed!\n"); }
+    RETURN(ERROR(ENOMEM, "Pool allocation failed!\n") );
+}
+
+
+
+PdaDebugReturnCode
+DMAPool_delete
+(
+    DMAPool *pool
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(pool == NULL)
+    { RETURN(PDA_SUCCESS); }
+
+    /** No destructor must run after this point, so free all caches here */
+    pthread_key_delete(pool->cache_key);
+
+    DMAPoolCache *cache = pool->caches;
+    while(cache != NULL)
+    {
+        DMAPoolCache *next = cache->next;
+        free(cache);
+        cache = next;
+    }
+    pool->caches = NULL;
+
+    pthread_mutex_destroy(&pool->lock);
+
+    RETURN(DMAPool_release(pool) );
+}
+
+
+
+PdaDebugReturnCode
+DMAPool_alloc
+(
+    DMAPool    *pool,
+    DMABuffer **chunk
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (pool == NULL) || (chunk == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *chunk = NULL;
+
+    DMAPoolCache *cache = DMAPool_getCache(pool);
+    if(cache == NULL)
+    { RETURN( ERROR(ENOMEM, "Thread cache allocation failed!\n") ); }
+
+    if(cache->count == 0)
+    {
+        pthread_mutex_lock(&pool->lock);
+        for(uint64_t i = 0; (i < DMA_POOL_CACHE_BATCH) && (pool->free_count > 0); i++)
+        {
+            pool->free_count--;
+            cache->entries[cache->count] = pool->free_stack[pool->free_count];
+            cache->count++;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    if(cache->count == 0)
+    {
+        DEBUG_PRINTF(PDADEBUG_ERROR, "Pool exhausted!\n");
+        RETURN(ENOMEM);
+    }
+
+    cache->count--;
+    *chunk = &pool->chunks[cache->entries[cache->count] ];
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMAPool_free
+(
+    DMAPool   *pool,
+    DMABuffer *chunk
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (pool == NULL) || (chunk == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (chunk < pool->chunks) || (chunk >= (pool->chunks + pool->chunk_count) ) )
+    { RETURN( ERROR(EINVAL, "Chunk does not belong to this pool!\n") ); }
+
+    DMAPoolCache *cache = DMAPool_getCache(pool);
+    if(cache == NULL)
+    { RETURN( ERROR(ENOMEM, "Thread cache allocation failed!\n") ); }
+
+    if(cache->count == DMA_POOL_CACHE_SIZE)
+    {
+        pthread_mutex_lock(&pool->lock);
+        DMAPool_flushCache(cache, DMA_POOL_CACHE_BATCH);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    cache->entries[cache->count] = (uint64_t)(chunk - pool->chunks);
+    cache->count++;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMAPool_getBuffer
+(
+    const DMAPool  *pool,
+    DMABuffer     **buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (pool == NULL) || (buffer == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *buffer = pool->buffer;
+    RETURN(PDA_SUCCESS);
+}
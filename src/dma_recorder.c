@@ -0,0 +1,772 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <dma_buffer_int.h>
+#include <pda.h>
+#include <pda/dma_recorder.h>
+
+#include "config.h"
+
+#ifdef IO_URING_AVAIL
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+#endif /* IO_URING_AVAIL */
+
+#define DMA_RECORDER_ALIGNED(value) ( ( (uint64_t)(value) & (PDA_RECORDER_ALIGNMENT - 1) ) == 0 )
+
+/** One write request, the slot of a request is its sequence number modulo the queue depth */
+typedef struct DMARecorderRequest_struct
+{
+    struct iovec  iov;
+    uint64_t      file_offset;
+    uint64_t      length;
+    uint64_t      done;
+    bool          direct;
+    bool          finished;
+} DMARecorderRequest;
+
+#ifdef IO_URING_AVAIL
+/** Rings which are shared with the kernel, set up without liburing */
+typedef struct DMARecorderRing_struct
+{
+    int                  fd;
+    void                *sq_map;
+    size_t               sq_map_length;
+    void                *cq_map;
+    size_t               cq_map_length;
+    struct io_uring_sqe *sqes;
+    size_t               sqes_length;
+
+    uint32_t            *sq_head;
+    uint32_t            *sq_tail;
+    uint32_t            *sq_mask;
+    uint32_t            *sq_array;
+
+    uint32_t            *cq_head;
+    uint32_t            *cq_tail;
+    uint32_t            *cq_mask;
+    struct io_uring_cqe *cqes;
+} DMARecorderRing;
+#endif /* IO_URING_AVAIL */
+
+struct DMARecorder_struct
+{
+    DMABuffer          *buffer;
+
+    int                 fd;
+    bool                direct;
+    bool                direct_supported;
+
+    uint64_t            queue_depth;
+    uint64_t            request_size;
+    DMARecorderRequest *requests;
+
+    /** Sequence numbers of the next request and of the oldest unfinished request */
+    uint64_t            submitted;
+    uint64_t            completed;
+    uint64_t            pending;
+    uint64_t            file_offset;
+    uint64_t            written;
+    int                 error;
+
+    uint64_t            bytes;
+    uint64_t            bytes_direct;
+    uint64_t            requests_done;
+    uint64_t            max_pending;
+    uint64_t            start_time;
+    uint64_t            stop_time;
+
+    #ifdef IO_URING_AVAIL
+    bool                uring;
+    DMARecorderRing     ring;
+    #endif /* IO_URING_AVAIL */
+};
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+#ifdef IO_URING_AVAIL
+static int
+DMARecorder_setupRing
+(
+    DMARecorderRing *ring,
+    const uint32_t   entries
+)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params) );
+    memset(ring, 0, sizeof(DMARecorderRing) );
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if(ring->fd < 0)
+    { return(errno); }
+
+    ring->sq_map_length = params.sq_off.array + (params.sq_entries * sizeof(uint32_t) );
+    ring->cq_map_length = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe) );
+    ring->sqes_length   = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /** Since Linux 5.4 both rings live in one mapping */
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(ring->cq_map_length > ring->sq_map_length)
+        { ring->sq_map_length = ring->cq_map_length; }
+        ring->cq_map_length = 0;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_length, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if(ring->sq_map == MAP_FAILED)
+    { goto out_close; }
+
+    ring->cq_map = ring->sq_map;
+    if(ring->cq_map_length != 0)
+    {
+        ring->cq_map = mmap(NULL, ring->cq_map_length, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if(ring->cq_map == MAP_FAILED)
+        { goto out_sq; }
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_length, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED)
+    { goto out_cq; }
+
+    uint8_t *sq = (uint8_t*)ring->sq_map;
+    ring->sq_head  = (uint32_t*)(sq + params.sq_off.head);
+    ring->sq_tail  = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sq_mask  = (uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (uint32_t*)(sq + params.sq_off.array);
+
+    uint8_t *cq = (uint8_t*)ring->cq_map;
+    ring->cq_head = (uint32_t*)(cq + params.cq_off.head);
+    ring->cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cq_mask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes    = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return(PDA_SUCCESS);
+
+out_cq:
+    if(ring->cq_map_length != 0)
+    { munmap(ring->cq_map, ring->cq_map_length); }
+out_sq:
+    munmap(ring->sq_map, ring->sq_map_length);
+out_close:
+    close(ring->fd);
+    return(ENOMEM);
+}
+
+
+
+static void
+DMARecorder_teardownRing(DMARecorderRing *ring)
+{
+    munmap(ring->sqes, ring->sqes_length);
+    if(ring->cq_map_length != 0)
+    { munmap(ring->cq_map, ring->cq_map_length); }
+    munmap(ring->sq_map, ring->sq_map_length);
+    close(ring->fd);
+}
+
+
+
+static int
+DMARecorder_enter
+(
+    DMARecorderRing *ring,
+    const uint32_t   to_submit,
+    const uint32_t   min_complete
+)
+{
+    uint32_t flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+
+    for(;;)
+    {
+        if(syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, NULL, 0) >= 0)
+        { return(PDA_SUCCESS); }
+
+        if(errno != EINTR)
+        { return(errno); }
+    }
+}
+
+
+
+/** Queue a write of the (remaining part of the) request into the submission ring */
+static int
+DMARecorder_submitRing
+(
+    DMARecorder    *recorder,
+    const uint64_t  sequence
+)
+{
+    DMARecorderRing    *ring    = &recorder->ring;
+    DMARecorderRequest *request = &recorder->requests[sequence % recorder->queue_depth];
+
+    uint32_t             tail  = *ring->sq_tail;
+    uint32_t             index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe   = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe) );
+    sqe->opcode    = IORING_OP_WRITEV;
+    sqe->fd        = recorder->fd;
+    sqe->addr      = (uint64_t)(uintptr_t)&request->iov;
+    sqe->len       = 1;
+    sqe->off       = request->file_offset + request->done;
+    sqe->user_data = sequence;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    /** A failed enter leaves the entry in the ring, take it back so that the
+     *  next submit doesn't send it a second time */
+    int ret = DMARecorder_enter(ring, 1, 0);
+    if( (ret != PDA_SUCCESS) && (__atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == tail) )
+    { __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE); }
+
+    return(ret);
+}
+#endif /* IO_URING_AVAIL */
+
+
+
+/** Account the result of a write and resubmit the rest of a short write */
+static void
+DMARecorder_complete
+(
+    DMARecorder    *recorder,
+    const uint64_t  sequence,
+    const int64_t   result
+)
+{
+    DMARecorderRequest *request = &recorder->requests[sequence % recorder->queue_depth];
+
+    /** Direct I/O fails for memory which can't be pinned, the request is written
+     *  through the page cache then, as all further ones */
+    if( (result == -EFAULT) && request->direct )
+    {
+        recorder->direct_supported = false;
+
+        int flags = fcntl(recorder->fd, F_GETFL);
+        if( !recorder->direct ||
+            ( (flags >= 0) && (fcntl(recorder->fd, F_SETFL, flags & ~O_DIRECT) == 0) ) )
+        {
+            recorder->direct = false;
+            request->direct  = false;
+
+            #ifdef IO_URING_AVAIL
+            if(recorder->uring)
+            {
+                int ret = DMARecorder_submitRing(recorder, sequence);
+                if(ret == PDA_SUCCESS)
+                { return; }
+                DMARecorder_complete(recorder, sequence, -ret);
+            }
+            #endif /* IO_URING_AVAIL */
+
+            return;
+        }
+    }
+
+    if(result < 0)
+    {
+        if(recorder->error == 0)
+        { recorder->error = (int)-result; }
+        request->finished = true;
+    }
+    else if(result == 0)
+    {
+        if(recorder->error == 0)
+        { recorder->error = EIO; }
+        request->finished = true;
+    }
+    else
+    {
+        request->done += (uint64_t)result;
+        if(request->done < request->length)
+        {
+            request->iov.iov_base = (uint8_t*)request->iov.iov_base + result;
+            request->iov.iov_len -= (size_t)result;
+
+            #ifdef IO_URING_AVAIL
+            if(recorder->uring)
+            {
+                int ret = DMARecorder_submitRing(recorder, sequence);
+                if(ret == PDA_SUCCESS)
+                { return; }
+                DMARecorder_complete(recorder, sequence, -ret);
+                return;
+            }
+            #endif /* IO_URING_AVAIL */
+
+            return;
+        }
+
+        request->finished       = true;
+        recorder->bytes        += request->length;
+        recorder->requests_done++;
+        if(request->direct)
+        { recorder->bytes_direct += request->length; }
+    }
+
+    recorder->pending--;
+    recorder->stop_time = DMABuffer_timeNs();
+
+    /** The buffer can only be reused in submission order */
+    while(recorder->completed < recorder->submitted)
+    {
+        DMARecorderRequest *oldest =
+            &recorder->requests[recorder->completed % recorder->queue_depth];
+        if(!oldest->finished)
+        { break; }
+
+        if(oldest->done == oldest->length)
+        { recorder->written += oldest->length; }
+        recorder->completed++;
+    }
+}
+
+
+
+/** Reap finished requests, wait for at least one if wait is set and a request is in flight */
+static int
+DMARecorder_reap
+(
+    DMARecorder *recorder,
+    const bool   wait
+)
+{
+    #ifdef IO_URING_AVAIL
+    if(recorder->uring)
+    {
+        DMARecorderRing *ring = &recorder->ring;
+
+        for(;;)
+        {
+            uint32_t head  = *ring->cq_head;
+            uint32_t tail  = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+            bool     found = (head != tail);
+
+            for(; head != tail; head++)
+            {
+                struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+                uint64_t sequence = cqe->user_data;
+                int64_t  result   = cqe->res;
+
+                __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+                DMARecorder_complete(recorder, sequence, result);
+            }
+
+            if(found || !wait || (recorder->pending == 0) )
+            { return(PDA_SUCCESS); }
+
+            int ret = DMARecorder_enter(ring, 0, 1);
+            if(ret != PDA_SUCCESS)
+            { return(ret); }
+        }
+    }
+    #endif /* IO_URING_AVAIL */
+
+    /** Synchronous writes are finished at submission */
+    return(PDA_SUCCESS);
+}
+
+
+
+static int
+DMARecorder_drain(DMARecorder *recorder)
+{
+    while(recorder->pending > 0)
+    {
+        int ret = DMARecorder_reap(recorder, true);
+        if(ret != PDA_SUCCESS)
+        { return(ret); }
+    }
+
+    return(PDA_SUCCESS);
+}
+
+
+
+/** Switch O_DIRECT on or off, requests in flight must be finished before */
+static int
+DMARecorder_setDirect
+(
+    DMARecorder *recorder,
+    const bool   direct
+)
+{
+    int ret = DMARecorder_drain(recorder);
+    if(ret != PDA_SUCCESS)
+    { return(ret); }
+
+    int flags = fcntl(recorder->fd, F_GETFL);
+    if(flags < 0)
+    { return(errno); }
+
+    flags = direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    if(fcntl(recorder->fd, F_SETFL, flags) != 0)
+    {
+        if(direct)
+        {
+            recorder->direct_supported = false;
+            return(PDA_SUCCESS);
+        }
+        return(errno);
+    }
+
+    recorder->direct = direct;
+    return(PDA_SUCCESS);
+}
+
+
+
+static int
+DMARecorder_submit
+(
+    DMARecorder *recorder,
+    uint8_t     *data,
+    const size_t length
+)
+{
+    bool direct = recorder->direct_supported && DMA_RECORDER_ALIGNED(data) &&
+                  DMA_RECORDER_ALIGNED(length) && DMA_RECORDER_ALIGNED(recorder->file_offset);
+
+    if(direct != recorder->direct)
+    {
+        int ret = DMARecorder_setDirect(recorder, direct);
+        if(ret != PDA_SUCCESS)
+        { return(ret); }
+    }
+
+    while( (recorder->submitted - recorder->completed) >= recorder->queue_depth )
+    {
+        int ret = DMARecorder_reap(recorder, true);
+        if(ret != PDA_SUCCESS)
+        { return(ret); }
+    }
+
+    if(recorder->error != 0)
+    { return(recorder->error); }
+
+    uint64_t            sequence = recorder->submitted;
+    DMARecorderRequest *request  = &recorder->requests[sequence % recorder->queue_depth];
+
+    request->iov.iov_base = data;
+    request->iov.iov_len  = length;
+    request->file_offset  = recorder->file_offset;
+    request->length       = length;
+    request->done         = 0;
+    request->direct       = recorder->direct;
+    request->finished     = false;
+
+    recorder->submitted++;
+    recorder->pending++;
+    recorder->file_offset += length;
+
+    if(recorder->pending > recorder->max_pending)
+    { recorder->max_pending = recorder->pending; }
+
+    if(recorder->start_time == 0)
+    { recorder->start_time = DMABuffer_timeNs(); }
+
+    #ifdef IO_URING_AVAIL
+    if(recorder->uring)
+    {
+        int ret = DMARecorder_submitRing(recorder, sequence);
+        if(ret != PDA_SUCCESS)
+        { DMARecorder_complete(recorder, sequence, -ret); }
+        return(ret);
+    }
+    #endif /* IO_URING_AVAIL */
+
+    while(!request->finished)
+    {
+        ssize_t result = pwritev(recorder->fd, &request->iov, 1,
+                                 (off_t)(request->file_offset + request->done) );
+        if( (result < 0) && (errno == EINTR) )
+        { continue; }
+
+        DMARecorder_complete(recorder, sequence, (result < 0) ? -errno : result);
+    }
+
+    return(recorder->error);
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMARecorder_new
+(
+    DMABuffer     *buffer,
+    const char    *path,
+    const uint64_t queue_depth,
+    const uint64_t request_size,
+    DMARecorder  **recorder
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (path == NULL) || (recorder == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *recorder = NULL;
+
+    if(!DMA_RECORDER_ALIGNED(request_size) || (queue_depth > 4096) )
+    { RETURN( ERROR(EINVAL, "Invalid queue depth or request size!\n") ); }
+
+    size_t length = 0;
+    if(DMABuffer_getLength(buffer, &length) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Invalid buffer!\n") ); }
+
+    DMARecorder *new_recorder = calloc(1, sizeof(DMARecorder) );
+    if(new_recorder == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    new_recorder->buffer       = buffer;
+    new_recorder->queue_depth  = (queue_depth == 0) ? PDA_RECORDER_QUEUE_DEPTH : queue_depth;
+    new_recorder->request_size = (request_size == 0) ? PDA_RECORDER_REQUEST_SIZE : request_size;
+
+    new_recorder->requests = calloc(new_recorder->queue_depth, sizeof(DMARecorderRequest) );
+    if(new_recorder->requests == NULL)
+    { ERROR_EXIT(ENOMEM, out_recorder, "Memory allocation failed!\n"); }
+
+    /** Mappings of kernel memory (VM_IO | VM_PFNMAP) can't be pinned for direct I/O */
+    const DMABuffer *root = buffer;
+    while(root->parent != NULL)
+    { root = root->parent; }
+
+    /** Some file systems (e.g. tmpfs) do not support direct I/O */
+    new_recorder->direct           = (root->type == PDA_BUFFER_USER);
+    new_recorder->direct_supported = new_recorder->direct;
+    new_recorder->fd               = -1;
+    if(new_recorder->direct)
+    {
+        new_recorder->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+        if( (new_recorder->fd < 0) && (errno == EINVAL) )
+        {
+            new_recorder->direct           = false;
+            new_recorder->direct_supported = false;
+        }
+    }
+
+    if(!new_recorder->direct)
+    { new_recorder->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); }
+
+    if(new_recorder->fd < 0)
+    { ERROR_EXIT(errno, out_requests, "Opening the file failed!\n"); }
+
+    #ifdef IO_URING_AVAIL
+    if(DMARecorder_setupRing(&new_recorder->ring, (uint32_t)new_recorder->queue_depth)
+        == PDA_SUCCESS)
+    { new_recorder->uring = true; }
+    else
+    { DEBUG_PRINTF(PDADEBUG_CONTROL_FLOW, "io_uring unavailable, writing synchronously\n"); }
+    #endif /* IO_URING_AVAIL */
+
+    *recorder = new_recorder;
+
+    RETURN(PDA_SUCCESS);
+
+out_requests:
+    free(new_recorder->requests);
+out_recorder:
+    free(new_recorder);
+
+    RETURN(ERROR(EINVAL, "Creating the recorder failed!\n"));
+}
+
+
+
+PdaDebugReturnCode
+DMARecorder_delete
+(
+    DMARecorder *recorder
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(recorder == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    int ret = DMARecorder_drain(recorder);
+    if(ret == PDA_SUCCESS)
+    { ret = recorder->error; }
+
+    #ifdef IO_URING_AVAIL
+    if(recorder->uring)
+    { DMARecorder_teardownRing(&recorder->ring); }
+    #endif /* IO_URING_AVAIL */
+
+    if( (close(recorder->fd) != 0) && (ret == PDA_SUCCESS) )
+    { ret = errno; }
+
+    free(recorder->requests);
+    free(recorder);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Writing the file failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARecorder_write
+(
+    DMARecorder  *recorder,
+    const size_t  offset,
+    const size_t  length
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(recorder == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(recorder->error != 0)
+    { RETURN( ERROR(recorder->error, "A previous write failed!\n") ); }
+
+    DMABufferRange range;
+    if(DMABuffer_resolveRange(recorder->buffer, offset, length, &range) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Range exceeds the buffer!\n") ); }
+
+    for(uint8_t i = 0; i < 2; i++)
+    {
+        for(size_t done = 0; done < range.length[i]; done += recorder->request_size)
+        {
+            size_t chunk = range.length[i] - done;
+            if(chunk > recorder->request_size)
+            { chunk = recorder->request_size; }
+
+            int ret = DMARecorder_submit(recorder, range.pointer[i] + done, chunk);
+            if(ret != PDA_SUCCESS)
+            { RETURN( ERROR(ret, "Submitting the write failed!\n") ); }
+        }
+    }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARecorder_getWritten
+(
+    DMARecorder *recorder,
+    uint64_t    *bytes
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (recorder == NULL) || (bytes == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    int ret = DMARecorder_reap(recorder, false);
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Reaping completions failed!\n") ); }
+
+    *bytes = recorder->written;
+
+    if(recorder->error != 0)
+    { RETURN( ERROR(recorder->error, "A write failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARecorder_flush
+(
+    DMARecorder *recorder
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(recorder == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    int ret = DMARecorder_drain(recorder);
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Waiting for completions failed!\n") ); }
+
+    if(recorder->error != 0)
+    { RETURN( ERROR(recorder->error, "A write failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARecorder_getStatistics
+(
+    DMARecorder           *recorder,
+    DMARecorderStatistics *statistics
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (recorder == NULL) || (statistics == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(DMARecorder_reap(recorder, false) != PDA_SUCCESS)
+    { RETURN( ERROR(EIO, "Reaping completions failed!\n") ); }
+
+    statistics->bytes       = recorder->bytes;
+    statistics->requests    = recorder->requests_done;
+    statistics->direct      = recorder->bytes_direct;
+    statistics->max_pending = recorder->max_pending;
+    statistics->nanoseconds = (recorder->stop_time > recorder->start_time)
+        ? (recorder->stop_time - recorder->start_time) : 0;
+    statistics->bandwidth   = (statistics->nanoseconds == 0) ? 0.0
+        : ( (double)statistics->bytes * 1e9) / (double)statistics->nanoseconds;
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,331 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <pda.h>
+#include <pda/dma_ring.h>
+
+#include "config.h"
+
+#define DMA_RING_CACHE_LINE 64
+
+struct DMARing_struct
+{
+    /** Producer cache line: own position and consumer position seen by the last reserve */
+    uint64_t     head;
+    uint64_t     cached_tail;
+    uint8_t      pad_producer[DMA_RING_CACHE_LINE - (2 * sizeof(uint64_t))];
+
+    /** Consumer cache line: own position and producer position seen by the last peek */
+    uint64_t     tail;
+    uint64_t     cached_head;
+    uint8_t      pad_consumer[DMA_RING_CACHE_LINE - (2 * sizeof(uint64_t))];
+
+    /** Read-only after setup */
+    DMABuffer   *buffer;
+    uint8_t     *map;
+    uint64_t     length;
+
+    const Bar   *bar;
+    Bar_address  device_pointer;
+    Bar_address  host_pointer;
+    uint8_t      register_size;
+} __attribute__((aligned(DMA_RING_CACHE_LINE)));
+
+/*-internal-functions---------------------------------------------------------------------*/
+
+static inline
+uint64_t
+DMARing_readDevicePointer(const DMARing *ring)
+{
+    uint64_t offset = (ring->register_size == 4)
+        ? (uint64_t)Bar_get32(ring->bar, ring->device_pointer)
+        : Bar_get64(ring->bar, ring->device_pointer);
+
+    /** Data must not be read before the register */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return(offset % ring->length);
+}
+
+
+
+static inline
+void
+DMARing_writeHostPointer
+(
+    const DMARing  *ring,
+    const uint64_t  position
+)
+{
+    if(ring->host_pointer == PDA_RING_REGISTER_NONE)
+    { return; }
+
+    /** All accesses to the data must be finished before the device sees the position */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint64_t offset = position % ring->length;
+    if(ring->register_size == 4)
+    { Bar_put32(ring->bar, (uint32_t)offset, ring->host_pointer); }
+    else
+    { Bar_put64(ring->bar, offset, ring->host_pointer); }
+}
+
+/*-external-functions---------------------------------------------------------------------*/
+
+PdaDebugReturnCode
+DMARing_new
+(
+    DMABuffer  *buffer,
+    DMARing   **ring
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (buffer == NULL) || (ring == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *ring = NULL;
+
+    void *map_two = MAP_FAILED;
+    if(DMABuffer_getMapTwo(buffer, &map_two) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Getting the second mapping failed!\n") ); }
+
+    if( (map_two == MAP_FAILED) || (map_two == NULL) )
+    {
+        if(DMABuffer_wrapMap(buffer) != PDA_SUCCESS)
+        { RETURN( ERROR(EINVAL, "Wrap mapping the ring buffer failed!\n") ); }
+    }
+
+    void   *map    = NULL;
+    size_t  length = 0;
+    if( (DMABuffer_getMap(buffer, &map) != PDA_SUCCESS) ||
+        (DMABuffer_getLength(buffer, &length) != PDA_SUCCESS) || (length == 0) )
+    { RETURN( ERROR(EINVAL, "Invalid ring buffer!\n") ); }
+
+    DMARing *new_ring = NULL;
+    if(posix_memalign( (void**)&new_ring, DMA_RING_CACHE_LINE, sizeof(DMARing) ) != 0)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    memset(new_ring, 0, sizeof(DMARing) );
+    new_ring->buffer         = buffer;
+    new_ring->map            = (uint8_t*)map;
+    new_ring->length         = length;
+    new_ring->bar            = NULL;
+    new_ring->device_pointer = PDA_RING_REGISTER_NONE;
+    new_ring->host_pointer   = PDA_RING_REGISTER_NONE;
+
+    *ring = new_ring;
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_delete
+(
+    DMARing *ring
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(ring != NULL)
+    { free(ring); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_setDeviceRegisters
+(
+    DMARing           *ring,
+    const Bar         *bar,
+    const Bar_address  device_pointer,
+    const Bar_address  host_pointer,
+    const uint8_t      register_size
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (ring == NULL) || (bar == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if( (register_size != 4) && (register_size != 8) )
+    { RETURN( ERROR(EINVAL, "Invalid register size!\n") ); }
+
+    if( (register_size == 4) && (ring->length > UINT32_MAX) )
+    { RETURN( ERROR(EINVAL, "Buffer is too large for 32 bit registers!\n") ); }
+
+    ring->bar            = bar;
+    ring->device_pointer = device_pointer;
+    ring->host_pointer   = host_pointer;
+    ring->register_size  = register_size;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_peek
+(
+    DMARing   *ring,
+    void     **data,
+    uint64_t  *bytes
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uint64_t tail      = ring->tail;
+    uint64_t available = 0;
+
+    if(ring->device_pointer != PDA_RING_REGISTER_NONE)
+    {
+        uint64_t offset = DMARing_readDevicePointer(ring);
+        available = (offset + ring->length - (tail % ring->length) ) % ring->length;
+    }
+    else
+    { available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail; }
+
+    ring->cached_head = tail + available;
+
+    *data  = ring->map + (tail % ring->length);
+    *bytes = available;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_consume
+(
+    DMARing        *ring,
+    const uint64_t  bytes
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uint64_t tail = ring->tail;
+    if(bytes > (ring->cached_head - tail) )
+    { RETURN( ERROR(EINVAL, "Consuming more data than available!\n") ); }
+
+    tail = tail + bytes;
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    DMARing_writeHostPointer(ring, tail);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_reserve
+(
+    DMARing   *ring,
+    void     **data,
+    uint64_t  *bytes
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uint64_t head  = ring->head;
+    uint64_t space = 0;
+
+    if(ring->device_pointer != PDA_RING_REGISTER_NONE)
+    {
+        uint64_t offset = DMARing_readDevicePointer(ring);
+        uint64_t used   = ( (head % ring->length) + ring->length - offset) % ring->length;
+        space = ring->length - 1 - used;
+    }
+    else
+    { space = ring->length - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) ); }
+
+    ring->cached_tail = head + space - ring->length;
+
+    *data  = ring->map + (head % ring->length);
+    *bytes = space;
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_commit
+(
+    DMARing        *ring,
+    const uint64_t  bytes
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    uint64_t head = ring->head;
+    if(bytes > (ring->length - (head - ring->cached_tail) ) )
+    { RETURN( ERROR(EINVAL, "Committing more data than reserved!\n") ); }
+
+    head = head + bytes;
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    DMARing_writeHostPointer(ring, head);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+DMARing_getBuffer
+(
+    const DMARing  *ring,
+    DMABuffer     **buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (ring == NULL) || (buffer == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    *buffer = ring->buffer;
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,197 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <pda.h>
+#include <parallel_int.h>
+
+#include "config.h"
+
+#ifdef NUMA_AVAIL
+    #include <numa.h>
+#endif /* NUMA_AVAIL */
+
+typedef struct PdaParallelThread_struct
+{
+    PdaParallelFunction  function;
+    void                *context;
+    uint64_t             thread;
+    uint64_t             threads;
+    int32_t              numa_node;
+} PdaParallelThread;
+
+
+
+static void*
+pda_parallelWorker(void *arg)
+{
+    PdaParallelThread *worker = (PdaParallelThread*)arg;
+
+    #ifdef NUMA_AVAIL
+    if( (worker->numa_node >= 0) && (numa_available() != -1) )
+    { numa_run_on_node(worker->numa_node); }
+    #endif /* NUMA_AVAIL */
+
+    worker->function(worker->context, worker->thread, worker->threads);
+    return(NULL);
+}
+
+
+
+/** Threads are only pinned if the node is known and libnuma works */
+static inline
+bool
+pda_parallelPinned(const int32_t numa_node)
+{
+    #ifdef NUMA_AVAIL
+    return( (numa_node >= 0) && (numa_available() != -1) );
+    #else
+    return(false);
+    #endif /* NUMA_AVAIL */
+}
+
+
+
+/** Number of CPUs of a NUMA node, 0 if it can't be determined */
+static uint64_t
+pda_parallelNodeCpus(const int32_t numa_node)
+{
+    uint64_t cpus = 0;
+
+    #ifdef NUMA_AVAIL
+    if(pda_parallelPinned(numa_node))
+    {
+        struct bitmask *mask = numa_allocate_cpumask();
+        if(mask != NULL)
+        {
+            if(numa_node_to_cpus(numa_node, mask) == 0)
+            { cpus = numa_bitmask_weight(mask); }
+            numa_free_cpumask(mask);
+        }
+    }
+    #endif /* NUMA_AVAIL */
+
+    return(cpus);
+}
+
+
+
+uint64_t
+pda_parallelThreads
+(
+    const uint64_t requested,
+    const uint64_t work_items,
+    const int32_t  numa_node
+)
+{
+    /** By default one thread per CPU of the node the threads are pinned to */
+    uint64_t threads = requested;
+    if(threads == 0)
+    { threads = pda_parallelNodeCpus(numa_node); }
+
+    if(threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads   = (cpus > 0) ? (uint64_t)cpus : 1;
+    }
+
+    if(threads > PDA_PARALLEL_MAX_THREADS)
+    { threads = PDA_PARALLEL_MAX_THREADS; }
+
+    if(threads > work_items)
+    { threads = work_items; }
+
+    return( (threads == 0) ? 1 : threads );
+}
+
+
+
+PdaDebugReturnCode
+pda_parallelRun
+(
+    const uint64_t       threads,
+    const int32_t        numa_node,
+    PdaParallelFunction  function,
+    void                *context
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (function == NULL) || (threads == 0) || (threads > PDA_PARALLEL_MAX_THREADS) )
+    { RETURN( ERROR(EINVAL, "Invalid parallel section!\n") ); }
+
+    PdaParallelThread workers[PDA_PARALLEL_MAX_THREADS];
+    pthread_t         handles[PDA_PARALLEL_MAX_THREADS];
+    bool              started[PDA_PARALLEL_MAX_THREADS];
+
+    /** The calling thread keeps its placement, so it only takes share 0 if no
+     *  node is given, otherwise all shares run in pinned threads */
+    uint64_t first = pda_parallelPinned(numa_node) ? 0 : 1;
+    for(uint64_t i = first; i < threads; i++)
+    {
+        workers[i].function  = function;
+        workers[i].context   = context;
+        workers[i].thread    = i;
+        workers[i].threads   = threads;
+        workers[i].numa_node = numa_node;
+
+        started[i] = (pthread_create(&handles[i], NULL, pda_parallelWorker, &workers[i]) == 0);
+        if(!started[i])
+        { DEBUG_PRINTF(PDADEBUG_ERROR, "Thread creation failed, running share inline!\n"); }
+    }
+
+    if(first != 0)
+    { function(context, 0, threads); }
+
+    /** Shares of threads which could not be started are processed here */
+    for(uint64_t i = first; i < threads; i++)
+    {
+        if(started[i])
+        { pthread_join(handles[i], NULL); }
+        else
+        { function(context, i, threads); }
+    }
+
+    RETURN(PDA_SUCCESS);
+}
@@ -0,0 +1,76 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PARALLEL_INT_H
+#define PARALLEL_INT_H
+
+#include <pda/defines.h>
+#include <pda/debug.h>
+#include <stdint.h>
+
+/** Upper bound for the number of threads used by library internal parallel sections */
+#define PDA_PARALLEL_MAX_THREADS 32
+
+/** Work function of a parallel section. Each call gets its own thread number
+ *  (0 <= thread < threads) and has to pick its share of the work on its own. */
+typedef void
+(*PdaParallelFunction)
+(
+    void           *context,
+    const uint64_t  thread,
+    const uint64_t  threads
+);
+
+/* Internal Functions */
+uint64_t
+pda_parallelThreads
+(
+    const uint64_t requested,
+    const uint64_t work_items,
+    const int32_t  numa_node
+) PDA_WARN_UNUSED_RETURN;
+
+PdaDebugReturnCode
+pda_parallelRun
+(
+    const uint64_t       threads,
+    const int32_t        numa_node,
+    PdaParallelFunction  function,
+    void                *context
+) PDA_WARN_UNUSED_RETURN;
+
+#endif /*PARALLEL_INT_H*/
@@ -47,6 +47,7 @@
 #include <sys/types.h>
 
 #include <pthread.h>
+#include <sys/eventfd.h>
 
 #include <pci/pci.h>
 
@@ -88,6 +89,21 @@ PciDevice_new_int(void);
 
 typedef struct PciDeviceInternal_struct PciDeviceInternal;
 
+/** An asynchronous buffer allocation, queued on the device when it finished */
+typedef struct PciDeviceAllocation_struct PciDeviceAllocation;
+
+struct PciDeviceAllocation_struct
+{
+    PciDevice               *device;
+    uint64_t                 index;
+    size_t                   size;
+    PciDevice_AllocCallback  callback;
+    void                    *ctx;
+    DMABuffer               *buffer;
+    PdaDebugReturnCode       ret;
+    PciDeviceAllocation     *next;
+};
+
 struct PciDevice_struct
 {
     char vendor_str[7];
@@ -117,6 +133,28 @@ struct PciDevice_struct
 
     DMABuffer *dma_buffer_list;
 
+    /* deferred buffer freeing */
+    pthread_mutex_t      free_lock;
+    pthread_cond_t       free_cond;
+    pthread_t            free_thread;
+    bool                 free_deferred;
+    bool                 free_stop;
+    DMABuffer           *free_first;
+    DMABuffer           *free_last;
+    DMABuffer           *free_active;
+    PdaDebugReturnCode   free_ret;
+
+    /* cached user memory registrations, created on first use */
+    DMABufferCache *registration_cache;
+
+    /* asynchronous buffer allocations */
+    pthread_mutex_t      alloc_lock;
+    pthread_cond_t       alloc_cond;
+    int                  alloc_event_fd;
+    uint64_t             alloc_pending;
+    uint64_t             alloc_next_index;
+    PciDeviceAllocation *alloc_done;
+
     uint64_t  *dma_buffer_id_list;
     uint64_t   dma_buffer_id_list_max_entries;
 
@@ -149,8 +187,24 @@ PciDevice_new_int(void)
     if(device->internal == NULL)
     { ERROR_EXIT( ENOMEM, exit, "Memory allocation failed!\n" ); }
 
+    pthread_mutex_init(&device->alloc_lock, NULL);
+    pthread_cond_init(&device->alloc_cond, NULL);
+    pthread_mutex_init(&device->free_lock, NULL);
+    pthread_cond_init(&device->free_cond, NULL);
+
     device->interrupt                      = NULL;
     device->dma_buffer_list                = NULL;
+    device->registration_cache             = NULL;
+    device->free_deferred                  = false;
+    device->free_stop                      = false;
+    device->free_first                     = NULL;
+    device->free_last                      = NULL;
+    device->free_active                    = NULL;
+    device->free_ret                       = PDA_SUCCESS;
+    device->alloc_event_fd                 = -1;
+    device->alloc_pending                  = 0;
+    device->alloc_next_index               = 0;
+    device->alloc_done                     = NULL;
     device->dma_buffer_id_list             = NULL;
     device->dma_buffer_id_list_max_entries = 256;
 
@@ -409,6 +463,231 @@ PciDevice_invoke_libpci
 
 
 
+/** The reaper thread, frees the queued buffers one after another */
+static void*
+PciDevice_freeThread(void *arg)
+{
+    PciDevice *device = (PciDevice*)arg;
+
+    pthread_mutex_lock(&device->free_lock);
+    while(true)
+    {
+        while( (device->free_first == NULL) && !device->free_stop )
+        { pthread_cond_wait(&device->free_cond, &device->free_lock); }
+
+        if(device->free_first == NULL)
+        { break; }
+
+        DMABuffer *buffer   = device->free_first;
+        device->free_first  = buffer->next;
+        if(device->free_first == NULL)
+        { device->free_last = NULL; }
+        device->free_active = buffer;
+        buffer->next        = NULL;
+        pthread_mutex_unlock(&device->free_lock);
+
+        PdaDebugReturnCode ret = DMABuffer_free(buffer, PDA_DELETE);
+
+        pthread_mutex_lock(&device->free_lock);
+        device->free_ret   += ret;
+        device->free_active = NULL;
+        pthread_cond_broadcast(&device->free_cond);
+    }
+    pthread_mutex_unlock(&device->free_lock);
+
+    return(NULL);
+}
+
+
+
+/** Kernel side buffer names are only reusable after the reaper has freed them */
+static inline
+bool
+PciDevice_isFreePending
+(
+    PciDevice      *device,
+    const uint64_t  index
+)
+{
+    if( (device->free_active != NULL) && (device->free_active->index == index) )
+    { return(true); }
+
+    for(DMABuffer *buffer = device->free_first; buffer != NULL; buffer = buffer->next)
+    {
+        if(buffer->index == index)
+        { return(true); }
+    }
+
+    return(false);
+}
+
+
+
+static inline
+void
+PciDevice_waitForFree
+(
+    PciDevice      *device,
+    const uint64_t  index
+)
+{
+    pthread_mutex_lock(&device->free_lock);
+    while(PciDevice_isFreePending(device, index) )
+    { pthread_cond_wait(&device->free_cond, &device->free_lock); }
+    pthread_mutex_unlock(&device->free_lock);
+}
+
+
+
+/** Free all queued buffers and end the reaper thread */
+static inline
+PdaDebugReturnCode
+PciDevice_stopFreeThread(PciDevice *device)
+{
+    pthread_mutex_lock(&device->free_lock);
+    bool running           = device->free_deferred;
+    device->free_deferred  = false;
+    device->free_stop      = true;
+    pthread_cond_broadcast(&device->free_cond);
+    pthread_mutex_unlock(&device->free_lock);
+
+    if(running)
+    { pthread_join(device->free_thread, NULL); }
+
+    pthread_mutex_lock(&device->free_lock);
+    PdaDebugReturnCode ret = device->free_ret;
+    device->free_ret       = PDA_SUCCESS;
+    device->free_stop      = false;
+    pthread_mutex_unlock(&device->free_lock);
+
+    return(ret);
+}
+
+
+
+/** Resolve PDA_BUFFER_INDEX_UNDEFINED to the first of count consecutive indices,
+ *  indices of running allocations are not reused */
+static inline
+uint64_t
+PciDevice_reserveIndices
+(
+    PciDevice      *device,
+    const uint64_t  index,
+    const uint64_t  count
+)
+{
+    pthread_mutex_lock(&device->alloc_lock);
+
+    uint64_t reserved = index;
+    if(index == PDA_BUFFER_INDEX_UNDEFINED)
+    {
+        reserved = DMABuffer_findNewIndex(index, &(device->dma_buffer_list) );
+        if(reserved < device->alloc_next_index)
+        { reserved = device->alloc_next_index; }
+    }
+
+    if( (reserved + count) > device->alloc_next_index )
+    { device->alloc_next_index = reserved + count; }
+
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    /** Resolved indices may still belong to buffers in the queue of the reaper */
+    for(uint64_t i = 0; i < count; i++)
+    { PciDevice_waitForFree(device, reserved + i); }
+
+    return(reserved);
+}
+
+
+
+static inline
+uint64_t
+PciDevice_reserveIndex
+(
+    PciDevice      *device,
+    const uint64_t  index
+)
+{ return( PciDevice_reserveIndices(device, index, 1) ); }
+
+
+
+static void*
+PciDevice_allocThread(void *arg)
+{
+    PciDeviceAllocation *allocation = (PciDeviceAllocation*)arg;
+    PciDevice           *device     = allocation->device;
+
+    /** The buffer is built on a private list and handed over by PciDevice_completeAllocations */
+    DMABuffer *list = NULL;
+    allocation->ret =
+        DMABuffer_new(device, &list, allocation->index, NULL, allocation->size,
+                      PDA_BUFFER_KERNEL, PDA_BUFFER_FLAGS_NONE);
+    allocation->buffer = (allocation->ret == PDA_SUCCESS) ? list : NULL;
+
+    pthread_mutex_lock(&device->alloc_lock);
+
+    PciDeviceAllocation **tail = &(device->alloc_done);
+    while(*tail != NULL)
+    { tail = &( (*tail)->next ); }
+    *tail = allocation;
+
+    uint64_t event = 1;
+    if(write(device->alloc_event_fd, &event, sizeof(uint64_t) ) != sizeof(uint64_t) )
+    { DEBUG_PRINTF(PDADEBUG_ERROR, "Signaling the allocation failed!\n"); }
+
+    device->alloc_pending--;
+    pthread_cond_broadcast(&device->alloc_cond);
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    return(NULL);
+}
+
+
+
+static inline
+PdaDebugReturnCode
+PciDevice_createAllocEventFd(PciDevice *device)
+{
+    if(device->alloc_event_fd == -1)
+    { device->alloc_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); }
+
+    return( (device->alloc_event_fd == -1) ? errno : PDA_SUCCESS );
+}
+
+
+
+/** Wait for running allocations, their buffers are added to the device without callbacks */
+static inline
+void
+PciDevice_drainAllocations(PciDevice *device)
+{
+    pthread_mutex_lock(&device->alloc_lock);
+    while(device->alloc_pending > 0)
+    { pthread_cond_wait(&device->alloc_cond, &device->alloc_lock); }
+
+    while(device->alloc_done != NULL)
+    {
+        PciDeviceAllocation *allocation = device->alloc_done;
+        device->alloc_done = allocation->next;
+
+        if(allocation->buffer != NULL)
+        { DMABuffer_addNode(&(device->dma_buffer_list), allocation->buffer); }
+        free(allocation);
+    }
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    if(device->alloc_event_fd != -1)
+    {
+        close(device->alloc_event_fd);
+        device->alloc_event_fd = -1;
+    }
+
+    pthread_cond_destroy(&device->alloc_cond);
+    pthread_mutex_destroy(&device->alloc_lock);
+}
+
+
+
 /*-external-functions---------------------------------------------------------------------*/
 
 
@@ -439,6 +718,15 @@ PciDevice_delete
             { ret += Bar_delete(device->bar[i]); }
         }
 
+        PciDevice_drainAllocations(device);
+
+        ret += PciDevice_stopFreeThread(device);
+        pthread_cond_destroy(&device->free_cond);
+        pthread_mutex_destroy(&device->free_lock);
+
+        DMABufferCache_delete(device->registration_cache);
+        device->registration_cache = NULL;
+
         ret += DMABuffer_freeAllBuffersInt(device->dma_buffer_list, persistant);
         device->dma_buffer_list = NULL;
         ret += PciDevice_delete_dep(device);
@@ -522,6 +810,22 @@ PciDevice_allocDMABuffer
     const size_t         size,
     DMABuffer          **buffer
 )
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+    RETURN( PciDevice_allocDMABufferFlags(device, index, size, PDA_BUFFER_FLAGS_NONE, buffer) );
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_allocDMABufferFlags
+(
+    PciDevice           *device,
+    const uint64_t       index,
+    const size_t         size,
+    const uint64_t       flags,
+    DMABuffer          **buffer
+)
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
@@ -532,10 +836,11 @@ PciDevice_allocDMABuffer
 
     ret = DMABuffer_new(device,
                         &(device->dma_buffer_list),
-                        index,
+                        PciDevice_reserveIndex(device, index),
                         NULL,
                         size,
-                        PDA_BUFFER_KERNEL);
+                        PDA_BUFFER_KERNEL,
+                        flags);
 
     if(ret != PDA_SUCCESS)
     { ERROR_EXIT( EINVAL, exit, "Buffer allocation failed!\n" ); }
@@ -547,6 +852,171 @@ exit:
 }
 
 
+PdaDebugReturnCode
+PciDevice_allocDMABuffers
+(
+    PciDevice           *device,
+    const uint64_t       count,
+    const size_t        *sizes,
+    DMABuffer          **buffers
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (sizes == NULL) || (buffers == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(count == 0)
+    { RETURN(PDA_SUCCESS); }
+
+    uint64_t first_index = PciDevice_reserveIndices(device, PDA_BUFFER_INDEX_UNDEFINED, count);
+    if(DMABuffer_newBatch(device, &(device->dma_buffer_list), first_index, count, sizes, buffers)
+        != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Batch allocation failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_allocDMABufferAsync
+(
+    PciDevice               *device,
+    const uint64_t           index,
+    const size_t             size,
+    PciDevice_AllocCallback  callback,
+    void                    *ctx
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(size == 0)
+    { RETURN( ERROR(EINVAL, "Invalid length!\n") ); }
+
+    PciDeviceAllocation *allocation = calloc(1, sizeof(PciDeviceAllocation) );
+    if(allocation == NULL)
+    { RETURN( ERROR(ENOMEM, "Memory allocation failed!\n") ); }
+
+    allocation->device   = device;
+    allocation->index    = PciDevice_reserveIndex(device, index);
+    allocation->size     = size;
+    allocation->callback = callback;
+    allocation->ctx      = ctx;
+
+    pthread_mutex_lock(&device->alloc_lock);
+
+    if(PciDevice_createAllocEventFd(device) != PDA_SUCCESS)
+    {
+        pthread_mutex_unlock(&device->alloc_lock);
+        free(allocation);
+        RETURN( ERROR(errno, "Event descriptor creation failed!\n") );
+    }
+
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int ret = pthread_create(&thread, &attr, PciDevice_allocThread, allocation);
+    pthread_attr_destroy(&attr);
+
+    if(ret != 0)
+    {
+        pthread_mutex_unlock(&device->alloc_lock);
+        free(allocation);
+        RETURN( ERROR(ret, "Thread creation failed!\n") );
+    }
+
+    device->alloc_pending++;
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_getAllocEventFd
+(
+    PciDevice *device,
+    int       *fd
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (fd == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    pthread_mutex_lock(&device->alloc_lock);
+    PdaDebugReturnCode ret = PciDevice_createAllocEventFd(device);
+    *fd = device->alloc_event_fd;
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Event descriptor creation failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_completeAllocations
+(
+    PciDevice *device,
+    uint64_t  *completed,
+    uint64_t  *pending
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    pthread_mutex_lock(&device->alloc_lock);
+
+    PciDeviceAllocation *done = device->alloc_done;
+    device->alloc_done = NULL;
+
+    if(device->alloc_event_fd != -1)
+    {
+        uint64_t events = 0;
+        if(read(device->alloc_event_fd, &events, sizeof(uint64_t) ) == -1)
+        { DEBUG_PRINTF(PDADEBUG_CONTROL_FLOW, "No allocation events!\n"); }
+    }
+
+    if(pending != NULL)
+    { *pending = device->alloc_pending; }
+
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    /** Callbacks run without the lock, so that they can start new allocations */
+    uint64_t count = 0;
+    while(done != NULL)
+    {
+        PciDeviceAllocation *allocation = done;
+        done = allocation->next;
+
+        if(allocation->buffer != NULL)
+        { DMABuffer_addNode(&(device->dma_buffer_list), allocation->buffer); }
+
+        if(allocation->callback != NULL)
+        { allocation->callback(device, allocation->buffer, allocation->ret, allocation->ctx); }
+
+        free(allocation);
+        count++;
+    }
+
+    if(completed != NULL)
+    { *completed = count; }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
 PdaDebugReturnCode
 PciDevice_deleteDMABuffer
 (
@@ -562,16 +1032,50 @@ PciDevice_deleteDMABuffer
     if(buffer == NULL)
     { ERROR_EXIT( EINVAL, exit, "Invalid pointer!\n" ); }
 
+    DMABuffer *head = device->dma_buffer_list;
     if(buffer == device->dma_buffer_list)
     {
-        DMABuffer *head = NULL;
         if(DMABuffer_getNext(buffer, &head) != PDA_SUCCESS)
         { ERROR_EXIT( EINVAL, exit, "get_next failed!\n" ); }
+    }
 
+    /** User memory belongs to the caller and has to be unpinned before returning */
+    pthread_mutex_lock(&device->free_lock);
+    if( device->free_deferred &&
+        ( (buffer->type == PDA_BUFFER_KERNEL) || (buffer->type == PDA_BUFFER_LOOKUP) ) )
+    {
+        if(__atomic_load_n(&buffer->references, __ATOMIC_ACQUIRE) > 0)
+        {
+            pthread_mutex_unlock(&device->free_lock);
+            RETURN( ERROR(EBUSY, "Buffer is still referenced by slices!\n") );
+        }
+
+        DMABuffer_removeNode(buffer);
         device->dma_buffer_list = head;
+
+        buffer->prev = NULL;
+        buffer->next = NULL;
+        if(device->free_last != NULL)
+        { device->free_last->next = buffer; }
+        else
+        { device->free_first = buffer; }
+        device->free_last = buffer;
+
+        pthread_cond_broadcast(&device->free_cond);
+        pthread_mutex_unlock(&device->free_lock);
+        RETURN(PDA_SUCCESS);
     }
+    pthread_mutex_unlock(&device->free_lock);
 
-    RETURN(DMABuffer_free(buffer, PDA_DELETE));
+    /** The buffer stays in the list while slices of it exist, DMABuffer_free unlinks it
+     *  in every other case, also if the kernel refuses to free it (e.g. exported) */
+    if(__atomic_load_n(&buffer->references, __ATOMIC_ACQUIRE) > 0)
+    { RETURN( ERROR(EBUSY, "Buffer is still referenced by slices!\n") ); }
+
+    PdaDebugReturnCode ret = DMABuffer_free(buffer, PDA_DELETE);
+
+    device->dma_buffer_list = head;
+    RETURN(ret);
 
 exit:
     RETURN(EINVAL);
@@ -579,6 +1083,66 @@ exit:
 
 
 
+PdaDebugReturnCode
+PciDevice_setDeferredFree
+(
+    PciDevice     *device,
+    const uint8_t  enable
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(!enable)
+    { RETURN( PciDevice_stopFreeThread(device) ); }
+
+    pthread_mutex_lock(&device->free_lock);
+    if(!device->free_deferred)
+    {
+        int ret = pthread_create(&device->free_thread, NULL, PciDevice_freeThread, device);
+        if(ret != 0)
+        {
+            pthread_mutex_unlock(&device->free_lock);
+            RETURN( ERROR(ret, "Thread creation failed!\n") );
+        }
+        device->free_deferred = true;
+    }
+    pthread_mutex_unlock(&device->free_lock);
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_drainFrees
+(
+    PciDevice *device
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    pthread_mutex_lock(&device->free_lock);
+    while( (device->free_first != NULL) || (device->free_active != NULL) )
+    { pthread_cond_wait(&device->free_cond, &device->free_lock); }
+
+    PdaDebugReturnCode ret = device->free_ret;
+    device->free_ret       = PDA_SUCCESS;
+    pthread_mutex_unlock(&device->free_lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Freeing a deferred buffer failed!\n") ); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
 PdaDebugReturnCode
 PciDevice_registerDMABuffer
 (
@@ -601,22 +1165,151 @@ PciDevice_registerDMABuffer
 
     ret = DMABuffer_new(device,
                         &(device->dma_buffer_list),
-                        index,
+                        PciDevice_reserveIndex(device, index),
                         start,
                         size,
-                        PDA_BUFFER_USER);
-
-    ret += PciDevice_getDMABuffer(device, index, buffer);
+                        PDA_BUFFER_USER,
+                        PDA_BUFFER_FLAGS_NONE);
 
     if(ret != PDA_SUCCESS)
     { ERROR_EXIT( EINVAL, exit, "Buffer registration failed!\n" ); }
 
+    *buffer = DMABuffer_getTail(device->dma_buffer_list);
+
+exit:
+    RETURN(ret);
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_registerCachedDMABuffer
+(
+    PciDevice           *device,
+    void                *start,
+    const size_t         size,
+    DMABuffer          **buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (start == NULL) || (buffer == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    pthread_mutex_lock(&device->alloc_lock);
+    PdaDebugReturnCode ret = PDA_SUCCESS;
+    if(device->registration_cache == NULL)
+    { ret = DMABufferCache_new(&(device->registration_cache) ); }
+    pthread_mutex_unlock(&device->alloc_lock);
+
+    if(ret != PDA_SUCCESS)
+    { RETURN( ERROR(ret, "Creating the registration cache failed!\n") ); }
+
+    RETURN( DMABufferCache_register(device->registration_cache, device, start, size, buffer) );
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_releaseCachedDMABuffer
+(
+    PciDevice           *device,
+    DMABuffer           *buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (buffer == NULL) || (device->registration_cache == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    RETURN( DMABufferCache_release(device->registration_cache, buffer) );
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_invalidateRegistrations
+(
+    PciDevice           *device,
+    const void          *start,
+    const size_t         size
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(device->registration_cache == NULL)
+    { RETURN(PDA_SUCCESS); }
+
+    RETURN( DMABufferCache_invalidate(device->registration_cache, start, size) );
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_allocHugeUserDMABuffer
+(
+    PciDevice           *device,
+    const uint64_t       index,
+    const size_t         size,
+    const size_t         page_size,
+    DMABuffer          **buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    PdaDebugReturnCode ret = EFAULT;
+
+    if( (device == NULL) || (buffer == NULL) )
+    { ERROR_EXIT( EINVAL, exit, "Invalid pointer!\n" ); }
+
+    ret = DMABuffer_newHugeUser(device,
+                                &(device->dma_buffer_list),
+                                PciDevice_reserveIndex(device, index),
+                                size,
+                                page_size);
+
+    if(ret != PDA_SUCCESS)
+    { ERROR_EXIT( EINVAL, exit, "Hugepage buffer allocation failed!\n" ); }
+
+    *buffer = DMABuffer_getTail(device->dma_buffer_list);
+
 exit:
     RETURN(ret);
 }
 
 
 
+PdaDebugReturnCode
+PciDevice_importDMABuffer
+(
+    PciDevice           *device,
+    const int            fd,
+    DMABuffer          **buffer
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if( (device == NULL) || (buffer == NULL) )
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    if(DMABuffer_importFd(device, &(device->dma_buffer_list), fd) != PDA_SUCCESS)
+    { RETURN( ERROR(EINVAL, "Buffer import failed!\n") ); }
+
+    *buffer = DMABuffer_getTail(device->dma_buffer_list);
+
+    /** The index is taken now, later allocations must not pick it */
+    uint64_t index = 0;
+    if(DMABuffer_getIndex(*buffer, &index) == PDA_SUCCESS)
+    { PciDevice_reserveIndex(device, index); }
+
+    RETURN(PDA_SUCCESS);
+}
+
+
+
 PdaDebugReturnCode
 PciDevice_freeAllBuffers
 (
@@ -634,6 +1327,22 @@ PciDevice_freeAllBuffers
 
 
 
+PdaDebugReturnCode
+PciDevice_attachDMABuffers
+(
+    PciDevice *device
+)
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+
+    if(device == NULL)
+    { RETURN( ERROR(EINVAL, "Invalid pointer!\n") ); }
+
+    RETURN( DMABuffer_check_persistant(device, &(device->dma_buffer_list) ) );
+}
+
+
+
 PdaDebugReturnCode
 PciDevice_getDMABuffer
 (
@@ -641,6 +1350,21 @@ PciDevice_getDMABuffer
     const uint64_t   index,
     DMABuffer      **buffer
 )
+{
+    DEBUG_PRINTF(PDADEBUG_ENTER, "");
+    RETURN( PciDevice_getDMABufferFlags(device, index, PDA_BUFFER_FLAGS_NONE, buffer) );
+}
+
+
+
+PdaDebugReturnCode
+PciDevice_getDMABufferFlags
+(
+    PciDevice       *device,
+    const uint64_t   index,
+    const uint64_t   flags,
+    DMABuffer      **buffer
+)
 {
     DEBUG_PRINTF(PDADEBUG_ENTER, "");
 
@@ -668,7 +1392,11 @@ PciDevice_getDMABuffer
         }
     }
 
-    ret  = DMABuffer_new(device, &(device->dma_buffer_list), index, 0, 0, PDA_BUFFER_LOOKUP);
+    /** Don't attach to a buffer which is about to be freed */
+    PciDevice_waitForFree(device, index);
+
+    ret  = DMABuffer_new(device, &(device->dma_buffer_list), index, 0, 0,
+                         PDA_BUFFER_LOOKUP, flags);
     if(ret == PDA_SUCCESS)
     { ret += PciDevice_getDMABuffer(device, index, buffer); }
 
@@ -0,0 +1,214 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (512 * 1024 * 1024)
+#define NUMBER_BUFFERS 4
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+typedef struct
+{
+    DMABuffer *buffers[NUMBER_BUFFERS];
+    uint64_t   finished;
+    uint64_t   errors;
+} AllocState;
+
+
+
+void
+allocated
+(
+    PciDevice          *device,
+    DMABuffer          *buffer,
+    PdaDebugReturnCode  ret,
+    void               *ctx
+)
+{
+    AllocState *state = (AllocState*)ctx;
+
+    if( (ret != PDA_SUCCESS) || (buffer == NULL) )
+    {
+        printf("Asynchronous allocation failed!\n");
+        state->errors++;
+    }
+    else
+    { state->buffers[state->finished] = buffer; }
+
+    state->finished++;
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    AllocState state;
+    memset(&state, 0, sizeof(AllocState) );
+
+    int event_fd = -1;
+    if(PDA_SUCCESS != PciDevice_getAllocEventFd(device, &event_fd) )
+    {
+        printf("TEST FAILED (getAllocEventFd)!\n");
+        return -1;
+    }
+
+    /** Starting the allocations must not block */
+    double start = now_s();
+    for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
+    {
+        if(PDA_SUCCESS !=
+            PciDevice_allocDMABufferAsync(device, PDA_BUFFER_INDEX_UNDEFINED,
+                BUFFER_SIZE, allocated, &state) )
+        {
+            printf("TEST FAILED (allocDMABufferAsync)!\n");
+            return -1;
+        }
+    }
+    double started = now_s();
+
+    /** The main loop keeps running while the buffers are built */
+    uint64_t loops   = 0;
+    uint64_t pending = NUMBER_BUFFERS;
+    while(pending > 0)
+    {
+        struct pollfd fds = { .fd = event_fd, .events = POLLIN };
+        if(poll(&fds, 1, 10) > 0)
+        {
+            uint64_t completed = 0;
+            if(PDA_SUCCESS != PciDevice_completeAllocations(device, &completed, &pending) )
+            { state.errors++; }
+        }
+        loops++;
+    }
+    double finished = now_s();
+
+    printf("Starting %d allocations took %8.3f ms, finishing %8.2f ms (%" PRIu64 " loop iterations)\n",
+           NUMBER_BUFFERS, (started - start) * 1e3, (finished - start) * 1e3, loops);
+
+    if(state.finished != NUMBER_BUFFERS)
+    { state.errors++; }
+
+    /** All buffers got different indices and belong to the device */
+    for(uint64_t i = 0; i < state.finished; i++)
+    {
+        uint64_t   index  = 0;
+        DMABuffer *lookup = NULL;
+        if( (state.buffers[i] == NULL) ||
+            (DMABuffer_getIndex(state.buffers[i], &index) != PDA_SUCCESS) ||
+            (PciDevice_getDMABuffer(device, index, &lookup) != PDA_SUCCESS) ||
+            (lookup != state.buffers[i]) )
+        {
+            printf("Buffer %" PRIu64 " is not attached!\n", i);
+            state.errors++;
+            continue;
+        }
+
+        if(PciDevice_deleteDMABuffer(device, state.buffers[i]) != PDA_SUCCESS)
+        { state.errors++; }
+    }
+
+    if(state.errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", state.errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER ASYNC TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
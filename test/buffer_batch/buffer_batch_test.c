@@ -0,0 +1,185 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define NUMBER_BUFFERS 256
+#define BUFFER_SIZE    (64 * 1024)
+
+static inline
+uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec );
+}
+
+
+
+int
+delete_buffers
+(
+    PciDevice  *device,
+    DMABuffer **buffers
+)
+{
+    for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
+    {
+        if(PciDevice_deleteDMABuffer(device, buffers[i]) != PDA_SUCCESS)
+        {
+            printf("TEST FAILED (deleteDMABuffer)!\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    DMABuffer *buffers[NUMBER_BUFFERS];
+    size_t     sizes[NUMBER_BUFFERS];
+    for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
+    { sizes[i] = BUFFER_SIZE * (1 + (i % 4)); }
+
+    /** Reference: one call per buffer */
+    uint64_t start = now_ns();
+    for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
+    {
+        DMABuffer_SGNode *sglist = NULL;
+        if( (PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, sizes[i], &buffers[i])
+                != PDA_SUCCESS) ||
+            (DMABuffer_getSGList(buffers[i], &sglist) != PDA_SUCCESS) )
+        {
+            printf("TEST FAILED (allocDMABuffer)!\n");
+            return -1;
+        }
+    }
+    uint64_t stop = now_ns();
+    printf("single allocation : %.1f us per buffer\n", (double)(stop - start) / NUMBER_BUFFERS / 1000);
+
+    if(delete_buffers(device, buffers) != 0)
+    { return -1; }
+
+    /** Batch allocation */
+    start = now_ns();
+    if(PciDevice_allocDMABuffers(device, NUMBER_BUFFERS, sizes, buffers) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (allocDMABuffers)!\n");
+        return -1;
+    }
+    stop = now_ns();
+    printf("batch allocation  : %.1f us per buffer\n", (double)(stop - start) / NUMBER_BUFFERS / 1000);
+
+    for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
+    {
+        DMABuffer *lookup = NULL;
+        uint64_t   index  = 0;
+        size_t     length = 0;
+        if( (DMABuffer_getIndex(buffers[i], &index) != PDA_SUCCESS) ||
+            (PciDevice_getDMABuffer(device, index, &lookup) != PDA_SUCCESS) ||
+            (lookup != buffers[i]) )
+        {
+            printf("TEST FAILED (lookup %" PRIu64 ")!\n", i);
+            return -1;
+        }
+
+        if( (DMABuffer_getLength(buffers[i], &length) != PDA_SUCCESS) || (length < sizes[i]) )
+        {
+            printf("TEST FAILED (length %" PRIu64 ")!\n", i);
+            return -1;
+        }
+    }
+
+    if(delete_buffers(device, buffers) != 0)
+    { return -1; }
+
+    printf("PDA BUFFER BATCH TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
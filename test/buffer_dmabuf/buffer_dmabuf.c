@@ -0,0 +1,323 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (16 * 1024 * 1024)
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Pass a file descriptor over a UNIX socket */
+int
+send_fd
+(
+    int socket,
+    int fd
+)
+{
+    char           data = 0;
+    struct iovec   io   = { .iov_base = &data, .iov_len = 1 };
+    char           control[CMSG_SPACE(sizeof(int))];
+    struct msghdr  message;
+
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    message.msg_iov        = &io;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level     = SOL_SOCKET;
+    cmsg->cmsg_type      = SCM_RIGHTS;
+    cmsg->cmsg_len       = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return( (sendmsg(socket, &message, 0) == 1) ? 0 : -1 );
+}
+
+
+
+int
+receive_fd
+(
+    int socket
+)
+{
+    char           data = 0;
+    struct iovec   io   = { .iov_base = &data, .iov_len = 1 };
+    char           control[CMSG_SPACE(sizeof(int))];
+    struct msghdr  message;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov        = &io;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    if(recvmsg(socket, &message, 0) != 1)
+    { return(-1); }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    if( (cmsg == NULL) || (cmsg->cmsg_type != SCM_RIGHTS) )
+    { return(-1); }
+
+    int fd = -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return(fd);
+}
+
+
+
+PciDevice*
+get_device
+(
+    DeviceOperator **dop
+)
+{
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    *dop = DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(*dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return(NULL);
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(*dop, &device, 0) )
+    {
+        printf("Can't get device!\n");
+        return(NULL);
+    }
+
+    return(device);
+}
+
+
+
+/** Importing process: attach the buffer, check the data and answer in the second half */
+int
+consumer
+(
+    int socket
+)
+{
+    DeviceOperator *dop    = NULL;
+    PciDevice      *device = get_device(&dop);
+    if(device == NULL)
+    { return(-1); }
+
+    int fd = receive_fd(socket);
+    if(fd < 0)
+    {
+        printf("Receiving the descriptor failed!\n");
+        return(-1);
+    }
+
+    DMABuffer *buffer = NULL;
+    double     start  = now_s();
+    if(PciDevice_importDMABuffer(device, fd, &buffer) != PDA_SUCCESS)
+    {
+        printf("Import failed!\n");
+        return(-1);
+    }
+    double stop = now_s();
+    close(fd);
+
+    printf("Import took %.1f us\n", (stop - start) * 1e6);
+
+    uint64_t  errors = 0;
+    size_t    length = 0;
+    uint32_t *map    = NULL;
+    if( (DMABuffer_getLength(buffer, &length) != PDA_SUCCESS) ||
+        (DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS) ||
+        (length != BUFFER_SIZE) )
+    { errors++; }
+    else
+    {
+        uint64_t words = length / sizeof(uint32_t);
+        for(uint64_t i = 0; i < (words / 2); i++)
+        {
+            if(map[i] != (uint32_t)i)
+            { errors++; }
+            map[(words / 2) + i] = ~(uint32_t)i;
+        }
+    }
+
+    /** The sg-list is still available through the adapter */
+    uint64_t entries = 0;
+    if( (DMABuffer_getSGEntries(buffer, &entries) != PDA_SUCCESS) || (entries == 0) )
+    { errors++; }
+
+    /** Only detaches, the kernel buffer is owned by the exporter */
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    if(DeviceOperator_delete( dop, PDA_DELETE_PERSISTANT ) != PDA_SUCCESS)
+    { errors++; }
+
+    return( (errors == 0) ? 0 : -1 );
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    int sockets[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    {
+        printf("socketpair() failed!\n");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(sockets[0]);
+        exit( (consumer(sockets[1]) == 0) ? EXIT_SUCCESS : EXIT_FAILURE );
+    }
+    close(sockets[1]);
+
+    DeviceOperator *dop    = NULL;
+    PciDevice      *device = get_device(&dop);
+    if(device == NULL)
+    { return -1; }
+
+    DMABuffer *buffer = NULL;
+    if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE, &buffer)
+        != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    uint64_t  errors = 0;
+    uint32_t *map    = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { errors++; }
+
+    uint64_t words = BUFFER_SIZE / sizeof(uint32_t);
+    for(uint64_t i = 0; i < words; i++)
+    { map[i] = (uint32_t)i; }
+
+    int fd = -1;
+    if(DMABuffer_exportFd(buffer, &fd) != PDA_SUCCESS)
+    {
+        printf("Export failed!\n");
+        errors++;
+    }
+    else
+    {
+        if(send_fd(sockets[0], fd) != 0)
+        { errors++; }
+        close(fd);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if( !WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS) )
+    {
+        printf("Consumer failed!\n");
+        errors++;
+    }
+
+    for(uint64_t i = 0; i < (words / 2); i++)
+    {
+        if(map[(words / 2) + i] != ~(uint32_t)i)
+        { errors++; break; }
+    }
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    close(sockets[0]);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER DMABUF TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
@@ -0,0 +1,161 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_COUNT 1024
+#define MAX_OVERHEAD 256
+
+/** Heap bytes held by the bookkeeping of many small buffers, sg-lists excluded */
+void
+check_footprint
+(
+    PciDevice *device,
+    uint64_t  *errors
+)
+{
+    DMABuffer **buffers = calloc(BUFFER_COUNT, sizeof(DMABuffer*) );
+    if(buffers == NULL)
+    { (*errors)++; return; }
+
+    size_t   page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t   sg_bytes  = 0;
+    size_t   before    = mallinfo2().uordblks;
+    uint64_t allocated = 0;
+    for(; allocated < BUFFER_COUNT; allocated++)
+    {
+        if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, page_size,
+            &buffers[allocated]) != PDA_SUCCESS)
+        { (*errors)++; break; }
+
+        DMABuffer_SGNode *sglist = NULL;
+        if(DMABuffer_getSGList(buffers[allocated], &sglist) != PDA_SUCCESS)
+        { (*errors)++; }
+
+        for(DMABuffer_SGNode *sg = sglist; sg != NULL; sg = sg->next)
+        { sg_bytes += sizeof(DMABuffer_SGNode); }
+    }
+    size_t after = mallinfo2().uordblks;
+
+    if(allocated != 0)
+    {
+        size_t overhead = (after - before - sg_bytes) / allocated;
+        printf("%" PRIu64 " buffers, %zu bytes bookkeeping per buffer\n",
+               allocated, overhead);
+
+        if(overhead >= MAX_OVERHEAD)
+        {
+            printf("Per buffer overhead exceeds %d bytes!\n", MAX_OVERHEAD);
+            (*errors)++;
+        }
+    }
+
+    for(uint64_t i = 0; i < allocated; i++)
+    {
+        if(PciDevice_deleteDMABuffer(device, buffers[i]) != PDA_SUCCESS)
+        { (*errors)++; }
+    }
+
+    free(buffers);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t errors = 0;
+    check_footprint(device, &errors);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER FOOTPRINT TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
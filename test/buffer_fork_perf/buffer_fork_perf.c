@@ -0,0 +1,193 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/wait.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (1024 * 1024 * 1024)
+#define ITERATIONS 20
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Average time until fork() returns in the parent, the child exits immediately */
+double
+fork_latency(uint64_t *errors)
+{
+    double total = 0;
+    for(uint64_t i = 0; i < ITERATIONS; i++)
+    {
+        double start = now_s();
+        pid_t  pid   = fork();
+        if(pid == 0)
+        { _exit(0); }
+        total += now_s() - start;
+
+        if( (pid < 0) || (waitpid(pid, NULL, 0) != pid) )
+        { (*errors)++; }
+    }
+
+    return(total / ITERATIONS);
+}
+
+
+
+/** Map a kernel and a registered user buffer, then measure fork() */
+void
+benchmark_fork
+(
+    PciDevice *device,
+    const bool protection,
+    uint64_t  *errors
+)
+{
+    if(PDASetForkProtection(protection) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    DMABuffer *kernel_buffer = NULL;
+    if( (PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+            &kernel_buffer) != PDA_SUCCESS) ||
+        (DMABuffer_wrapMap(kernel_buffer) != PDA_SUCCESS) ||
+        (DMABuffer_populate(kernel_buffer, 0) != PDA_SUCCESS) )
+    { (*errors)++; return; }
+
+    uint8_t *memory = NULL;
+    if(posix_memalign( (void**)&memory, 4096, BUFFER_SIZE) != 0)
+    { (*errors)++; return; }
+    memset(memory, 0, BUFFER_SIZE);
+
+    DMABuffer *user_buffer = NULL;
+    if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, memory, BUFFER_SIZE,
+        &user_buffer) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    double latency = fork_latency(errors);
+
+    /** Pinned pages must still be the ones the device writes to */
+    memory[0] = 1;
+
+    printf("fork with %d MiB mapped, protection %-3s : %10.3f ms\n", 3 * (BUFFER_SIZE >> 20),
+           protection ? "on" : "off", latency * 1e3);
+
+    if(PciDevice_deleteDMABuffer(device, user_buffer) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    if(PciDevice_deleteDMABuffer(device, kernel_buffer) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    free(memory);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t errors = 0;
+    benchmark_fork(device, false, &errors);
+    benchmark_fork(device, true, &errors);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    if(DeviceOperator_delete( dop, PDA_DELETE ) != PDA_SUCCESS)
+    { return -1; }
+
+    printf("PDA BUFFER FORK PERFORMANCE TEST SUCCESSFUL!\n");
+    return 0;
+}
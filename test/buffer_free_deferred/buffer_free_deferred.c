@@ -0,0 +1,179 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (1024 * 1024 * 1024)
+#define BUFFER_COUNT 4
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Allocate and touch some buffers, then measure how long deleting them blocks */
+void
+benchmark_free
+(
+    PciDevice     *device,
+    const uint8_t  deferred,
+    uint64_t      *errors
+)
+{
+    DMABuffer *buffers[BUFFER_COUNT];
+    for(uint64_t i = 0; i < BUFFER_COUNT; i++)
+    {
+        if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+            &buffers[i]) != PDA_SUCCESS)
+        { (*errors)++; return; }
+
+        if(DMABuffer_populate(buffers[i], 0) != PDA_SUCCESS)
+        { (*errors)++; }
+    }
+
+    if(PciDevice_setDeferredFree(device, deferred) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    double start = now_s();
+    for(uint64_t i = 0; i < BUFFER_COUNT; i++)
+    {
+        if(PciDevice_deleteDMABuffer(device, buffers[i]) != PDA_SUCCESS)
+        { (*errors)++; }
+    }
+    double deleted = now_s();
+
+    if(PciDevice_drainFrees(device) != PDA_SUCCESS)
+    { (*errors)++; }
+    double drained = now_s();
+
+    printf("%-8s delete %10.3f ms, until freed %10.3f ms\n",
+           deferred ? "deferred" : "direct",
+           (deleted - start) * 1e3, (drained - start) * 1e3);
+
+    if(PciDevice_setDeferredFree(device, 0) != PDA_SUCCESS)
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t errors = 0;
+    benchmark_free(device, 0, &errors);
+    benchmark_free(device, 1, &errors);
+
+    DMABuffer *buffer = NULL;
+    if( (PciDevice_setDeferredFree(device, 1) != PDA_SUCCESS) ||
+        (PciDevice_allocDMABuffer(device, 7, BUFFER_SIZE, &buffer) != PDA_SUCCESS) ||
+        (PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS) )
+    { errors++; }
+
+    /** The index is reusable right away, the allocation waits for the reaper */
+    if( (PciDevice_allocDMABuffer(device, 7, BUFFER_SIZE, &buffer) != PDA_SUCCESS) ||
+        (PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS) )
+    { errors++; }
+
+    /** Buffers still queued at shutdown are freed when the device is deleted */
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    if(DeviceOperator_delete( dop, PDA_DELETE ) != PDA_SUCCESS)
+    { return -1; }
+
+    printf("PDA BUFFER DEFERRED FREE TEST SUCCESSFUL!\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+size_t
+get_mb
+(
+    char *string
+)
+{
+    uint64_t amount;
+    sscanf(string, "%" PRIu64, &amount);
+
+    printf("MB = %s\n", string);
+    return(1024 * 1024 * amount);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    size_t dma_buffer_size = 64 * 1024 * 1024;
+    if(argc == 2)
+    { dma_buffer_size = get_mb(argv[1]); }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    /** Hugepage buffer allocation */
+    DMABuffer *buffer = NULL;
+    if
+    (
+        PDA_SUCCESS !=
+        PciDevice_allocHugeUserDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED,
+                                         dma_buffer_size, HUGE_PAGE_SIZE, &buffer)
+    )
+    {
+        printf("Hugepage buffer allocation failed (are hugepages reserved?)!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    size_t length = 0;
+    if( (DMABuffer_getLength(buffer, &length) != PDA_SUCCESS) ||
+        ( (length % HUGE_PAGE_SIZE) != 0) || (length < dma_buffer_size) )
+    {
+        printf("TEST FAILED (length)!\n");
+        return -1;
+    }
+
+    /** Every entry has to cover at least one hugepage */
+    uint64_t entries = 0;
+    if(DMABuffer_getSGEntries(buffer, &entries) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (getSGEntries)!\n");
+        return -1;
+    }
+    printf("%zu bytes in %" PRIu64 " sg-entries\n", length, entries);
+
+    if(entries > (length / HUGE_PAGE_SIZE) )
+    {
+        printf("TEST FAILED (sg-list not coalesced)!\n");
+        return -1;
+    }
+
+    void *map = NULL;
+    if(DMABuffer_getMap(buffer, &map) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (getMap)!\n");
+        return -1;
+    }
+    memset(map, 0x5A, length);
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (deleteDMABuffer)!\n");
+        return -1;
+    }
+
+    printf("PDA HUGEPAGE BUFFER TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
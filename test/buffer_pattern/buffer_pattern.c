@@ -0,0 +1,236 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (256 * 1024 * 1024)
+
+static const char *pattern_names[] = { "increment", "lfsr", "constant" };
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Fill and verify the whole buffer, then check that a flipped byte is found */
+void
+check_pattern
+(
+    DMABuffer      *buffer,
+    const uint64_t  pattern,
+    uint64_t       *errors
+)
+{
+    uint64_t mismatch = 0;
+    uint64_t seed     = 0x0123456789ABCDEF;
+
+    double start = now_s();
+    if(DMABuffer_fillPattern(buffer, 0, BUFFER_SIZE, pattern, seed, 0) != PDA_SUCCESS)
+    { (*errors)++; return; }
+    double filled = now_s();
+    if(DMABuffer_verifyPattern(buffer, 0, BUFFER_SIZE, pattern, seed, 0, &mismatch)
+        != PDA_SUCCESS)
+    { (*errors)++; return; }
+    double verified = now_s();
+
+    printf("%-10s fill %6.2f GB/s, verify %6.2f GB/s\n", pattern_names[pattern],
+           ( (double)BUFFER_SIZE / (filled - start) ) / 1e9,
+           ( (double)BUFFER_SIZE / (verified - filled) ) / 1e9);
+
+    if(mismatch != PDA_PATTERN_NO_MISMATCH)
+    { (*errors)++; }
+
+    uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    /** The first of two corrupted bytes has to be reported */
+    const size_t corrupted[2] = { (BUFFER_SIZE / 3) + 5, BUFFER_SIZE - 1 };
+    for(uint8_t i = 0; i < 2; i++)
+    { map[corrupted[i]] ^= 0x01; }
+
+    if( (DMABuffer_verifyPattern(buffer, 0, BUFFER_SIZE, pattern, seed, 0, &mismatch)
+            != PDA_SUCCESS) || (mismatch != corrupted[0]) )
+    { (*errors)++; }
+
+    /** A range over the end of the buffer counts from its own start */
+    const size_t offset = BUFFER_SIZE - 4096 + 3;
+    if( (DMABuffer_fillPattern(buffer, offset, 3 * 4096, pattern, seed, 0) != PDA_SUCCESS) ||
+        (DMABuffer_verifyPattern(buffer, offset, 3 * 4096, pattern, seed, 0, &mismatch)
+            != PDA_SUCCESS) || (mismatch != PDA_PATTERN_NO_MISMATCH) )
+    { (*errors)++; }
+}
+
+
+
+/** Compare clearing with a single memset and check the result */
+void
+check_clear
+(
+    DMABuffer *buffer,
+    uint64_t  *errors
+)
+{
+    uint64_t mismatch = 0;
+    uint8_t *map      = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    double start = now_s();
+    memset(map, 0, BUFFER_SIZE);
+    double cleared = now_s();
+
+    if(DMABuffer_fillPattern(buffer, 0, BUFFER_SIZE, PDA_PATTERN_INCREMENT, 1, 0) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    double parallel = now_s();
+    if(DMABuffer_clear(buffer, 0) != PDA_SUCCESS)
+    { (*errors)++; }
+    double parallel_cleared = now_s();
+
+    printf("clear      memset %6.2f GB/s, DMABuffer_clear %6.2f GB/s\n",
+           ( (double)BUFFER_SIZE / (cleared - start) ) / 1e9,
+           ( (double)BUFFER_SIZE / (parallel_cleared - parallel) ) / 1e9);
+
+    if( (DMABuffer_verifyPattern(buffer, 0, BUFFER_SIZE, PDA_PATTERN_CONSTANT, 0, 0, &mismatch)
+            != PDA_SUCCESS) || (mismatch != PDA_PATTERN_NO_MISMATCH) )
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    DMABuffer *buffer = NULL;
+    if(PciDevice_allocDMABufferFlags(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+        PDA_BUFFER_ZERO, &buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    /** The buffer has to come zeroed */
+    uint64_t errors   = 0;
+    uint64_t mismatch = 0;
+    if( (DMABuffer_verifyPattern(buffer, 0, BUFFER_SIZE, PDA_PATTERN_CONSTANT, 0, 0, &mismatch)
+            != PDA_SUCCESS) || (mismatch != PDA_PATTERN_NO_MISMATCH) )
+    { errors++; }
+
+    check_clear(buffer, &errors);
+
+    for(uint64_t pattern = PDA_PATTERN_INCREMENT; pattern <= PDA_PATTERN_CONSTANT; pattern++)
+    { check_pattern(buffer, pattern, &errors); }
+
+    /** The same checks on top of the second mapping */
+    if(DMABuffer_wrapMap(buffer) != PDA_SUCCESS)
+    { errors++; }
+    else
+    { check_pattern(buffer, PDA_PATTERN_LFSR, &errors); }
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER PATTERN TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
@@ -0,0 +1,173 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (256 * 1024 * 1024)
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Allocate a buffer with the given flags and time the first pass over all pages */
+void
+first_pass
+(
+    PciDevice  *device,
+    const char *name,
+    uint64_t    flags,
+    uint64_t   *errors
+)
+{
+    DMABuffer *buffer = NULL;
+    double     start  = now_s();
+    if(PciDevice_allocDMABufferFlags(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+        flags, &buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed (%s)!\n", name);
+        (*errors)++;
+        return;
+    }
+    double allocated = now_s();
+
+    uint64_t buffer_flags  = 0;
+    uint64_t populate_time = 0;
+    if( (DMABuffer_getFlags(buffer, &buffer_flags) != PDA_SUCCESS) ||
+        (DMABuffer_getPopulateTime(buffer, &populate_time) != PDA_SUCCESS) )
+    { (*errors)++; }
+
+    if(buffer_flags != flags)
+    { (*errors)++; }
+
+    if( (flags != PDA_BUFFER_FLAGS_NONE) && (populate_time == 0) )
+    { (*errors)++; }
+
+    volatile uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; }
+    else
+    {
+        long page_size = sysconf(_SC_PAGESIZE);
+        for(size_t offset = 0; offset < BUFFER_SIZE; offset += page_size)
+        { (void)map[offset]; }
+    }
+    double touched = now_s();
+
+    printf("%-18s allocation %8.2f ms (populate %8.2f ms), first pass %8.2f ms\n",
+           name, (allocated - start) * 1e3, (double)populate_time / 1e6,
+           (touched - allocated) * 1e3);
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t errors = 0;
+    first_pass(device, "unpopulated", PDA_BUFFER_FLAGS_NONE, &errors);
+    first_pass(device, "populate", PDA_BUFFER_POPULATE, &errors);
+    first_pass(device, "populate parallel", PDA_BUFFER_POPULATE_PARALLEL, &errors);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER POPULATE TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
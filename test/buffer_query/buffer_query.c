@@ -0,0 +1,234 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (4 * 1024 * 1024)
+#define BUFFER_COUNT 16
+#define MAX_INFOS 1024
+#define POLLS 10000
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Find the metadata of a buffer in a query result */
+const PdaBufferInfo*
+find_info
+(
+    const PdaBufferInfo *infos,
+    const uint64_t       count,
+    const uint64_t       index
+)
+{
+    for(uint64_t i = 0; i < count; i++)
+    {
+        if(infos[i].index == index)
+        { return(&infos[i]); }
+    }
+
+    return(NULL);
+}
+
+
+
+/** Compare polling the buffer list with PciDevice_getListOfBuffers and PciDevice_queryBuffers */
+void
+benchmark_polling
+(
+    PciDevice     *device,
+    PdaBufferInfo *infos,
+    uint64_t      *errors
+)
+{
+    double start = now_s();
+    for(uint64_t i = 0; i < POLLS; i++)
+    {
+        uint64_t *ids = NULL;
+        if(PciDevice_getListOfBuffers(device, &ids) == 0)
+        { (*errors)++; break; }
+    }
+    double listed = now_s();
+
+    uint64_t count      = 0;
+    uint64_t generation = 0;
+    for(uint64_t i = 0; i < POLLS; i++)
+    {
+        if(PciDevice_queryBuffers(device, infos, MAX_INFOS, &count, &generation) != PDA_SUCCESS)
+        { (*errors)++; break; }
+    }
+    double queried = now_s();
+
+    printf("getListOfBuffers %8.3f us, queryBuffers %8.3f us per poll\n",
+           (listed - start) * 1e6 / POLLS, (queried - listed) * 1e6 / POLLS);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t       errors = 0;
+    PdaBufferInfo *infos  = calloc(MAX_INFOS, sizeof(PdaBufferInfo) );
+    if(infos == NULL)
+    {
+        printf("Allocation failed!\n");
+        return -1;
+    }
+
+    DMABuffer *buffers[BUFFER_COUNT];
+    uint64_t   indices[BUFFER_COUNT];
+    for(uint64_t i = 0; i < BUFFER_COUNT; i++)
+    {
+        if( (PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+                &buffers[i]) != PDA_SUCCESS) ||
+            (DMABuffer_getIndex(buffers[i], &indices[i]) != PDA_SUCCESS) )
+        {
+            printf("DMA Buffer allocation failed!\n");
+            return -1;
+        }
+    }
+
+    uint64_t count      = 0;
+    uint64_t generation = 0;
+    if(PciDevice_queryBuffers(device, infos, MAX_INFOS, &count, &generation) != PDA_SUCCESS)
+    { errors++; }
+
+    for(uint64_t i = 0; i < BUFFER_COUNT; i++)
+    {
+        const PdaBufferInfo *info = find_info(infos, count, indices[i]);
+        if( (info == NULL) || (info->size != BUFFER_SIZE) ||
+            (info->sg_entries == 0) || (info->attached == 0) )
+        {
+            printf("Wrong metadata for buffer %" PRIu64 "!\n", indices[i]);
+            errors++;
+        }
+    }
+
+    /** Without changes the result is kept, count must not be touched */
+    uint64_t unchanged = UINT64_MAX;
+    uint64_t previous  = generation;
+    if( (PciDevice_queryBuffers(device, infos, MAX_INFOS, &unchanged, &generation) != PDA_SUCCESS) ||
+        (generation != previous) || ((generation != 0) && (unchanged != UINT64_MAX)) )
+    { errors++; }
+
+    /** Freeing a buffer must show up */
+    if(PciDevice_deleteDMABuffer(device, buffers[0]) != PDA_SUCCESS)
+    { errors++; }
+
+    uint64_t after = 0;
+    if( (PciDevice_queryBuffers(device, infos, MAX_INFOS, &after, &generation) != PDA_SUCCESS) ||
+        (after != (count - 1)) || (find_info(infos, after, indices[0]) != NULL) )
+    {
+        printf("Freed buffer not detected!\n");
+        errors++;
+    }
+
+    benchmark_polling(device, infos, &errors);
+
+    for(uint64_t i = 1; i < BUFFER_COUNT; i++)
+    {
+        if(PciDevice_deleteDMABuffer(device, buffers[i]) != PDA_SUCCESS)
+        { errors++; }
+    }
+
+    free(infos);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER QUERY TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
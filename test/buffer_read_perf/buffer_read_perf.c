@@ -0,0 +1,393 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE   (16 * 1024 * 1024)
+#define CHUNK_SIZE    (64 * 1024)
+#define ROUNDS        16
+
+typedef enum
+{
+    READ_MEMCPY   = 0,
+    READ_PREFETCH = 1,
+    READ_STREAM   = 2
+} read_mode;
+
+static const char *read_mode_names[] = { "memcpy", "prefetch+memcpy", "readStream" };
+
+static const uint64_t map_modes[] =
+    { PDA_BUFFER_MAP_UNCACHED, PDA_BUFFER_MAP_WRITE_COMBINING, PDA_BUFFER_MAP_CACHED };
+static const char *map_mode_names[] = { "uncached", "wc", "cached" };
+
+static const char *checksum_names[] = { "crc32c", "xxh64", "adler32" };
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Read the whole buffer chunk by chunk and return the throughput in GB/s */
+double
+read_buffer
+(
+    DMABuffer *buffer,
+    uint8_t   *dst,
+    read_mode  mode,
+    uint64_t  *errors
+)
+{
+    void *map = NULL;
+    if(DMABuffer_getMap(buffer, &map) != PDA_SUCCESS)
+    { (*errors)++; return(0.0); }
+
+    double start = now_s();
+    for(uint64_t round = 0; round < ROUNDS; round++)
+    {
+        for(size_t offset = 0; offset < BUFFER_SIZE; offset += CHUNK_SIZE)
+        {
+            switch(mode)
+            {
+                case READ_MEMCPY:
+                {
+                    memcpy(dst, (uint8_t*)map + offset, CHUNK_SIZE);
+                }
+                break;
+
+                case READ_PREFETCH:
+                {
+                    /** Prefetch one chunk ahead, the last chunk prefetches over the wrap */
+                    if(DMABuffer_prefetch(buffer, (offset + CHUNK_SIZE) % BUFFER_SIZE,
+                        CHUNK_SIZE) != PDA_SUCCESS)
+                    { (*errors)++; }
+                    memcpy(dst, (uint8_t*)map + offset, CHUNK_SIZE);
+                }
+                break;
+
+                case READ_STREAM:
+                {
+                    if(DMABuffer_readStream(buffer, offset, dst, CHUNK_SIZE) != PDA_SUCCESS)
+                    { (*errors)++; }
+                }
+                break;
+            }
+        }
+    }
+    double stop = now_s();
+
+    return( ( ((double)BUFFER_SIZE * ROUNDS) / (stop - start) ) / 1e9 );
+}
+
+
+
+void
+benchmark
+(
+    const char *name,
+    DMABuffer  *buffer,
+    uint8_t    *dst,
+    uint64_t   *errors
+)
+{
+    for(read_mode mode = READ_MEMCPY; mode <= READ_STREAM; mode++)
+    {
+        printf("%-28s %-16s %6.2f GB/s\n", name, read_mode_names[mode],
+            read_buffer(buffer, dst, mode, errors) );
+    }
+}
+
+
+
+/** Checksum the whole buffer with each algorithm, single threaded and on all CPUs */
+void
+benchmark_checksum
+(
+    const char *name,
+    DMABuffer  *buffer,
+    uint64_t   *errors
+)
+{
+    for(uint64_t algorithm = PDA_CHECKSUM_CRC32C; algorithm <= PDA_CHECKSUM_ADLER32; algorithm++)
+    {
+        uint64_t checksum[2] = { 0, 0 };
+        for(uint64_t i = 0; i < 2; i++)
+        {
+            double start = now_s();
+            for(uint64_t round = 0; round < ROUNDS; round++)
+            {
+                if(DMABuffer_checksum(buffer, 0, BUFFER_SIZE, algorithm, (i == 0) ? 1 : 0,
+                    &checksum[i]) != PDA_SUCCESS)
+                { (*errors)++; }
+            }
+            double stop = now_s();
+
+            printf("%-28s %-16s %6.2f GB/s (%s)\n", name, checksum_names[algorithm],
+                ( ((double)BUFFER_SIZE * ROUNDS) / (stop - start) ) / 1e9,
+                (i == 0) ? "1 thread" : "all CPUs");
+        }
+
+        /** Splitting the range over threads must not change the result */
+        if(checksum[0] != checksum[1])
+        { (*errors)++; }
+    }
+}
+
+
+
+/** Check the CRC32C check value and a checksum over the wrap point */
+void
+check_checksum
+(
+    DMABuffer *buffer,
+    uint64_t  *errors
+)
+{
+    uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    uint64_t checksum = 0;
+    memcpy(map, "123456789", 9);
+    if( (DMABuffer_checksum(buffer, 0, 9, PDA_CHECKSUM_CRC32C, 1, &checksum) != PDA_SUCCESS) ||
+        (checksum != 0xE3069283) )
+    { (*errors)++; }
+
+    /** A wrapped range equals the concatenation of its two parts */
+    uint64_t parts[2] = { 0, 0 };
+    memcpy(map + BUFFER_SIZE - 9, "123456789", 9);
+    memset(map, 0, CHUNK_SIZE);
+    if( (DMABuffer_checksum(buffer, BUFFER_SIZE - 9, 9 + CHUNK_SIZE, PDA_CHECKSUM_ADLER32, 1,
+            &parts[0]) != PDA_SUCCESS) ||
+        (DMABuffer_checksum(buffer, BUFFER_SIZE - 9, 9, PDA_CHECKSUM_ADLER32, 1,
+            &parts[1]) != PDA_SUCCESS) )
+    { (*errors)++; return; }
+
+    /** Zero bytes leave the first Adler-32 sum unchanged */
+    if( (parts[0] & 0xFFFF) != (parts[1] & 0xFFFF) )
+    { (*errors)++; }
+}
+
+
+
+/** Check that a read over the wrap point returns the data from the buffer start */
+void
+check_wrap
+(
+    DMABuffer *buffer,
+    uint8_t   *dst,
+    uint64_t  *errors
+)
+{
+    uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    for(size_t i = 0; i < CHUNK_SIZE; i++)
+    {
+        map[i] = (uint8_t)i;
+        map[BUFFER_SIZE - CHUNK_SIZE + i] = (uint8_t)(i ^ 0xff);
+    }
+
+    if(DMABuffer_readStream(buffer, BUFFER_SIZE - (CHUNK_SIZE / 2), dst, CHUNK_SIZE)
+        != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    for(size_t i = 0; i < (CHUNK_SIZE / 2); i++)
+    {
+        if( (dst[i] != (uint8_t)((CHUNK_SIZE / 2 + i) ^ 0xff)) ||
+            (dst[(CHUNK_SIZE / 2) + i] != (uint8_t)i) )
+        { (*errors)++; return; }
+    }
+
+    if(DMABuffer_readStream(buffer, BUFFER_SIZE, dst, 1) == PDA_SUCCESS)
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t  errors = 0;
+    uint8_t  *dst    = NULL;
+    if(posix_memalign( (void**)&dst, 4096, CHUNK_SIZE) != 0)
+    {
+        printf("Destination allocation failed!\n");
+        return -1;
+    }
+
+    /** Kernel buffers are mapped by the adapter with the requested cache attributes */
+    for(uint64_t i = 0; i < 3; i++)
+    {
+        DMABuffer *kernel_buffer = NULL;
+        if(PciDevice_allocDMABufferFlags(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+            map_modes[i], &kernel_buffer) != PDA_SUCCESS)
+        {
+            printf("DMA Buffer allocation failed!\n");
+            if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+            {
+                printf("Device deletion failed!\n");
+                abort();
+            }
+            return -1;
+        }
+
+        uint64_t mode = 0;
+        if( (DMABuffer_getCacheMode(kernel_buffer, &mode) != PDA_SUCCESS) ||
+            (mode != map_modes[i]) )
+        { errors++; }
+
+        char name[64];
+        snprintf(name, sizeof(name), "kernel %s", map_mode_names[i]);
+        benchmark(name, kernel_buffer, dst, &errors);
+        check_wrap(kernel_buffer, dst, &errors);
+
+        if(DMABuffer_wrapMap(kernel_buffer) != PDA_SUCCESS)
+        { errors++; }
+        else
+        {
+            snprintf(name, sizeof(name), "kernel %s (wrap)", map_mode_names[i]);
+            benchmark(name, kernel_buffer, dst, &errors);
+            check_wrap(kernel_buffer, dst, &errors);
+        }
+
+        if(PciDevice_deleteDMABuffer(device, kernel_buffer) != PDA_SUCCESS)
+        { errors++; }
+    }
+
+    /** User buffers live in ordinary cached memory */
+    void *user_memory = NULL;
+    if(posix_memalign(&user_memory, 4096, BUFFER_SIZE) != 0)
+    {
+        printf("User memory allocation failed!\n");
+        return -1;
+    }
+    memset(user_memory, 0, BUFFER_SIZE);
+
+    DMABuffer *user_buffer = NULL;
+    if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, user_memory,
+        BUFFER_SIZE, &user_buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer registration failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    uint64_t mode = 0;
+    if( (DMABuffer_getCacheMode(user_buffer, &mode) != PDA_SUCCESS) ||
+        (mode != PDA_BUFFER_MAP_CACHED) )
+    { errors++; }
+
+    benchmark("user", user_buffer, dst, &errors);
+    check_wrap(user_buffer, dst, &errors);
+    benchmark_checksum("user", user_buffer, &errors);
+    check_checksum(user_buffer, &errors);
+
+    if(PciDevice_deleteDMABuffer(device, user_buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    free(user_memory);
+    free(dst);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER READ PERF TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
@@ -75,6 +75,13 @@ uint64_t timediff_ms(struct timespec start, struct timespec end)
   return elapsed / 1000000;
 }
 
+uint64_t timediff_us(struct timespec start, struct timespec end)
+{
+  uint64_t elapsed = (end.tv_sec - start.tv_sec) * 1000000000;
+  elapsed += (end.tv_nsec - start.tv_nsec);
+  return elapsed / 1000;
+}
+
 
 int
 main
@@ -118,6 +125,17 @@ main
         return -1;
     }
 
+    /** Attach all persistent buffers at once */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(PDA_SUCCESS != PciDevice_attachDMABuffers(device) )
+    {
+        printf("TEST FAILED (attachDMABuffers)!\n");
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Attaching all buffers took %" PRIu64 " ms\n", timediff_ms(start, end));
+
     /** Get a dma buffer */
     DMABuffer *buffer_pointer = NULL;
     for(uint64_t i = 0; i < NUMBER_BUFFERS; i++)
@@ -128,6 +146,18 @@ main
             printf("TEST FAILED (getDMABuffer)!\n");
             return -1;
         }
+
+        /** The sg-list comes from the shared cache, if another process loaded it before */
+        DMABuffer_SGNode *sglist = NULL;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if(PDA_SUCCESS != DMABuffer_getSGList(buffer_pointer, &sglist) )
+        {
+            printf("TEST FAILED (getSGList)!\n");
+            return -1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("Loading the sg-list of buffer %" PRIu64 " took %" PRIu64 " us\n",
+               i, timediff_us(start, end));
     }
 
     printf("PDA BUFFER RECONNECT TEST SUCCESSFUL!\n");
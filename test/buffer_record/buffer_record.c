@@ -0,0 +1,278 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (64 * 1024 * 1024)
+#define CHUNK_SIZE  (4 * 1024 * 1024)
+#define ROUNDS      8
+
+/** Compare the file with the data that was recorded from the buffer */
+void
+verify_file
+(
+    const char    *path,
+    const off_t    file_offset,
+    const uint8_t *map,
+    const size_t   offset,
+    const size_t   length,
+    uint64_t      *errors
+)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    { (*errors)++; return; }
+
+    uint8_t *data = malloc(length);
+    if( (data == NULL) || (pread(fd, data, length, file_offset) != (ssize_t)length) )
+    { (*errors)++; }
+    else
+    {
+        for(size_t i = 0; i < length; i++)
+        {
+            if(data[i] != map[(offset + i) % BUFFER_SIZE])
+            { (*errors)++; break; }
+        }
+    }
+
+    free(data);
+    close(fd);
+}
+
+
+
+/** Stream the buffer chunk by chunk into a file, as a recorder stage would do */
+void
+record
+(
+    const char *name,
+    DMABuffer  *buffer,
+    const char *path,
+    uint64_t   *errors
+)
+{
+    DMARecorder *recorder = NULL;
+    if(DMARecorder_new(buffer, path, 0, 0, &recorder) != PDA_SUCCESS)
+    {
+        printf("Creating the recorder failed!\n");
+        (*errors)++;
+        return;
+    }
+
+    for(size_t offset = 0; offset < ((size_t)BUFFER_SIZE * ROUNDS); offset += CHUNK_SIZE)
+    {
+        /** Only reuse a part of the buffer after it is on disk */
+        uint64_t written = 0;
+        do
+        {
+            if(DMARecorder_getWritten(recorder, &written) != PDA_SUCCESS)
+            { (*errors)++; break; }
+        } while( (offset - written) >= BUFFER_SIZE );
+
+        if(DMARecorder_write(recorder, offset % BUFFER_SIZE, CHUNK_SIZE) != PDA_SUCCESS)
+        { (*errors)++; }
+    }
+
+    if(DMARecorder_flush(recorder) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    DMARecorderStatistics statistics;
+    if(DMARecorder_getStatistics(recorder, &statistics) != PDA_SUCCESS)
+    { (*errors)++; }
+    else
+    {
+        printf("%s : recorded %" PRIu64 " MiB in %" PRIu64 " requests (%" PRIu64 " MiB direct, "
+               "%" PRIu64 " in flight) : %.2f GB/s\n", name, statistics.bytes >> 20,
+               statistics.requests, statistics.direct >> 20, statistics.max_pending,
+               statistics.bandwidth / 1e9);
+
+        if(statistics.bytes != ((uint64_t)BUFFER_SIZE * ROUNDS) )
+        { (*errors)++; }
+    }
+
+    /** A range over the wrap point and an unaligned range at the end of the file */
+    if( (DMARecorder_write(recorder, BUFFER_SIZE - (CHUNK_SIZE / 2), CHUNK_SIZE) != PDA_SUCCESS) ||
+        (DMARecorder_write(recorder, 123, 4567) != PDA_SUCCESS) )
+    { (*errors)++; }
+
+    if(DMARecorder_delete(recorder) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    off_t end = (off_t)BUFFER_SIZE * ROUNDS;
+    verify_file(path, 0, map, 0, CHUNK_SIZE, errors);
+    verify_file(path, end, map, BUFFER_SIZE - (CHUNK_SIZE / 2), CHUNK_SIZE, errors);
+    verify_file(path, end + CHUNK_SIZE, map, 123, 4567, errors);
+
+    unlink(path);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** The file should be placed on the file system under test */
+    const char *path = (argc > 1) ? argv[1] : "buffer_record.bin";
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    DMABuffer *buffer = NULL;
+    if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE, &buffer)
+        != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    uint64_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    {
+        printf("Getting the buffer mapping failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    for(size_t i = 0; i < (BUFFER_SIZE / sizeof(uint64_t)); i++)
+    { map[i] = i; }
+
+    uint64_t errors = 0;
+    record("kernel", buffer, path, &errors);
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    /** User buffers are written with O_DIRECT if the file system supports it */
+    uint64_t *user_memory = NULL;
+    if(posix_memalign( (void**)&user_memory, 4096, BUFFER_SIZE) != 0)
+    {
+        printf("User memory allocation failed!\n");
+        return -1;
+    }
+
+    for(size_t i = 0; i < (BUFFER_SIZE / sizeof(uint64_t)); i++)
+    { user_memory[i] = ~i; }
+
+    DMABuffer *user_buffer = NULL;
+    if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, user_memory,
+        BUFFER_SIZE, &user_buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer registration failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    record("user", user_buffer, path, &errors);
+
+    if(PciDevice_deleteDMABuffer(device, user_buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    free(user_memory);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER RECORD TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
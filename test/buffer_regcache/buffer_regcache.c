@@ -0,0 +1,232 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (64 * 1024 * 1024)
+#define MESSAGE_SIZE (64 * 1024)
+#define ITERATIONS 1000
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Register and release messages at changing offsets, with and without the cache */
+void
+benchmark_registration
+(
+    PciDevice *device,
+    uint8_t   *memory,
+    uint64_t  *errors
+)
+{
+    double start = now_s();
+    for(uint64_t i = 0; i < ITERATIONS; i++)
+    {
+        DMABuffer *buffer = NULL;
+        size_t     offset = (i * MESSAGE_SIZE) % BUFFER_SIZE;
+        if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, memory + offset,
+            MESSAGE_SIZE, &buffer) != PDA_SUCCESS)
+        { (*errors)++; return; }
+
+        if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+        { (*errors)++; return; }
+    }
+    double uncached = (now_s() - start) / ITERATIONS;
+
+    /** The first message registers the whole region, all others are slices of it */
+    DMABuffer *whole = NULL;
+    if(PciDevice_registerCachedDMABuffer(device, memory, BUFFER_SIZE, &whole) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    start = now_s();
+    for(uint64_t i = 0; i < ITERATIONS; i++)
+    {
+        DMABuffer *buffer = NULL;
+        size_t     offset = (i * MESSAGE_SIZE) % BUFFER_SIZE;
+        if(PciDevice_registerCachedDMABuffer(device, memory + offset, MESSAGE_SIZE, &buffer)
+            != PDA_SUCCESS)
+        { (*errors)++; return; }
+
+        void *map = NULL;
+        if( (DMABuffer_getMap(buffer, &map) != PDA_SUCCESS) || (map != memory + offset) )
+        { (*errors)++; }
+
+        if(PciDevice_releaseCachedDMABuffer(device, buffer) != PDA_SUCCESS)
+        { (*errors)++; return; }
+    }
+    double cached = (now_s() - start) / ITERATIONS;
+
+    if(PciDevice_releaseCachedDMABuffer(device, whole) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    printf("register %d KiB: uncached %8.2f us, cached %8.2f us\n", MESSAGE_SIZE / 1024,
+           uncached * 1e6, cached * 1e6);
+}
+
+
+
+/** Invalidated registrations must not be handed out again */
+void
+check_invalidation
+(
+    PciDevice *device,
+    uint8_t   *memory,
+    uint64_t  *errors
+)
+{
+    DMABuffer *first  = NULL;
+    DMABuffer *second = NULL;
+
+    if(PciDevice_registerCachedDMABuffer(device, memory, MESSAGE_SIZE, &first) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    if(PciDevice_invalidateRegistrations(device, memory + MESSAGE_SIZE - 1, 1) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    if(PciDevice_registerCachedDMABuffer(device, memory, MESSAGE_SIZE, &second) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    /** Slices carry the index of the registration they belong to */
+    uint64_t first_index  = 0;
+    uint64_t second_index = 0;
+    if( (DMABuffer_getIndex(first, &first_index) != PDA_SUCCESS) ||
+        (DMABuffer_getIndex(second, &second_index) != PDA_SUCCESS) ||
+        (first_index == second_index) )
+    { (*errors)++; }
+
+    if(PciDevice_releaseCachedDMABuffer(device, first) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    if(PciDevice_releaseCachedDMABuffer(device, second) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    if(PciDevice_invalidateRegistrations(device, memory, BUFFER_SIZE) != PDA_SUCCESS)
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint8_t *memory = NULL;
+    if(posix_memalign( (void**)&memory, 4096, BUFFER_SIZE) != 0)
+    {
+        printf("Memory allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+    memset(memory, 0, BUFFER_SIZE);
+
+    uint64_t errors = 0;
+    benchmark_registration(device, memory, &errors);
+    check_invalidation(device, memory, &errors);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    if(DeviceOperator_delete( dop, PDA_DELETE ) != PDA_SUCCESS)
+    { return -1; }
+
+    free(memory);
+    printf("PDA BUFFER REGISTRATION CACHE TEST SUCCESSFUL!\n");
+    return 0;
+}
@@ -0,0 +1,286 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define BUFFER_SIZE (64 * 1024 * 1024)
+#define CHUNK_SIZE  (1024 * 1024)
+#define ROUNDS      16
+
+typedef struct
+{
+    int            fd;
+    const uint8_t *map;
+    uint64_t       received;
+    uint64_t       errors;
+} receiver_state;
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+/** Drain the connection and spot check the data against the buffer */
+void*
+receiver(void *argument)
+{
+    receiver_state *state = (receiver_state*)argument;
+    uint8_t        *data  = malloc(CHUNK_SIZE);
+    if(data == NULL)
+    {
+        state->errors++;
+        return(NULL);
+    }
+
+    for(;;)
+    {
+        ssize_t received = read(state->fd, data, CHUNK_SIZE);
+        if(received <= 0)
+        { break; }
+
+        for(ssize_t i = 0; i < received; i += 4093)
+        {
+            if(data[i] != state->map[(state->received + i) % BUFFER_SIZE])
+            { state->errors++; }
+        }
+        state->received += received;
+    }
+
+    free(data);
+    return(NULL);
+}
+
+
+
+/** Stream the buffer over a loopback connection */
+void
+send_buffer
+(
+    const char *name,
+    DMABuffer  *buffer,
+    uint64_t   *errors
+)
+{
+    uint8_t *map = NULL;
+    if(DMABuffer_getMap(buffer, (void**)&map) != PDA_SUCCESS)
+    { (*errors)++; return; }
+
+    for(size_t i = 0; i < BUFFER_SIZE; i++)
+    { map[i] = (uint8_t)( (i * 13) + (i >> 12) ); }
+
+    struct sockaddr_in address;
+    socklen_t          address_length = sizeof(address);
+    memset(&address, 0, sizeof(address) );
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int sender   = socket(AF_INET, SOCK_STREAM, 0);
+    if( (listener < 0) || (sender < 0) ||
+        (bind(listener, (struct sockaddr*)&address, address_length) != 0) ||
+        (listen(listener, 1) != 0) ||
+        (getsockname(listener, (struct sockaddr*)&address, &address_length) != 0) ||
+        (connect(sender, (struct sockaddr*)&address, address_length) != 0) )
+    {
+        printf("Setting up the connection failed!\n");
+        (*errors)++;
+        return;
+    }
+
+    receiver_state state = { .fd = accept(listener, NULL, NULL), .map = map };
+    pthread_t      thread;
+    if( (state.fd < 0) || (pthread_create(&thread, NULL, receiver, &state) != 0) )
+    {
+        printf("Starting the receiver failed!\n");
+        (*errors)++;
+        return;
+    }
+
+    double start = now_s();
+    for(uint64_t sent = 0; sent < ((uint64_t)BUFFER_SIZE * ROUNDS); sent += CHUNK_SIZE)
+    {
+        if(DMABuffer_send(buffer, sent % BUFFER_SIZE, CHUNK_SIZE, sender) != PDA_SUCCESS)
+        { (*errors)++; break; }
+    }
+    double stop = now_s();
+
+    uint64_t released = 0;
+    uint64_t copied   = 0;
+    if(DMABuffer_sendReleased(sender, &released, &copied) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    if(DMABuffer_sendClose(sender) != PDA_SUCCESS)
+    { (*errors)++; }
+
+    close(sender);
+    pthread_join(thread, NULL);
+    close(state.fd);
+    close(listener);
+
+    printf("%-8s %6.2f GB/s, %" PRIu64 " MiB released at the end of the sends, "
+           "%" PRIu64 " MiB copied by the kernel\n", name,
+           ( ((double)BUFFER_SIZE * ROUNDS) / (stop - start) ) / 1e9, released >> 20,
+           copied >> 20);
+
+    *errors += state.errors;
+    if(state.received != ((uint64_t)BUFFER_SIZE * ROUNDS) )
+    { (*errors)++; }
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    uint64_t errors = 0;
+
+    /** Kernel buffers are always copied, their mapping can't be pinned */
+    DMABuffer *kernel_buffer = NULL;
+    if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, BUFFER_SIZE,
+        &kernel_buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    send_buffer("kernel", kernel_buffer, &errors);
+
+    if(PciDevice_deleteDMABuffer(device, kernel_buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    /** User buffers are sent with MSG_ZEROCOPY */
+    void *user_memory = NULL;
+    if(posix_memalign(&user_memory, 4096, BUFFER_SIZE) != 0)
+    {
+        printf("User memory allocation failed!\n");
+        return -1;
+    }
+
+    DMABuffer *user_buffer = NULL;
+    if(PciDevice_registerDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, user_memory,
+        BUFFER_SIZE, &user_buffer) != PDA_SUCCESS)
+    {
+        printf("DMA Buffer registration failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    send_buffer("user", user_buffer, &errors);
+
+    if(PciDevice_deleteDMABuffer(device, user_buffer) != PDA_SUCCESS)
+    { errors++; }
+
+    free(user_memory);
+
+    if(errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", errors);
+        return -1;
+    }
+
+    printf("PDA BUFFER SEND TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
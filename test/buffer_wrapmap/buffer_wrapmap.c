@@ -207,6 +207,33 @@ main
     clock_gettime(CLOCK_MONOTONIC, &end);
     printf("Time first wrap map access : %ld\n", timediff_ms(start, end));
 
+    /** Ring view of the second half of the buffer */
+    size_t   half   = dma_buffer_size / 2;
+    uint8_t *window = NULL;
+    if(PDA_SUCCESS != DMABuffer_mapWindows(buffer, 2, half, half, (void*)(&window) ) )
+    {
+        printf("Window mapping failed!\n");
+        ret = -1;
+        goto exit_main;
+    }
+
+    for(uint64_t i = 0; i < dma_buffer_size; i++)
+    {
+        if(window[i] != map[half + (i % half)])
+        {
+            printf("Window mapping is incomplete!\n");
+            ret = -1;
+            goto exit_main;
+        }
+    }
+
+    if(PDA_SUCCESS != DMABuffer_unmapWindows(buffer, window) )
+    {
+        printf("Window unmapping failed!\n");
+        ret = -1;
+        goto exit_main;
+    }
+
     printf("PDA WRAP-MAPPING TEST SUCCESSFUL!\n");
 
 exit_main:
@@ -0,0 +1,21 @@
+#include <linux/io_uring.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+
+int
+main
+(
+    int         argc,
+    const char *argv[]
+)
+{
+    struct io_uring_params params;
+    struct io_uring_sqe    sqe;
+
+    params.features = IORING_FEAT_SINGLE_MMAP;
+    sqe.opcode      = IORING_OP_WRITEV;
+    sqe.user_data   = IORING_OFF_SQ_RING | IORING_OFF_CQ_RING | IORING_OFF_SQES;
+
+    printf("Hello World %d %d %d %u %llu %u!\n", __NR_io_uring_setup, __NR_io_uring_enter,
+           IORING_ENTER_GETEVENTS, params.features, sqe.user_data, params.cq_off.cqes);
+}
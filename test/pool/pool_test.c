@@ -0,0 +1,248 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define POOL_INDEX   0
+#define CHUNK_SIZE   256
+#define CHUNK_ALIGN  512
+#define CHUNK_COUNT  4096
+#define ROUNDS       1000000
+
+static inline
+uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec );
+}
+
+
+
+int
+check_chunk
+(
+    DMABuffer *buffer,
+    DMABuffer *chunk
+)
+{
+    void *buffer_map = NULL;
+    void *chunk_map  = NULL;
+    if( (DMABuffer_getMap(buffer, &buffer_map) != PDA_SUCCESS) ||
+        (DMABuffer_getMap(chunk, &chunk_map) != PDA_SUCCESS) )
+    {
+        printf("TEST FAILED (getMap)!\n");
+        return -1;
+    }
+
+    size_t offset = 0;
+    size_t length = 0;
+    if( (DMABuffer_getOffset(chunk, &offset) != PDA_SUCCESS) ||
+        (DMABuffer_getLength(chunk, &length) != PDA_SUCCESS) )
+    {
+        printf("TEST FAILED (getOffset/getLength)!\n");
+        return -1;
+    }
+
+    if( (length != CHUNK_SIZE) || ( (offset % CHUNK_ALIGN) != 0) ||
+        ( (uint8_t*)chunk_map != ( (uint8_t*)buffer_map + offset) ) )
+    {
+        printf("TEST FAILED (chunk geometry)!\n");
+        return -1;
+    }
+
+    DMABuffer_SGNode *sglist = NULL;
+    if(DMABuffer_getSGList(chunk, &sglist) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (getSGList)!\n");
+        return -1;
+    }
+
+    size_t sg_length = 0;
+    for(DMABuffer_SGNode *sg = sglist; sg != NULL; sg = sg->next)
+    { sg_length += sg->length; }
+
+    if( (sglist == NULL) || (sg_length != CHUNK_SIZE) ||
+        ( (uint8_t*)sglist->u_pointer != (uint8_t*)chunk_map) )
+    {
+        printf("TEST FAILED (chunk sglist)!\n");
+        return -1;
+    }
+
+    memset(chunk_map, 0xAB, length);
+    return 0;
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    /** Pool allocation */
+    DMAPool *pool = NULL;
+    if(DMAPool_new(device, POOL_INDEX, CHUNK_SIZE, CHUNK_ALIGN, CHUNK_COUNT, &pool)
+        != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (DMAPool_new)!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    DMABuffer *buffer = NULL;
+    if(DMAPool_getBuffer(pool, &buffer) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (getBuffer)!\n");
+        return -1;
+    }
+
+    /** Drain the pool completely */
+    DMABuffer **chunks = calloc(CHUNK_COUNT, sizeof(DMABuffer*) );
+    for(uint64_t i = 0; i < CHUNK_COUNT; i++)
+    {
+        if(DMAPool_alloc(pool, &chunks[i]) != PDA_SUCCESS)
+        {
+            printf("TEST FAILED (alloc %" PRIu64 ")!\n", i);
+            return -1;
+        }
+
+        if(check_chunk(buffer, chunks[i]) != 0)
+        { return -1; }
+    }
+
+    DMABuffer *exhausted = NULL;
+    if(DMAPool_alloc(pool, &exhausted) != ENOMEM)
+    {
+        printf("TEST FAILED (pool not exhausted)!\n");
+        return -1;
+    }
+
+    for(uint64_t i = 0; i < CHUNK_COUNT; i++)
+    {
+        if(DMAPool_free(pool, chunks[i]) != PDA_SUCCESS)
+        {
+            printf("TEST FAILED (free %" PRIu64 ")!\n", i);
+            return -1;
+        }
+    }
+
+    /** Foreign buffers must be rejected */
+    if(DMAPool_free(pool, buffer) == PDA_SUCCESS)
+    {
+        printf("TEST FAILED (foreign free)!\n");
+        return -1;
+    }
+
+    /** Measure alloc/free round trips */
+    uint64_t start = now_ns();
+    for(uint64_t i = 0; i < ROUNDS; i++)
+    {
+        DMABuffer *chunk = NULL;
+        if( (DMAPool_alloc(pool, &chunk) != PDA_SUCCESS) ||
+            (DMAPool_free(pool, chunk) != PDA_SUCCESS) )
+        {
+            printf("TEST FAILED (round trip)!\n");
+            return -1;
+        }
+    }
+    uint64_t stop = now_ns();
+    printf("alloc/free round trip : %.1f ns\n", (double)(stop - start) / ROUNDS);
+
+    free(chunks);
+
+    if(DMAPool_delete(pool) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (DMAPool_delete)!\n");
+        return -1;
+    }
+
+    printf("PDA POOL TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
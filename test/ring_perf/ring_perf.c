@@ -0,0 +1,221 @@
+/**
+ * @author Dominic Eschweiler <dominic@eschweiler.at>
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2015, Dominic Eschweiler
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <pda.h>
+
+#define RING_SIZE     (4 * 1024 * 1024)
+#define TOTAL_BYTES   (16ULL * 1024 * 1024 * 1024)
+#define MESSAGE_SIZE  (1536 + 64)
+
+typedef struct
+{
+    DMARing  *ring;
+    uint64_t  errors;
+} ring_test;
+
+static inline
+double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return( (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9) );
+}
+
+
+
+void*
+producer(void *arg)
+{
+    ring_test *test     = (ring_test*)arg;
+    uint64_t   produced = 0;
+    uint64_t   sequence = 0;
+
+    while(produced < TOTAL_BYTES)
+    {
+        void     *data  = NULL;
+        uint64_t  space = 0;
+        if(DMARing_reserve(test->ring, &data, &space) != PDA_SUCCESS)
+        { test->errors++; break; }
+
+        if(space < MESSAGE_SIZE)
+        { continue; }
+
+        /** Messages are written over the wrap point without any special handling */
+        uint64_t messages = space / MESSAGE_SIZE;
+        for(uint64_t i = 0; i < messages; i++)
+        {
+            uint64_t *message = (uint64_t*)( (uint8_t*)data + (i * MESSAGE_SIZE) );
+            message[0] = sequence;
+            message[(MESSAGE_SIZE / sizeof(uint64_t)) - 1] = sequence;
+            sequence++;
+        }
+
+        if(DMARing_commit(test->ring, messages * MESSAGE_SIZE) != PDA_SUCCESS)
+        { test->errors++; break; }
+        produced += messages * MESSAGE_SIZE;
+    }
+
+    return(NULL);
+}
+
+
+
+int
+main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if(PDAInit() != PDA_SUCCESS)
+    {
+        printf("Error while initialization!\n");
+        abort();
+    }
+
+    /** A list of PCI ID to which PDA has to attach */
+    const char *pci_ids[] =
+    {
+        "10dc 01a0", /* CRORC as registered at CERN */
+        NULL         /* Delimiter*/
+    };
+
+    /** The device operator manages all devices with the given IDs. */
+    DeviceOperator *dop =
+        DeviceOperator_new(pci_ids, PDA_ENUMERATE_DEVICES);
+    if(dop == NULL)
+    {
+        printf("Unable to get device-operator!\n");
+        return -1;
+    }
+
+    /** Get a device object for the first found device in the list. */
+    PciDevice *device = NULL;
+    if(PDA_SUCCESS != DeviceOperator_getPciDevice(dop, &device, 0) )
+    {
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device generation totally failed!\n");
+            return -1;
+        }
+        printf("Can't get device!\n");
+        return -1;
+    }
+
+    DMABuffer *buffer = NULL;
+    if(PciDevice_allocDMABuffer(device, PDA_BUFFER_INDEX_UNDEFINED, RING_SIZE, &buffer)
+        != PDA_SUCCESS)
+    {
+        printf("DMA Buffer allocation failed!\n");
+        if(PDA_SUCCESS != DeviceOperator_delete( dop, PDA_DELETE ) )
+        {
+            printf("Device deletion failed!\n");
+            abort();
+        }
+        return -1;
+    }
+
+    ring_test test = { .ring = NULL, .errors = 0 };
+    if(DMARing_new(buffer, &test.ring) != PDA_SUCCESS)
+    {
+        printf("TEST FAILED (DMARing_new)!\n");
+        return -1;
+    }
+
+    pthread_t thread;
+    double    start = now_s();
+    pthread_create(&thread, NULL, producer, &test);
+
+    /** Consumer: check the message sequence */
+    uint64_t consumed = 0;
+    uint64_t sequence = 0;
+    while(consumed < TOTAL_BYTES)
+    {
+        void     *data      = NULL;
+        uint64_t  available = 0;
+        if(DMARing_peek(test.ring, &data, &available) != PDA_SUCCESS)
+        { test.errors++; break; }
+
+        uint64_t messages = available / MESSAGE_SIZE;
+        for(uint64_t i = 0; i < messages; i++)
+        {
+            uint64_t *message = (uint64_t*)( (uint8_t*)data + (i * MESSAGE_SIZE) );
+            if( (message[0] != sequence) ||
+                (message[(MESSAGE_SIZE / sizeof(uint64_t)) - 1] != sequence) )
+            { test.errors++; }
+            sequence++;
+        }
+
+        if(DMARing_consume(test.ring, messages * MESSAGE_SIZE) != PDA_SUCCESS)
+        { test.errors++; break; }
+        consumed += messages * MESSAGE_SIZE;
+    }
+
+    pthread_join(thread, NULL);
+    double stop = now_s();
+
+    printf("%" PRIu64 " messages, %.2f GB/s, %.1f Mmsg/s\n", sequence,
+           ( (double)consumed / (stop - start) ) / 1e9,
+           ( (double)sequence / (stop - start) ) / 1e6);
+
+    if(DMARing_delete(test.ring) != PDA_SUCCESS)
+    { test.errors++; }
+
+    if(PciDevice_deleteDMABuffer(device, buffer) != PDA_SUCCESS)
+    { test.errors++; }
+
+    if(test.errors != 0)
+    {
+        printf("TEST FAILED (%" PRIu64 " errors)!\n", test.errors);
+        return -1;
+    }
+
+    printf("PDA RING PERF TEST SUCCESSFUL!\n");
+    return DeviceOperator_delete( dop, PDA_DELETE );
+}
@@ -68,6 +68,20 @@ get_mb
 
 
 
+int64_t
+slice
+(
+    PciDevice *device,
+    DMABuffer *buffer
+);
+
+int64_t
+descriptors
+(
+    DMABuffer        *buffer,
+    DMABuffer_SGNode *sglist
+);
+
 int64_t
 buffer
 (
@@ -109,8 +123,157 @@ buffer
            calc */
         printf("a %p l %lu\n", sgiterator->d_pointer, sgiterator->length);
         i++;
+
+        /** The address translation has to agree with the list */
+        uint64_t  bus  = 0;
+        void     *virt = NULL;
+        uint8_t  *half = (uint8_t*)sgiterator->u_pointer + (sgiterator->length / 2);
+        if
+        (
+            (DMABuffer_virtToBus(buffer, half, &bus) != PDA_SUCCESS) ||
+            (bus != ((uint64_t)sgiterator->d_pointer + (sgiterator->length / 2)) ) ||
+            (DMABuffer_busToVirt(buffer, bus, &virt) != PDA_SUCCESS) ||
+            (virt != half)
+        )
+        {
+            printf("Address translation failed!\n");
+            return -1;
+        }
+    }
+
+    if(descriptors(buffer, sglist) != PDA_SUCCESS)
+    { return -1; }
+
+    return slice(device, buffer);
+}
+
+
+
+/** Descriptors split at 4 KiB have to cover the sg-list page by page */
+int64_t
+descriptors
+(
+    DMABuffer        *buffer,
+    DMABuffer_SGNode *sglist
+)
+{
+    struct descriptor
+    {
+        uint64_t address;
+        uint32_t length;
+        uint32_t flags;
+    };
+
+    DMABuffer_DescriptorFormat format = PDA_DESCRIPTOR_FORMAT_64;
+    format.last_flags = 0x1;
+
+    uint64_t entries = 0;
+    if(ENOSPC != DMABuffer_buildDescriptors(buffer, &format, NULL, 0, 4096, &entries) )
+    {
+        printf("Descriptor counting failed!\n");
+        return -1;
+    }
+
+    struct descriptor *table = calloc(entries, sizeof(struct descriptor) );
+    if(table == NULL)
+    { return -1; }
+
+    if
+    (
+        PDA_SUCCESS !=
+        DMABuffer_buildDescriptors(buffer, &format, table,
+            entries * sizeof(struct descriptor), 4096, &entries)
+    )
+    {
+        printf("Descriptor building failed!\n");
+        free(table);
+        return -1;
+    }
+
+    uint64_t i = 0;
+    for(DMABuffer_SGNode *sgiterator = sglist; sgiterator != NULL; sgiterator = sgiterator->next)
+    {
+        for(size_t offset = 0; offset < sgiterator->length; offset += 4096, i++)
+        {
+            if( (table[i].address != ((uint64_t)sgiterator->d_pointer + offset) ) ||
+                (table[i].length  > 4096) )
+            {
+                printf("Descriptor %" PRIu64 " is wrong!\n", i);
+                free(table);
+                return -1;
+            }
+        }
+    }
+
+    int64_t ret = ( (i == entries) && (table[entries - 1].flags == 0x1) ) ? PDA_SUCCESS : -1;
+    if(ret != PDA_SUCCESS)
+    { printf("Descriptor table has the wrong size!\n"); }
+
+    free(table);
+    return ret;
+}
+
+
+
+/** A view on the middle of the buffer has to translate like the buffer itself */
+int64_t
+slice
+(
+    PciDevice *device,
+    DMABuffer *buffer
+)
+{
+    size_t length = 0;
+    if(PDA_SUCCESS != DMABuffer_getLength(buffer, &length) )
+    { return -1; }
+
+    size_t     offset = (length / 4) + 100;
+    DMABuffer *view   = NULL;
+    if(PDA_SUCCESS != DMABuffer_slice(buffer, offset, length / 2, &view) )
+    {
+        printf("Slicing failed!\n");
+        return -1;
+    }
+
+    /** The parent can't go away while the view exists */
+    if(PDA_SUCCESS == PciDevice_deleteDMABuffer(device, buffer) )
+    {
+        printf("Buffer with a view was freed!\n");
+        return -1;
     }
 
+    DMABuffer_SGNode *sglist = NULL;
+    if(PDA_SUCCESS != DMABuffer_getSGList(view, &sglist) )
+    {
+        printf("Slice SG-List fetching failed!\n");
+        return -1;
+    }
+
+    size_t covered = 0;
+    for(DMABuffer_SGNode *sgiterator = sglist; sgiterator != NULL; sgiterator = sgiterator->next)
+    {
+        uint64_t bus = 0;
+        if
+        (
+            (DMABuffer_virtToBus(buffer, sgiterator->u_pointer, &bus) != PDA_SUCCESS) ||
+            (bus != (uint64_t)sgiterator->d_pointer)
+        )
+        {
+            printf("Slice translation failed!\n");
+            return -1;
+        }
+        covered += sgiterator->length;
+    }
+
+    if(covered != (length / 2) )
+    {
+        printf("Slice SG-List has the wrong length!\n");
+        return -1;
+    }
+
+    if(PDA_SUCCESS != DMABuffer_release(view) )
+    { return -1; }
+
     return PDA_SUCCESS;
 }
 